@@ -74,6 +74,15 @@ struct frame_buffer{
     size_t size;
 };
 
+/**
+ * gather list entry,same layout as posix struct iovec so it can be
+ * cast for writev/sendmsg on linux,and also builds on windows
+ */
+struct av_iovec{
+    void* iov_base;
+    size_t iov_len;
+};
+
 typedef struct{
     struct audio_fmt fmt;
     struct frame_buffer frame;
@@ -120,6 +120,66 @@ uint8_t	alaw2ulaw(uint8_t alaw);
 */
 uint8_t	ulaw2alaw(uint8_t ulaw);
 
+/*! \brief Decode a span of A-law samples,bitexact with alaw2linear.
+    Use the fastest kernel(avx2/ssse3/neon) of current cpu.
+    \param alaw The A-law samples to decode.
+    \param size The number of samples.
+    \param linear The decoded samples,at least size samples.
+*/
+void alaw_decode(const uint8_t* alaw,size_t size,int16_t* linear);
+
+/*! \brief Encode a span of linear samples to A-law,bitexact with linear2alaw.
+    \param linear The samples to encode.
+    \param size The number of samples.
+    \param alaw The A-law values,at least size bytes.
+*/
+void alaw_encode(const int16_t* linear,size_t size,uint8_t* alaw);
+
+/*! \brief Decode a span of u-law samples,bitexact with ulaw2linear.
+    \param ulaw The u-law samples to decode.
+    \param size The number of samples.
+    \param linear The decoded samples,at least size samples.
+*/
+void ulaw_decode(const uint8_t* ulaw,size_t size,int16_t* linear);
+
+/*! \brief Encode a span of linear samples to u-law,bitexact with linear2ulaw.
+    \param linear The samples to encode.
+    \param size The number of samples.
+    \param ulaw The u-law values,at least size bytes.
+*/
+void ulaw_encode(const int16_t* linear,size_t size,uint8_t* ulaw);
+
+/*! \brief Transcode a span of A-law samples to u-law.
+    \param alaw The A-law samples.
+    \param size The number of samples.
+    \param ulaw The u-law values,may be the same buffer as alaw.
+*/
+void alaw_to_ulaw(const uint8_t* alaw,size_t size,uint8_t* ulaw);
+
+/*! \brief Transcode a span of u-law samples to A-law.
+    \param ulaw The u-law samples.
+    \param size The number of samples.
+    \param alaw The A-law values,may be the same buffer as ulaw.
+*/
+void ulaw_to_alaw(const uint8_t* ulaw,size_t size,uint8_t* alaw);
+
+/*! \brief Transcode A-law samples to u-law in place,for gateways bridging
+    A-law and u-law without decode to linear.
+    \param codes The A-law samples,replaced by u-law values.
+    \param size The number of samples.
+*/
+void alaw_to_ulaw(uint8_t* codes,size_t size);
+
+/*! \brief Transcode u-law samples to A-law in place.
+    \param codes The u-law samples,replaced by A-law values.
+    \param size The number of samples.
+*/
+void ulaw_to_alaw(uint8_t* codes,size_t size);
+
+/*! \brief Name of the kernel span apis use,like "avx2".
+*/
+const char* g711_kernel();
+
 }
 
 #endif //!ZAV_CODEC_G711_H_
\ No newline at end of file
@@ -110,8 +110,11 @@ typedef struct G722State{
   /*! 6 for 48000kbps, 7 for 56000kbps, or 8 for 64000kbps. */
   int bits_per_sample;
 
-  /*! Signal history for the QMF */
-  int x[24];
+  /*! Signal history for the QMF,x[2i] and x[2i + 1] in two rings written twice,
+     padded for simd loads */
+  int16_t qmf_even[32];
+  int16_t qmf_odd[32];
+  int qmf_pos;
 
   struct {
     int s;
@@ -144,8 +147,12 @@ public:
     size_t Decode(const uint8_t* g722_data,size_t len,int16_t* amp);
 
     void Reset(G722BitRateMode bitrate,G722SampleOption option);
+
+    // loop specialized on bitrate,packed and 8k,picked at Reset()
+    typedef size_t (*decode_func)(G722DecoderState* s,const uint8_t* g722_data,size_t len,int16_t* amp);
 private:
     G722DecoderState* decoder_state_;
+    decode_func decode_;
 };
 
 class G722Encoder{
@@ -155,10 +162,64 @@ public:
 
     size_t Encode(const int16_t* amp,size_t len,uint8_t* g722_data);
     void Reset(G722BitRateMode bitrate,G722SampleOption option);
+
+    // loop specialized on bitrate,packed and 8k,picked at Reset()
+    typedef size_t (*encode_func)(G722EncoderState* s,const int16_t* amp,size_t len,uint8_t* g722_data);
 private:
     G722EncoderState* encoder_state_;
+    encode_func encode_;
+};
+
+struct G722BatchState;
+
+/**
+ * @brief decode many channels at once,like all legs of a conference mixer
+ * all channels share bitrate and option,state kept in structure of arrays,
+ * avx2 run 8 channels and neon 4 channels per step,bitexact with one G722Decoder per channel
+ */
+class G722BatchDecoder{
+public:
+    explicit G722BatchDecoder(size_t channels,G722BitRateMode bitrate,G722SampleOption option);
+    ~G722BatchDecoder();
+
+    /**
+     * @brief g722_data[c] has len bytes of channel c,amp[c] receive its pcm
+     * 
+     * @return size_t pcm samples of each channel
+     */
+    size_t Decode(const uint8_t* const* g722_data,size_t len,int16_t* const* amp);
+
+    void Reset(G722BitRateMode bitrate,G722SampleOption option);
+
+    size_t channels() const;
+private:
+    G722BatchState* state_;
+};
+
+class G722BatchEncoder{
+public:
+    explicit G722BatchEncoder(size_t channels,G722BitRateMode bitrate,G722SampleOption option);
+    ~G722BatchEncoder();
+
+    /**
+     * @brief amp[c] has len samples of channel c,g722_data[c] receive its codes
+     * 
+     * @return size_t g722 bytes of each channel
+     */
+    size_t Encode(const int16_t* const* amp,size_t len,uint8_t* const* g722_data);
+
+    void Reset(G722BitRateMode bitrate,G722SampleOption option);
+
+    size_t channels() const;
+private:
+    G722BatchState* state_;
 };
 
+/**
+ * @brief name of the kernel batch codec use,like "avx2"
+ */
+const char* g722_batch_kernel();
+
 };//!namespace zav
 
 #endif //!ZAV_CODEC_G722_H_
\ No newline at end of file
@@ -34,6 +34,9 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <vector>
+#include <functional>
+#include "zav/av.h"
 
 //for nalu data first byte
 #define H265_NALU_TYPE(v) (((uint8_t)(v) >> 1) & 0x3f)// equals (((uint8_t)(v) & 0x7E) >> 1)
@@ -222,31 +225,53 @@ enum NALU_PREFIX_SIZE{
     NALU_LONG_PREFIX = 4,
 };
 
+/**
+ * nalu view of annexb bytes,start point to the prefix and end is the last byte(included)
+ */
 struct h26x_nalu{
     NALU_PREFIX_SIZE prefix;
     const uint8_t* start;
     const uint8_t* end;
+    // first byte of nalu header,type by H264_NALU_TYPE/H265_NALU_TYPE,0 if nalu is empty
+    uint8_t header;
 };
 
 namespace h26x{
     /**
      * some implementation of find annexb nalu start
-     * faster:avx2>memmem>sbm>3byte>seq>memcmp
+     * faster:avx512>avx2>sse42>memmem>sbm>3byte>seq>memcmp
+     * simd kernels only test the 0x01 byte behind a zero pair
+     * simd kernels are always compiled for their arch,only call them
+     * when zcf::cpu::has() report the feature,or use annexb_find_start
     */
     uint8_t* annexb_find_start_memmem(const uint8_t* bytes,size_t sizeBytes);
     uint8_t* annexb_find_start_memcmp(const uint8_t* bytes,size_t sizeBytes);
     uint8_t* annexb_find_start_seq(const uint8_t* bytes,size_t sizeBytes);
     const uint8_t* annexb_find_start_sbm(const uint8_t* bytes,size_t sizeBytes);
     uint8_t* annexb_find_start_3byte(const uint8_t* bytes,size_t sizeBytes);
-#ifdef __AVX2__
+#if defined(__x86_64__)
+    uint8_t* annexb_find_start_sse42(const uint8_t* bytes,size_t sizeBytes);
     uint8_t* annexb_find_start_avx2(const uint8_t* bytes,size_t sizeBytes);
+    uint8_t* annexb_find_start_avx512(const uint8_t* bytes,size_t sizeBytes);
 #endif
 #ifdef __ARM_NEON
     uint8_t* annexb_find_start_neon(const uint8_t* bytes,size_t sizeBytes);
 #endif
 
     /**
-     * default use sbm 
+     * find annexb nalu start with the fastest kernel of current cpu,
+     * cpu features are checked once at first call
+     * x86:avx512>avx2>sse42>sbm,arm:neon>sbm
+    */
+    const uint8_t* annexb_find_start(const uint8_t* bytes,size_t sizeBytes);
+
+    /**
+     * name of the kernel annexb_find_start use,like "avx2"
+    */
+    const char* annexb_find_start_kernel();
+
+    /**
+     * use annexb_find_start(cpu dispatched)
     */
     const uint8_t* annexb_find_next_nalu_start(const uint8_t* bytes,size_t sizeBytes,NALU_PREFIX_SIZE* prefix);
 
@@ -255,18 +280,592 @@ namespace h26x{
      * founded 1,not found 0
     */
     int annexb_find_next_nalu(const uint8_t* bytes,size_t sizeBytes,h26x_nalu* nalu);
+
+    /**
+     * index every nalu of bytes in one pass,each start code is searched once
+     * and also ends the nalu before it
+     * nalus is cleared first,return nalu count
+    */
+    size_t annexb_index_nalus(const uint8_t* bytes,size_t sizeBytes,std::vector<h26x_nalu>& nalus);
+
+    /**
+     * caller supplied array version,fill at most max_nalus
+     * return filled count,when equal to max_nalus there may be more nalus,
+     * index again from nalus[max_nalus - 1].end + 1
+    */
+    size_t annexb_index_nalus(const uint8_t* bytes,size_t sizeBytes,h26x_nalu* nalus,size_t max_nalus);
+
+    /**
+     * multi-threaded annexb_index_nalus for large buffers(recorded files),same nalus.
+     * bytes are split to one chunk per thread,each chunk is scanned with 2 bytes
+     * overlap and keep the start codes beginning in it,so a start code across
+     * chunk edge is found once.
+     * threads 0 use hardware_concurrency,small buffer is indexed in caller thread
+    */
+    size_t parallel_annexb_index(const uint8_t* bytes,size_t sizeBytes,std::vector<h26x_nalu>& nalus,size_t threads = 0);
+
+    /**
+     * remove emulation prevention byte(00 00 03 -> 00 00) of nalu payload,
+     * in place when rbsp == ebsp,rbsp need size bytes
+     * return rbsp size
+    */
+    size_t ebsp_to_rbsp(const uint8_t* ebsp,size_t size,uint8_t* rbsp);
+
+    /**
+     * insert emulation prevention byte(00 00 0x -> 00 00 03 0x,x <= 3),
+     * ebsp can't overlap rbsp and need rbsp_to_ebsp_max_size(size) bytes
+     * return ebsp size
+    */
+    size_t rbsp_to_ebsp(const uint8_t* rbsp,size_t size,uint8_t* ebsp);
+
+    /**
+     * every inserted 0x03 follow two rbsp bytes,and one more for trailing 00 00
+    */
+    inline size_t rbsp_to_ebsp_max_size(size_t size){ return size + size / 2 + 1; }
+
+    /**
+     * c and simd versions,only call simd ones when zcf::cpu::has() report the feature
+    */
+    size_t ebsp_to_rbsp_c(const uint8_t* ebsp,size_t size,uint8_t* rbsp);
+    size_t rbsp_to_ebsp_c(const uint8_t* rbsp,size_t size,uint8_t* ebsp);
+#if defined(__x86_64__)
+    size_t ebsp_to_rbsp_sse42(const uint8_t* ebsp,size_t size,uint8_t* rbsp);
+    size_t rbsp_to_ebsp_sse42(const uint8_t* rbsp,size_t size,uint8_t* ebsp);
+    size_t ebsp_to_rbsp_avx2(const uint8_t* ebsp,size_t size,uint8_t* rbsp);
+    size_t rbsp_to_ebsp_avx2(const uint8_t* rbsp,size_t size,uint8_t* ebsp);
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    size_t ebsp_to_rbsp_neon(const uint8_t* ebsp,size_t size,uint8_t* rbsp);
+    size_t rbsp_to_ebsp_neon(const uint8_t* rbsp,size_t size,uint8_t* ebsp);
+#endif
+
+    /**
+     * incremental annexb splitter for chunked input(rtp/tcp packets)
+     * only new bytes of each chunk are scanned,start codes split across chunks
+     * are found by the trailing zero count kept between push.
+     * a nalu inside one chunk is emitted as a view of the chunk(zero copy),
+     * a nalu across chunks is gathered to an internal buffer once.
+     * the view is only valid in the callback.
+    */
+    class annexb_stream_splitter{
+    public:
+        typedef std::function<void(const h26x_nalu& nalu)> on_nalu_t;
+    public:
+        explicit annexb_stream_splitter(on_nalu_t on_nalu);
+        ~annexb_stream_splitter() = default;
+
+        /**
+         * feed a chunk,every nalu closed by a start code in it is emitted
+        */
+        void push(const uint8_t* bytes,size_t sizeBytes);
+
+        /**
+         * end of stream,emit the last open nalu
+        */
+        void flush();
+
+        /**
+         * drop open nalu and state
+        */
+        void reset();
+
+        /**
+         * bytes of open nalu gathered from previous chunks
+        */
+        size_t pending_size() const { return pending_.size(); }
+    private:
+        void close_nalu(const uint8_t* chunk,const uint8_t* cut,size_t trim);
+        void open_nalu(const uint8_t* start,size_t before_chunk,NALU_PREFIX_SIZE prefix);
+        void emit(const uint8_t* start,const uint8_t* end);
+    private:
+        on_nalu_t on_nalu_;
+        // open nalu bytes before current chunk
+        std::vector<uint8_t> pending_;
+        // open nalu start in current chunk,nullptr if start before it
+        const uint8_t* chunk_start_;
+        NALU_PREFIX_SIZE open_prefix_;
+        bool opened_;
+        // 0x00 count at the end of pushed bytes,at most 3
+        size_t trailing_zeros_;
+    };
+};
+
+/**
+ * sequence parameter set,7.3.2.1.1
+ * width/height are cropped by frame_cropping
+ */
+struct h264_sps{
+    uint8_t profile_idc;
+    // constraint_set0_flag..constraint_set5_flag + reserved_zero_2bits
+    uint8_t constraint_flags;
+    uint8_t level_idc;
+    uint8_t sps_id;
+    uint8_t chroma_format_idc;
+    uint8_t separate_colour_plane_flag;
+    uint8_t bit_depth_luma;
+    uint8_t bit_depth_chroma;
+    uint8_t log2_max_frame_num;
+    uint8_t pic_order_cnt_type;
+    uint8_t log2_max_pic_order_cnt_lsb;
+    uint8_t delta_pic_order_always_zero_flag;
+    uint8_t max_num_ref_frames;
+    uint8_t frame_mbs_only_flag;
+    uint8_t mb_adaptive_frame_field_flag;
+    uint8_t direct_8x8_inference_flag;
+    uint32_t pic_width_in_mbs;
+    uint32_t pic_height_in_map_units;
+    uint32_t crop_left;
+    uint32_t crop_right;
+    uint32_t crop_top;
+    uint32_t crop_bottom;
+    uint32_t width;
+    uint32_t height;
+    // vui,E.1.1
+    uint8_t vui_parameters_present_flag;
+    uint8_t video_full_range_flag;
+    uint8_t colour_primaries;
+    uint8_t transfer_characteristics;
+    uint8_t matrix_coefficients;
+    uint8_t timing_info_present_flag;
+    uint8_t fixed_frame_rate_flag;
+    uint8_t bitstream_restriction_flag;
+    uint16_t sar_width;
+    uint16_t sar_height;
+    uint32_t num_units_in_tick;
+    uint32_t time_scale;
+    uint32_t max_num_reorder_frames;
+    uint32_t max_dec_frame_buffering;
+    // time_scale / (2 * num_units_in_tick),0 if no timing info
+    double fps;
+};
+
+/**
+ * picture parameter set,7.3.2.2
+ */
+struct h264_pps{
+    uint8_t pps_id;
+    uint8_t sps_id;
+    uint8_t entropy_coding_mode_flag;
+    uint8_t bottom_field_pic_order_in_frame_present_flag;
+    uint8_t num_slice_groups;
+    uint8_t slice_group_map_type;
+    uint8_t num_ref_idx_l0_default_active;
+    uint8_t num_ref_idx_l1_default_active;
+    uint8_t weighted_pred_flag;
+    uint8_t weighted_bipred_idc;
+    int8_t pic_init_qp;
+    int8_t pic_init_qs;
+    int8_t chroma_qp_index_offset;
+    int8_t second_chroma_qp_index_offset;
+    uint8_t deblocking_filter_control_present_flag;
+    uint8_t constrained_intra_pred_flag;
+    uint8_t redundant_pic_cnt_present_flag;
+    uint8_t transform_8x8_mode_flag;
+};
+
+#define H264_MAX_SPS_COUNT 32
+#define H264_MAX_PPS_COUNT 256
+
+namespace h26x{
+    /**
+     * nalu bytes from nalu header(after start code) of annexb view
+    */
+    inline const uint8_t* nalu_data(const h26x_nalu& nalu){ return nalu.start + nalu.prefix; }
+    inline size_t nalu_size(const h26x_nalu& nalu){
+        return nalu.end >= nalu.start + nalu.prefix ? (size_t)(nalu.end - nalu.start - nalu.prefix + 1) : 0;
+    }
+
+    /**
+     * nalu size without trailing_zero_8bits,the last byte of rbsp is never zero
+    */
+    inline size_t nalu_size_trimmed(const h26x_nalu& nalu){
+        size_t size = nalu_size(nalu);
+        const uint8_t* data = nalu_data(nalu);
+        while(size && !data[size - 1]){
+            --size;
+        }
+        return size;
+    }
+
+    /**
+     * cached parameter set,ebsp is the nalu bytes from nalu header,
+     * same bytes of the same id are not parsed again
+    */
+    template<typename T>
+    struct param_set_entry{
+        std::vector<uint8_t> ebsp;
+        T param;
+        bool valid = false;
+    };
 };
 
 class h264{
 public:
     static const uint8_t* annexb_skip_unsupported_nalu(const uint8_t* bytes,size_t sizeBytes);
 
+    /**
+     * parse sps/pps nalu,bytes begin with nalu header(after start code),
+     * emulation prevention bytes are removed internally
+     * pps need its sps for chroma_format_idc of scaling list,nullptr as 4:2:0
+     * return false if nalu type mismatch or bitstream is invalid
+    */
+    static bool parse_sps(const uint8_t* nalu,size_t sizeBytes,h264_sps* sps);
+    static bool parse_pps(const uint8_t* nalu,size_t sizeBytes,h264_pps* pps,const h264_sps* sps = nullptr);
+};
 
+/**
+ * per stream sps/pps cache keyed by sps_id/pps_id,
+ * a parameter set repeated before every idr is only compared by bytes
+ */
+class h264_param_cache{
+public:
+    h264_param_cache() = default;
+    ~h264_param_cache() = default;
+
+    /**
+     * parse unless same bytes cached for its id,changed set true when the id is new or replaced
+     * return cached one,nullptr if parse failed
+    */
+    const h264_sps* update_sps(const uint8_t* nalu,size_t sizeBytes,bool* changed = nullptr);
+    const h264_pps* update_pps(const uint8_t* nalu,size_t sizeBytes,bool* changed = nullptr);
+
+    /**
+     * annexb nalu view,others than sps/pps are ignored and return false,
+     * true if sps/pps is valid
+    */
+    bool update(const h26x_nalu& nalu,bool* changed = nullptr);
+
+    const h264_sps* sps(uint32_t sps_id) const;
+    const h264_pps* pps(uint32_t pps_id) const;
+    /**
+     * sps referenced by pps
+    */
+    const h264_sps* sps_of_pps(uint32_t pps_id) const;
+
+    /**
+     * AVCDecoderConfigurationRecord(avcC) of all cached sps/pps,4 bytes nalu length
+     * ISO/IEC 14496-15 5.3.3.1,return false if no sps or pps
+    */
+    bool build_avcc_record(std::vector<uint8_t>& record) const;
+
+    void reset();
+private:
+    h26x::param_set_entry<h264_sps> sps_[H264_MAX_SPS_COUNT];
+    h26x::param_set_entry<h264_pps> pps_[H264_MAX_PPS_COUNT];
+};
+
+#define H265_MAX_SUB_LAYERS 7
+#define H265_MAX_VPS_COUNT 16
+#define H265_MAX_SPS_COUNT 16
+#define H265_MAX_PPS_COUNT 64
+
+/**
+ * profile_tier_level(1,maxNumSubLayersMinus1),7.3.3
+ */
+struct h265_profile_tier_level{
+    uint8_t general_profile_space;
+    uint8_t general_tier_flag;
+    uint8_t general_profile_idc;
+    uint8_t general_level_idc;
+    uint32_t general_profile_compatibility_flags;
+    // general_progressive_source_flag..general_inbld_flag,48 bits
+    uint64_t general_constraint_indicator_flags;
+    uint8_t sub_layer_profile_present_flag[H265_MAX_SUB_LAYERS];
+    uint8_t sub_layer_level_present_flag[H265_MAX_SUB_LAYERS];
+    uint8_t sub_layer_profile_idc[H265_MAX_SUB_LAYERS];
+    uint8_t sub_layer_level_idc[H265_MAX_SUB_LAYERS];
+};
+
+/**
+ * video parameter set,7.3.2.1,hrd parameters are not parsed
+ */
+struct h265_vps{
+    uint8_t vps_id;
+    uint8_t max_layers;
+    uint8_t max_sub_layers;
+    uint8_t temporal_id_nesting_flag;
+    h265_profile_tier_level ptl;
+    // of the highest sub layer
+    uint32_t max_dec_pic_buffering;
+    uint32_t max_num_reorder_pics;
+    uint32_t max_latency_increase;
+    uint8_t timing_info_present_flag;
+    uint32_t num_units_in_tick;
+    uint32_t time_scale;
+};
+
+/**
+ * sequence parameter set,7.3.2.2
+ * width/height are cropped by conformance window,
+ * parse stop after vui timing info
+ */
+struct h265_sps{
+    uint8_t vps_id;
+    uint8_t max_sub_layers;
+    uint8_t temporal_id_nesting_flag;
+    uint8_t sps_id;
+    h265_profile_tier_level ptl;
+    uint8_t chroma_format_idc;
+    uint8_t separate_colour_plane_flag;
+    uint8_t bit_depth_luma;
+    uint8_t bit_depth_chroma;
+    uint8_t log2_max_pic_order_cnt_lsb;
+    uint8_t log2_min_luma_coding_block_size;
+    uint8_t log2_ctb_size;
+    uint8_t num_short_term_ref_pic_sets;
+    uint8_t long_term_ref_pics_present_flag;
+    uint8_t temporal_mvp_enabled_flag;
+    uint8_t conformance_window_flag;
+    uint32_t pic_width_in_luma_samples;
+    uint32_t pic_height_in_luma_samples;
+    uint32_t conf_win_left_offset;
+    uint32_t conf_win_right_offset;
+    uint32_t conf_win_top_offset;
+    uint32_t conf_win_bottom_offset;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pic_width_in_ctbs;
+    uint32_t pic_height_in_ctbs;
+    // of the highest sub layer
+    uint32_t max_dec_pic_buffering;
+    uint32_t max_num_reorder_pics;
+    uint32_t max_latency_increase;
+    // vui,E.2.1
+    uint8_t vui_parameters_present_flag;
+    uint8_t video_full_range_flag;
+    uint8_t colour_primaries;
+    uint8_t transfer_characteristics;
+    uint8_t matrix_coefficients;
+    uint8_t field_seq_flag;
+    uint8_t timing_info_present_flag;
+    uint16_t sar_width;
+    uint16_t sar_height;
+    uint32_t num_units_in_tick;
+    uint32_t time_scale;
+    // time_scale / num_units_in_tick,0 if no timing info
+    double fps;
+};
+
+/**
+ * picture parameter set,7.3.2.3.1,parse stop after tiles
+ */
+struct h265_pps{
+    uint8_t pps_id;
+    uint8_t sps_id;
+    uint8_t dependent_slice_segments_enabled_flag;
+    uint8_t output_flag_present_flag;
+    uint8_t num_extra_slice_header_bits;
+    uint8_t sign_data_hiding_enabled_flag;
+    uint8_t cabac_init_present_flag;
+    uint8_t num_ref_idx_l0_default_active;
+    uint8_t num_ref_idx_l1_default_active;
+    int8_t init_qp;
+    uint8_t constrained_intra_pred_flag;
+    uint8_t transform_skip_enabled_flag;
+    uint8_t cu_qp_delta_enabled_flag;
+    uint8_t diff_cu_qp_delta_depth;
+    int8_t cb_qp_offset;
+    int8_t cr_qp_offset;
+    uint8_t slice_chroma_qp_offsets_present_flag;
+    uint8_t weighted_pred_flag;
+    uint8_t weighted_bipred_flag;
+    uint8_t transquant_bypass_enabled_flag;
+    uint8_t tiles_enabled_flag;
+    uint8_t entropy_coding_sync_enabled_flag;
+    uint8_t num_tile_columns;
+    uint8_t num_tile_rows;
 };
 
 class h265{
 public:
     static const uint8_t* annexb_skip_unsupported_nalu(const uint8_t* bytes,size_t sizeBytes);
+
+    /**
+     * parse vps/sps/pps nalu,bytes begin with 2 bytes nalu header(after start code),
+     * read in place unless there are emulation prevention bytes
+     * return false if nalu type mismatch or bitstream is invalid
+    */
+    static bool parse_vps(const uint8_t* nalu,size_t sizeBytes,h265_vps* vps);
+    static bool parse_sps(const uint8_t* nalu,size_t sizeBytes,h265_sps* sps);
+    static bool parse_pps(const uint8_t* nalu,size_t sizeBytes,h265_pps* pps);
+};
+
+/**
+ * per stream vps/sps/pps cache keyed by id,same as h264_param_cache
+ */
+class h265_param_cache{
+public:
+    h265_param_cache() = default;
+    ~h265_param_cache() = default;
+
+    const h265_vps* update_vps(const uint8_t* nalu,size_t sizeBytes,bool* changed = nullptr);
+    const h265_sps* update_sps(const uint8_t* nalu,size_t sizeBytes,bool* changed = nullptr);
+    const h265_pps* update_pps(const uint8_t* nalu,size_t sizeBytes,bool* changed = nullptr);
+
+    /**
+     * annexb nalu view from annexb_find_next_nalu/annexb_index_nalus,
+     * others than vps/sps/pps are ignored and return false
+    */
+    bool update(const h26x_nalu& nalu,bool* changed = nullptr);
+
+    const h265_vps* vps(uint32_t vps_id) const;
+    const h265_sps* sps(uint32_t sps_id) const;
+    const h265_pps* pps(uint32_t pps_id) const;
+    const h265_sps* sps_of_pps(uint32_t pps_id) const;
+
+    /**
+     * HEVCDecoderConfigurationRecord(hvcC) of all cached vps/sps/pps,4 bytes nalu length
+     * ISO/IEC 14496-15 8.3.3.1,return false if no vps,sps or pps
+    */
+    bool build_hvcc_record(std::vector<uint8_t>& record) const;
+
+    void reset();
+private:
+    h26x::param_set_entry<h265_vps> vps_[H265_MAX_VPS_COUNT];
+    h26x::param_set_entry<h265_sps> sps_[H265_MAX_SPS_COUNT];
+    h26x::param_set_entry<h265_pps> pps_[H265_MAX_PPS_COUNT];
+};
+
+/**
+ * annexb -> avcc/hvcc(4 bytes big endian nalu length) for mp4/flv.
+ * trailing_zero_8bits are not part of nalu and dropped,like rtp_h26x_packetizer.
+ * when every start code is 4 bytes and there are no trailing zeros,it is replaced
+ * by the length in place,otherwise an iovec gather list of length headers and
+ * nalu payloads is built(empty nalus skipped),bytes are not copied either way.
+ * one converter per stream,its buffers are reused between frames.
+ */
+class avcc_converter{
+public:
+    avcc_converter() = default;
+    ~avcc_converter() = default;
+
+    /**
+     * convert annexb bytes,return avcc size,0 if there is no nalu
+     * in_place():data() is avcc,else iov() is the gather list
+    */
+    size_t convert(uint8_t* bytes,size_t sizeBytes);
+
+    bool in_place() const { return in_place_; }
+    /**
+     * avcc of in place convert,from the first nalu
+    */
+    const uint8_t* data() const { return data_; }
+    const std::vector<av_iovec>& iov() const { return iov_; }
+    const std::vector<h26x_nalu>& nalus() const { return nalus_; }
+private:
+    std::vector<h26x_nalu> nalus_;
+    std::vector<av_iovec> iov_;
+    std::vector<uint8_t> lengths_;
+    const uint8_t* data_ = nullptr;
+    bool in_place_ = false;
+};
+
+namespace h26x{
+    /**
+     * avcc/hvcc(length_size 1,2 or 4 bytes nalu length) -> annexb with 4 bytes start code,
+     * annexb need avcc_to_annexb_size() bytes and can't overlap avcc
+     * return annexb size,0 if a length is over the end
+    */
+    size_t avcc_to_annexb(const uint8_t* avcc,size_t sizeBytes,int length_size,uint8_t* annexb);
+
+    /**
+     * annexb size of avcc,0 if a length is over the end
+    */
+    size_t avcc_to_annexb_size(const uint8_t* avcc,size_t sizeBytes,int length_size);
+
+    /**
+     * 4 bytes length only,replace every length by 00 00 00 01
+     * return false if a length is over the end(bytes may be partly replaced)
+    */
+    bool avcc_to_annexb_inplace(uint8_t* avcc,size_t sizeBytes);
+};
+
+/**
+ * slice type of access unit,B > P > I when slices mixed
+ */
+enum H26X_FRAME_TYPE{
+    H26X_FRAME_UNKNOWN = 0,
+    H26X_FRAME_I,
+    H26X_FRAME_P,
+    H26X_FRAME_B,
+};
+
+enum H26X_FRAME_FLAG{
+    // h264 idr,h265 irap(bla/idr/cra)
+    H26X_FRAME_FLAG_KEY = 0x01,
+    // sps/pps(vps) in access unit
+    H26X_FRAME_FLAG_PARAM_SETS = 0x02,
+    // access unit delimiter in access unit
+    H26X_FRAME_FLAG_AUD = 0x04,
+    // nalus are continuous bytes,start..end is the whole access unit
+    H26X_FRAME_FLAG_CONTIGUOUS = 0x08,
+    // some nalus lost(rtp sequence gap)
+    H26X_FRAME_FLAG_INCOMPLETE = 0x10,
+};
+
+/**
+ * access unit(frame) of nalu views,nalus only valid in callback
+ */
+struct h26x_frame{
+    const h26x_nalu* nalus;
+    size_t nalu_count;
+    // start of first nalu,end of last nalu(included)
+    const uint8_t* start;
+    const uint8_t* end;
+    // H26X_FRAME_FLAG
+    uint32_t flags;
+    H26X_FRAME_TYPE type;
+};
+
+/**
+ * group nalus to access unit,7.4.1.2.3(h264) 7.4.2.4.4(h265)
+ * a new access unit begins at aud/parameter set/prefix sei or the first slice
+ * of a picture(first_mb_in_slice == 0,first_slice_segment_in_pic_flag) after vcl nalus.
+ * only a few bytes of slice header are read,parameter sets are parsed once
+ * into the param cache(slice_type of h265 need pps).
+ * nalu bytes are not copied,they must be valid until the frame is emitted.
+ */
+class access_unit_builder{
+public:
+    typedef std::function<void(const h26x_frame& frame)> on_frame_t;
+public:
+    /**
+     * codec AV_CODEC_VIDEO_H264 or AV_CODEC_VIDEO_H265
+    */
+    access_unit_builder(AVCodecID codec,on_frame_t on_frame);
+    ~access_unit_builder() = default;
+
+    /**
+     * nalu view from annexb_find_next_nalu/annexb_index_nalus,
+     * the access unit before is emitted if nalu begin a new one
+    */
+    void push(const h26x_nalu& nalu);
+
+    /**
+     * end of stream,emit the last access unit
+    */
+    void flush();
+
+    /**
+     * drop nalus of current access unit,param cache is kept
+    */
+    void reset();
+
+    const h264_param_cache& h264_params() const { return h264_params_; }
+    const h265_param_cache& h265_params() const { return h265_params_; }
+private:
+    void push_h264(const h26x_nalu& nalu);
+    void push_h265(const h26x_nalu& nalu);
+    void emit();
+private:
+    AVCodecID codec_;
+    on_frame_t on_frame_;
+    std::vector<h26x_nalu> nalus_;
+    uint32_t flags_;
+    H26X_FRAME_TYPE type_;
+    bool has_vcl_;
+    h264_param_cache h264_params_;
+    h265_param_cache h265_params_;
 };
 
 struct h266{
@@ -0,0 +1,114 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+#ifndef ZAV_CODEC_H26X_READER_H_
+#define ZAV_CODEC_H26X_READER_H_
+
+#include <string>
+#include <zpkg/utility.h>
+#include "zav/codec/h26x.h"
+
+namespace zav{
+
+/**
+ * key access unit(idr/irap) of elementary stream file
+ */
+struct h26x_keyframe{
+    // file offset of access unit
+    uint64_t offset;
+    uint64_t size;
+    // decode order frame number
+    uint64_t frame_index;
+    // frame_index / fps,raw stream has no timestamp
+    int64_t timestamp_us;
+};
+
+/**
+ * mmap reader of raw .h264/.h265 file with keyframe index.
+ * the index is built once(windowed parallel_annexb_index + access_unit_builder)
+ * and saved to sidecar <file>.zidx,it is loaded next time when the file size
+ * and mtime match.seek return a view of the mapped file,nothing is read again.
+ */
+class h26x_file_reader{
+public:
+    h26x_file_reader();
+    ~h26x_file_reader();
+    Z_DISABLE_COPY_MOVE(h26x_file_reader);
+
+    /**
+     * map file,codec AV_CODEC_UNKNOWN detect by the first nalus
+     * fps 0 use vui timing of sps,25 if no timing
+    */
+    bool open(const std::string& path,AVCodecID codec = AV_CODEC_UNKNOWN,double fps = 0);
+    void close();
+
+    /**
+     * load sidecar index or build(and save) it
+    */
+    bool load_index();
+    bool build_index();
+    bool save_index() const;
+    std::string index_path() const { return path_ + ".zidx"; }
+
+    /**
+     * last keyframe at or before timestamp_us,nullptr if no keyframe
+    */
+    const h26x_keyframe* seek(int64_t timestamp_us) const;
+
+    /**
+     * bytes from the keyframe to end of file,prefetched by madvise
+    */
+    const uint8_t* keyframe_data(const h26x_keyframe& keyframe) const;
+
+    const std::vector<h26x_keyframe>& keyframes() const { return keyframes_; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    AVCodecID codec() const { return codec_; }
+    double fps() const { return fps_; }
+    uint64_t frame_count() const { return frame_count_; }
+private:
+    AVCodecID detect_codec() const;
+private:
+    std::string path_;
+    int fd_;
+    uint8_t* data_;
+    size_t size_;
+    size_t map_size_;
+    int64_t mtime_;
+    AVCodecID codec_;
+    double fps_;
+    uint64_t frame_count_;
+    std::vector<h26x_keyframe> keyframes_;
+};
+
+};//!namespace zav
+
+#endif //!ZAV_CODEC_H26X_READER_H_
@@ -0,0 +1,91 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+#ifndef ZAV_PROTO_RTP_H_
+#define ZAV_PROTO_RTP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace zav{
+
+#define RTP_VERSION 2
+#define RTP_HEADER_SIZE 12
+#define RTP_MAX_CSRC 15
+
+/**
+ * fixed header of rtp,RFC 3550 5.1
+ */
+struct rtp_header{
+    uint8_t version;
+    uint8_t padding;
+    uint8_t extension;
+    uint8_t csrc_count;
+    uint8_t marker;
+    uint8_t payload_type;
+    uint16_t seq;
+    uint32_t timestamp;
+    uint32_t ssrc;
+};
+
+/**
+ * rtp packet view,payload exclude csrc,extension and padding
+ */
+struct rtp_packet{
+    rtp_header header;
+    const uint8_t* payload;
+    size_t payload_size;
+};
+
+/**
+ * parse rtp packet in place,return false if invalid
+ */
+bool rtp_parse(const uint8_t* bytes,size_t sizeBytes,rtp_packet* packet);
+
+/**
+ * write 12 bytes fixed header(no csrc/extension),return RTP_HEADER_SIZE
+ */
+size_t rtp_write_header(uint8_t* out,const rtp_header& header);
+
+/**
+ * wrap safe sequence distance a - b,RFC 3550 A.1
+ */
+inline int16_t rtp_seq_diff(uint16_t a,uint16_t b){
+    return (int16_t)(uint16_t)(a - b);
+}
+
+inline bool rtp_seq_before(uint16_t a,uint16_t b){
+    return rtp_seq_diff(a,b) < 0;
+}
+
+};//!namespace zav
+
+#endif //!ZAV_PROTO_RTP_H_
@@ -0,0 +1,205 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+#ifndef ZAV_PROTO_RTP_H26X_H_
+#define ZAV_PROTO_RTP_H26X_H_
+
+#include <vector>
+#include <functional>
+#include <zpkg/utility.h>
+#include "zav/proto/rtp.h"
+#include "zav/proto/rtp_jitter.h"
+#include "zav/codec/h26x.h"
+
+namespace zav{
+
+// RFC 6184 5.2 aggregation and fragmentation units of h264
+#define RTP_H264_STAP_A 24
+#define RTP_H264_FU_A 28
+// RFC 7798 4.4 aggregation and fragmentation units of h265
+#define RTP_H265_AP 48
+#define RTP_H265_FU 49
+
+/**
+ * h264(RFC 6184)/h265(RFC 7798) rtp depacketizer.
+ * single nalu,STAP-A/AP and FU-A/FU are written once to a pooled annexb frame buffer
+ * (fragments are appended without a staging buffer),frame nalus are views of it
+ * and grouped by access_unit_builder,a frame is emitted at marker bit or rtp timestamp change.
+ * packets of input() bytes are reordered by an internal rtp_jitter_buffer of
+ * reorder_window slots,poll() releases them when no more packet comes.
+ * packets popped from a rtp_jitter_buffer(udp) are already in order,input them as
+ * rtp_packet so they are not copied and held again.
+ * all buffers are allocated in constructor,no allocation per packet.
+ * interleaved mode(STAP-B/MTAP/DONL) is not supported.
+ */
+class rtp_h26x_depacketizer{
+public:
+    typedef std::function<void(const h26x_frame& frame,uint32_t timestamp)> on_frame_t;
+public:
+    /**
+     * codec AV_CODEC_VIDEO_H264 or AV_CODEC_VIDEO_H265
+     * reorder_window packets(power of 2),each at most max_packet_size bytes,larger one is lost
+     * frame larger than max_frame_size is dropped
+     * missing packet is waited for at most max_delay_ms,see rtp_jitter_buffer
+    */
+    rtp_h26x_depacketizer(AVCodecID codec,on_frame_t on_frame,size_t reorder_window = 32,
+        size_t max_packet_size = 1500,size_t max_frame_size = 4 * 1024 * 1024,uint32_t max_delay_ms = 100);
+    ~rtp_h26x_depacketizer() = default;
+    Z_DISABLE_COPY_MOVE(rtp_h26x_depacketizer);
+
+    /**
+     * input one rtp packet arrived at now_ms,bytes are only used during the call
+    */
+    void input(const uint8_t* packet,size_t sizeBytes,uint64_t now_ms);
+
+    /**
+     * input one in order rtp packet(popped from rtp_jitter_buffer),not reordered,
+     * a sequence gap is lost,late packet is dropped
+    */
+    void input(const rtp_packet& packet);
+
+    /**
+     * give up missing packets waited for max_delay_ms,call periodically
+     * when input may stop(end of stream,burst loss)
+    */
+    void poll(uint64_t now_ms);
+
+    /**
+     * give up missing packets,emit buffered packets and frame
+    */
+    void flush();
+
+    void reset();
+
+    const access_unit_builder& builder() const { return builder_; }
+    uint64_t lost_packets() const { return lost_packets_; }
+private:
+    void process(const rtp_packet& packet);
+    void process_h264(const uint8_t* payload,size_t size);
+    void process_h265(const uint8_t* payload,size_t size);
+    void process_aggregate(const uint8_t* payload,size_t size);
+    void process_fragment(const uint8_t* header,size_t header_size,bool start,bool end,
+        const uint8_t* payload,size_t size);
+    bool append_nalu(const uint8_t* nalu,size_t size);
+    bool append_bytes(const uint8_t* bytes,size_t size);
+    void push_nalu(size_t offset);
+    void mark_lost(size_t count);
+    void emit_frame();
+private:
+    AVCodecID codec_;
+    on_frame_t on_frame_;
+    access_unit_builder builder_;
+    // reorder of input() bytes
+    rtp_jitter_buffer reorder_;
+    uint32_t reorder_ssrc_;
+    bool reorder_started_;
+    uint16_t next_seq_;
+    uint32_t ssrc_;
+    bool started_;
+    // sequence gap before current packet
+    bool gap_;
+    // annexb frame buffer,never reallocate
+    std::vector<uint8_t> frame_;
+    size_t frame_size_;
+    size_t fu_offset_;
+    bool fu_open_;
+    bool frame_lost_;
+    bool frame_overflow_;
+    uint32_t timestamp_;
+    uint64_t lost_packets_;
+};
+
+/**
+ * rtp packet as gather list,iov[0] is rtp header with payload header(FU/STAP-A/AP),
+ * the other iov are slices of input frame or aggregation sizes,ready for sendmsg/sendmmsg
+ * (av_iovec is laid out as struct iovec)
+ */
+struct rtp_iov_packet{
+    const av_iovec* iov;
+    size_t iov_count;
+    size_t size;
+};
+
+/**
+ * h264(RFC 6184)/h265(RFC 7798) rtp packetizer of non-interleaved mode.
+ * nalu larger than mtu is split to FU-A/FU,consecutive small nalus(sps/pps/sei...)
+ * are aggregated to STAP-A/AP,payload bytes are never copied,
+ * packets point to the input frame and are valid until next packetize().
+ * buffers grow to the largest frame and are reused.
+ */
+class rtp_h26x_packetizer{
+public:
+    /**
+     * codec AV_CODEC_VIDEO_H264 or AV_CODEC_VIDEO_H265
+     * mtu max rtp packet bytes,include 12 bytes rtp header
+    */
+    rtp_h26x_packetizer(AVCodecID codec,uint8_t payload_type,uint32_t ssrc,
+        size_t mtu = 1400,uint16_t seq = 0);
+    ~rtp_h26x_packetizer() = default;
+    Z_DISABLE_COPY_MOVE(rtp_h26x_packetizer);
+
+    /**
+     * packetize one annexb access unit,marker bit is set on the last packet
+     * return packet count
+    */
+    size_t packetize(const uint8_t* frame,size_t sizeBytes,uint32_t timestamp);
+
+    /**
+     * nalus from annexb_index_nalus or h26x_frame of access_unit_builder
+    */
+    size_t packetize(const h26x_nalu* nalus,size_t nalu_count,uint32_t timestamp);
+
+    const std::vector<rtp_iov_packet>& packets() const { return packets_; }
+    uint16_t seq() const { return seq_; }
+private:
+    size_t aggregate_count(const h26x_nalu* nalus,size_t nalu_count) const;
+    uint8_t* begin_packet(size_t header_size,uint32_t timestamp);
+    void add_iov(const void* base,size_t size);
+    void end_packet(bool marker);
+private:
+    AVCodecID codec_;
+    uint8_t payload_type_;
+    uint32_t ssrc_;
+    size_t mtu_;
+    uint16_t seq_;
+    std::vector<h26x_nalu> nalus_;
+    // rtp header,payload header and aggregation sizes
+    std::vector<uint8_t> headers_;
+    std::vector<av_iovec> iov_;
+    std::vector<rtp_iov_packet> packets_;
+    size_t header_used_;
+    size_t iov_used_;
+    size_t packet_iov_;
+};
+
+};//!namespace zav
+
+#endif //!ZAV_PROTO_RTP_H26X_H_
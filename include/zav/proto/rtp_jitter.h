@@ -0,0 +1,150 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+#ifndef ZAV_PROTO_RTP_JITTER_H_
+#define ZAV_PROTO_RTP_JITTER_H_
+
+#include <vector>
+#include "zav/proto/rtp.h"
+
+namespace zav{
+
+#define RTP_JITTER_INVALID_BUFFER 0xFFFFFFFF
+// buffers held out of ring:one being received and popped ones
+#define RTP_JITTER_SPARE_BUFFERS 4
+
+/**
+ * in order packet of rtp_jitter_buffer,bytes are in the pooled buffer
+ * until release()
+ */
+struct rtp_jitter_packet{
+    rtp_packet rtp;
+    const uint8_t* data;
+    size_t size;
+    uint64_t arrival_ms;
+    uint32_t buffer;
+};
+
+/**
+ * reorder/jitter buffer of one rtp stream over udp.
+ * slots is a power of 2 ring indexed by seq & mask,packets are received directly
+ * into pooled buffers(acquire/insert) and handed out in order(pop/release)
+ * by buffer index,bytes are never copied.
+ * a gap is waited for at most max_delay_ms since the packet after it arrived,
+ * the first packet is also held max_delay_ms for packets reordered before it,
+ * nothing is waited for when the ring is full,so pop() after every insert() never
+ * loses a received packet.
+ * memory is capped by memory_budget((slots + RTP_JITTER_SPARE_BUFFERS) * max_packet_size)
+ * unless it is less than the 2 slots minimum.
+ */
+class rtp_jitter_buffer{
+public:
+    /**
+     * slots = largest power of 2 of memory_budget / max_packet_size - 4,at least 2
+    */
+    rtp_jitter_buffer(size_t memory_budget = 1024 * 1024,size_t max_packet_size = 1500,
+        uint32_t max_delay_ms = 200);
+    ~rtp_jitter_buffer() = default;
+
+    /**
+     * buffer to receive next packet,nullptr if every buffer is held by popped packets
+    */
+    uint8_t* acquire(size_t* capacity);
+
+    /**
+     * insert received packet of acquired buffer,O(1)
+     * return false if invalid,late or duplicate(buffer is reused by next acquire)
+    */
+    bool insert(size_t sizeBytes,uint64_t now_ms);
+
+    /**
+     * next packet in sequence order,false if empty or waiting a missing packet
+    */
+    bool pop(uint64_t now_ms,rtp_jitter_packet* packet);
+    void release(const rtp_jitter_packet& packet);
+
+    /**
+     * missing sequences before the highest received one,a sequence is requested
+     * when it is missing for retry_ms(not only reordered),then every retry_ms
+     * and at most max_retries times
+     * return count written to seqs(ascending)
+    */
+    size_t nacks(uint64_t now_ms,uint16_t* seqs,size_t max_count,uint32_t retry_ms = 50,uint32_t max_retries = 3);
+
+    void reset();
+
+    size_t slots() const { return slots_.size(); }
+    size_t buffered() const { return buffered_; }
+    uint64_t lost() const { return lost_; }
+    uint64_t late() const { return late_; }
+    uint64_t duplicated() const { return duplicated_; }
+private:
+    void skip_to(uint16_t seq);
+    // next insert ahead of the ring would push buffered packets out
+    bool full() const { return rtp_seq_diff(highest_seq_,next_seq_) >= (int)mask_; }
+    uint8_t* buffer_data(uint32_t buffer) { return pool_.data() + (size_t)buffer * max_packet_size_; }
+private:
+    struct slot{
+        uint32_t buffer;
+        uint16_t seq;
+        uint16_t nack_count;
+        size_t size;
+        uint64_t arrival_ms;
+        uint64_t nack_ms;
+    };
+    std::vector<uint8_t> pool_;
+    std::vector<uint32_t> free_;
+    std::vector<slot> slots_;
+    size_t mask_;
+    size_t max_packet_size_;
+    uint32_t max_delay_ms_;
+    uint32_t staging_;
+    size_t buffered_;
+    uint16_t next_seq_;
+    uint16_t highest_seq_;
+    bool started_;
+    // first packet popped,before it late packets move the head back
+    bool synced_;
+    uint64_t first_arrival_ms_;
+    uint64_t lost_;
+    uint64_t late_;
+    uint64_t duplicated_;
+};
+
+/**
+ * rtcp generic nack fci(RFC 4585 6.2.1),PID + BLP of ascending seqs
+ * out need 4 bytes per seq at most,return bytes written
+ */
+size_t rtcp_nack_fci(const uint16_t* seqs,size_t count,uint8_t* out);
+
+};//!namespace zav
+
+#endif //!ZAV_PROTO_RTP_JITTER_H_
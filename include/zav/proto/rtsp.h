@@ -34,6 +34,10 @@
 #define ZAV_PROTO_RTSP_H_
 
 #include <string>
+#include <vector>
+#include <functional>
+#include <stdint.h>
+#include <stddef.h>
 
 namespace zav{
     
@@ -49,6 +53,242 @@ enum RTSP_TRANSPORT{
 RTSP_TRANSPORT rtsp_transport(const std::string& description);
 std::string desc_rtsp_transport(RTSP_TRANSPORT transport);
 
+enum RTSP_METHOD{
+    RTSP_METHOD_OPTIONS,
+    RTSP_METHOD_DESCRIBE,
+    RTSP_METHOD_ANNOUNCE,
+    RTSP_METHOD_SETUP,
+    RTSP_METHOD_PLAY,
+    RTSP_METHOD_PAUSE,
+    RTSP_METHOD_RECORD,
+    RTSP_METHOD_TEARDOWN,
+    RTSP_METHOD_GET_PARAMETER,
+    RTSP_METHOD_SET_PARAMETER,
+    RTSP_METHOD_REDIRECT,
+    RTSP_METHOD_UNKNOWN
+};
+
+const char* desc_rtsp_method(RTSP_METHOD method);
+
+// max header fields kept by rtsp_message,known fields are parsed even if more
+#define RTSP_MAX_HEADERS 32
+// request/status line and headers,larger message is an error
+#define RTSP_MAX_HEADER_SIZE 8192
+// '$' channel(8) size(16)
+#define RTSP_INTERLEAVED_HEADER_SIZE 4
+
+/**
+ * view of bytes in receive buffer,not null terminated
+ */
+struct rtsp_slice{
+    const char* data;
+    size_t size;
+
+    bool empty() const { return !size; }
+    bool equal(const char* str) const;
+    // ascii case insensitive
+    bool iequal(const char* str) const;
+    std::string str() const { return std::string(data,size); }
+};
+
+struct rtsp_header_field{
+    rtsp_slice name;
+    rtsp_slice value;
+};
+
+/**
+ * request or response,all slices point to the parsed buffer
+ */
+struct rtsp_message{
+    bool response;
+    // request line
+    RTSP_METHOD method;
+    rtsp_slice method_name;
+    rtsp_slice uri;
+    rtsp_slice version;
+    // status line
+    int status;
+    rtsp_slice reason;
+    // known headers,cseq/content_length -1 if absent
+    int64_t cseq;
+    int64_t content_length;
+    // session id without ;timeout=
+    rtsp_slice session;
+    rtsp_slice transport;
+    rtsp_slice body;
+    rtsp_header_field headers[RTSP_MAX_HEADERS];
+    size_t header_count;
+
+    /**
+     * header by name(case insensitive),nullptr if absent
+    */
+    const rtsp_slice* header(const char* name) const;
+};
+
+/**
+ * '$' interleaved binary frame of rtsp over tcp,RFC 2326 10.12
+ */
+struct rtsp_interleaved{
+    uint8_t channel;
+    const uint8_t* data;
+    size_t size;
+};
+
+/**
+ * Transport header,first transport spec only,ports/channels -1 if absent
+ */
+struct rtsp_transport_spec{
+    RTSP_TRANSPORT transport;
+    bool multicast;
+    int interleaved[2];
+    int client_port[2];
+    int server_port[2];
+    int ttl;
+    uint32_t ssrc;
+    bool has_ssrc;
+    rtsp_slice destination;
+    rtsp_slice mode;
+};
+
+bool rtsp_parse_transport(const rtsp_slice& value,rtsp_transport_spec* spec);
+
+enum RTSP_PARSE_RESULT{
+    RTSP_PARSE_NEED_MORE,
+    RTSP_PARSE_MESSAGE,
+    RTSP_PARSE_INTERLEAVED,
+    RTSP_PARSE_ERROR
+};
+
+/**
+ * incremental rtsp framing of control messages and interleaved frames,no allocation.
+ * parse() is called with the unconsumed bytes of receive buffer,on RTSP_PARSE_NEED_MORE
+ * call it again after more bytes are appended(buffer may be moved between calls),
+ * scanned bytes are not scanned again.
+ * message()/interleaved() point to the buffer and are valid until it is changed.
+ */
+class rtsp_parser{
+public:
+    rtsp_parser();
+    ~rtsp_parser() = default;
+
+    /**
+     * consumed bytes are dropped by caller:the message/frame,
+     * or CRLF keepalive before a message with RTSP_PARSE_NEED_MORE
+    */
+    RTSP_PARSE_RESULT parse(const uint8_t* bytes,size_t sizeBytes,size_t* consumed);
+
+    void reset();
+
+    const rtsp_message& message() const { return message_; }
+    const rtsp_interleaved& interleaved() const { return interleaved_; }
+private:
+    bool parse_head(const char* head,size_t size);
+    bool parse_start_line(const char* line,size_t size);
+    void parse_header(const char* line,size_t size);
+private:
+    rtsp_message message_;
+    rtsp_interleaved interleaved_;
+    // resume offset of header end search
+    size_t scanned_;
+    // header size when waiting body,0 if header not complete
+    size_t head_size_;
+};
+
+/**
+ * serialize rtsp message to caller buffer,
+ * size() is 0 after overflow
+ */
+class rtsp_writer{
+public:
+    rtsp_writer(char* buffer,size_t capacity);
+    ~rtsp_writer() = default;
+
+    rtsp_writer& request_line(RTSP_METHOD method,const char* uri);
+    /**
+     * reason of well known status if nullptr
+    */
+    rtsp_writer& status_line(int status,const char* reason = nullptr);
+    rtsp_writer& header(const char* name,const char* value);
+    rtsp_writer& header(const char* name,const rtsp_slice& value);
+    /**
+     * decimal value(CSeq,Content-Length...),named apart so header(name,0) is not ambiguous
+    */
+    rtsp_writer& header_int(const char* name,int64_t value);
+
+    /**
+     * Content-Length(if body),empty line and body,return message size
+    */
+    size_t end(const char* body = nullptr,size_t body_size = 0);
+
+    size_t size() const { return overflow_ ? 0 : size_; }
+    bool overflow() const { return overflow_; }
+private:
+    void append(const char* str,size_t size);
+private:
+    char* buffer_;
+    size_t capacity_;
+    size_t size_;
+    bool overflow_;
+};
+
+/**
+ * rtsp over tcp(RTSP_TRANSPORT_TCP),control messages and '$' interleaved rtp/rtcp
+ * share one socket.complete frames are dispatched as views of input bytes,
+ * only the tail of a frame split across reads is kept in the buffer.
+ */
+class rtsp_tcp_demuxer{
+public:
+    typedef std::function<void(uint8_t channel,const uint8_t* data,size_t size)> on_channel_t;
+    typedef std::function<void(const rtsp_message& message)> on_message_t;
+public:
+    /**
+     * capacity is the largest message/frame kept across reads
+    */
+    rtsp_tcp_demuxer(on_message_t on_message,
+        size_t capacity = RTSP_INTERLEAVED_HEADER_SIZE + 65535 + RTSP_MAX_HEADER_SIZE);
+    ~rtsp_tcp_demuxer() = default;
+
+    /**
+     * frames of channel without callback are dropped
+    */
+    void set_channel(uint8_t channel,on_channel_t on_data);
+    /**
+     * rtp/rtcp channels of SETUP Transport interleaved=a-b
+    */
+    void set_channels(const rtsp_transport_spec& spec,on_channel_t on_rtp,on_channel_t on_rtcp);
+
+    /**
+     * received bytes,parsed in place if nothing is buffered
+     * return false on framing error or frame larger than capacity,connection should be closed
+    */
+    bool input(const uint8_t* bytes,size_t sizeBytes);
+
+    /**
+     * recv() directly into the buffer:write_buffer() then commit() received bytes
+    */
+    uint8_t* write_buffer(size_t* size);
+    bool commit(size_t sizeBytes);
+
+    void reset();
+    size_t buffered() const { return buffered_; }
+private:
+    size_t process(const uint8_t* bytes,size_t sizeBytes,bool* error);
+    bool process_buffer();
+private:
+    on_message_t on_message_;
+    std::vector<on_channel_t> channels_;
+    rtsp_parser parser_;
+    std::vector<uint8_t> buffer_;
+    size_t buffered_;
+};
+
+/**
+ * write '$' channel size,return RTSP_INTERLEAVED_HEADER_SIZE
+ */
+size_t rtsp_write_interleaved_header(uint8_t* out,uint8_t channel,uint16_t size);
+
+const char* rtsp_status_reason(int status);
+
 }//!namespace zav
 
 
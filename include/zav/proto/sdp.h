@@ -0,0 +1,122 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+#ifndef ZAV_PROTO_SDP_H_
+#define ZAV_PROTO_SDP_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include "zav/codec/h26x.h"
+
+namespace zav{
+
+/**
+ * m= section with rtpmap/fmtp of its first payload type,RFC 4566
+ */
+struct sdp_media{
+    // video/audio/application
+    std::string media;
+    int port = 0;
+    // RTP/AVP
+    std::string proto;
+    std::vector<int> formats;
+    int payload_type = -1;
+    // rtpmap encoding name,clock rate and channels
+    std::string encoding;
+    AVCodecID codec = AV_CODEC_UNKNOWN;
+    int clock_rate = 0;
+    int channels = 0;
+    std::string control;
+    // fmtp parameters in order
+    std::vector<std::pair<std::string,std::string>> fmtp;
+    // other a= lines,name and value
+    std::vector<std::pair<std::string,std::string>> attributes;
+
+    // h264 sprop-parameter-sets,h265 sprop-vps/sps/pps,nalus without start code
+    std::vector<std::vector<uint8_t>> parameter_sets;
+    int packetization_mode = 0;
+    // from sps of parameter_sets
+    uint32_t width = 0;
+    uint32_t height = 0;
+    double fps = 0;
+    // aac AudioSpecificConfig of fmtp config
+    std::vector<uint8_t> config;
+
+    /**
+     * fmtp value by key(case insensitive),nullptr if absent
+    */
+    const std::string* fmtp_value(const char* key) const;
+
+    /**
+     * parameter_sets to param cache,return false if there is no valid sps
+    */
+    bool update_params(h264_param_cache& cache) const;
+    bool update_params(h265_param_cache& cache) const;
+};
+
+struct sdp_session{
+    std::string origin = "- 0 0 IN IP4 0.0.0.0";
+    std::string name = "zav";
+    // c= of session
+    std::string connection;
+    // a=control of session
+    std::string control;
+    std::string range;
+    std::vector<std::pair<std::string,std::string>> attributes;
+    std::vector<sdp_media> medias;
+};
+
+/**
+ * parse sdp text,codec parameters of known codecs are decoded
+ * return false if there is no m= line
+ */
+bool sdp_parse(const char* sdp,size_t size,sdp_session* session);
+
+/**
+ * sdp text of session,rtpmap/fmtp/control of each media
+ */
+std::string sdp_generate(const sdp_session& session);
+
+/**
+ * fill video media of h264/h265 from vps/sps/pps nalus(without start code)
+ */
+void sdp_media_h26x(sdp_media* media,AVCodecID codec,int payload_type,
+    const std::vector<std::vector<uint8_t>>& parameter_sets);
+
+/**
+ * fill audio media of aac(mpeg4-generic,RFC 3640 AAC-hbr) by AudioSpecificConfig
+ */
+void sdp_media_aac(sdp_media* media,int payload_type,const uint8_t* config,size_t size);
+
+};//!namespace zav
+
+#endif //!ZAV_PROTO_SDP_H_
@@ -32,9 +32,132 @@
 #ifndef ZCF_NET_H_
 #define ZCF_NET_H_
 
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <memory>
+#include <zpkg/utility.h>
+#if defined(Z_SYS_LINUX)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#endif
+#include "zcf/net/zcf_net.hpp"
 
 namespace zcf{
 
+namespace io{
+
+#if defined(Z_SYS_LINUX)
+
+/**
+ * received datagram in the slab of udp_socket,
+ * with UDP_GRO it may be segment_size bytes datagrams coalesced(last one shorter)
+ */
+struct udp_packet{
+    uint8_t* data;
+    size_t size;
+    // 0 if not coalesced
+    size_t segment_size;
+    // SO_TIMESTAMPNS,0 if not enabled
+    uint64_t timestamp_ns;
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+
+    size_t segment_count() const { return segment_size ? (size + segment_size - 1) / segment_size : 1; }
+    /**
+     * bytes of datagram i of coalesced packet
+    */
+    size_t segment(size_t i,uint8_t** segment_data) const {
+        if(!segment_size){
+            *segment_data = data;
+            return size;
+        }
+        size_t offset = i * segment_size;
+        *segment_data = data + offset;
+        return size - offset < segment_size ? size - offset : segment_size;
+    }
+    /**
+     * source as socket_addr,allocate
+    */
+    std::shared_ptr<socket_addr> source() const {
+        return socket_addr::from((const struct sockaddr*)&addr,socket_type_t::SOCKET_DATAGRAMS);
+    }
 };
 
+/**
+ * datagram to send as gather list,segment_size > 0 send iov as
+ * segment_size bytes datagrams by UDP_SEGMENT(GSO)
+ */
+struct udp_send_packet{
+    const struct iovec* iov;
+    size_t iov_count;
+    const struct sockaddr* addr;
+    socklen_t addr_len;
+    size_t segment_size;
+};
+
+/**
+ * non-blocking udp socket of batched io,recvmmsg into a pre-allocated slab of
+ * batch buffers and sendmmsg,both one system call per batch.
+ * received packets are valid until next recv_batch().
+ */
+class udp_socket{
+public:
+    udp_socket(size_t batch = 64,size_t packet_size = 2048);
+    ~udp_socket();
+
+    /**
+     * create and bind,reuse_port for one socket per thread on same port
+    */
+    bool open(const struct sockaddr* addr,socklen_t addr_len,bool reuse_port = false);
+    void close();
+    int fd() const { return fd_; }
+
+    /**
+     * coalesce datagrams of same flow(UDP_GRO,linux 5.0),
+     * slab buffers grow to 64KB
+    */
+    bool enable_gro();
+    /**
+     * kernel receive timestamp(SO_TIMESTAMPNS)
+    */
+    bool enable_timestamp();
+    bool set_buffer_size(int recv_size,int send_size);
+
+    /**
+     * return received count,0 if would block,-1 on error(errno)
+    */
+    int recv_batch();
+    const udp_packet& packet(size_t i) const { return packets_[i]; }
+    size_t received() const { return received_; }
+
+    /**
+     * return sent count,less than count if would block,-1 on error(errno) before any sent
+    */
+    int send_batch(const udp_send_packet* packets,size_t count);
+private:
+    void prepare_recv();
+private:
+    Z_DISABLE_COPY_MOVE(udp_socket);
+private:
+    int fd_;
+    size_t batch_;
+    size_t packet_size_;
+    size_t received_;
+    bool gro_;
+    bool timestamp_;
+    std::vector<uint8_t> slab_;
+    std::vector<uint8_t> control_;
+    std::vector<struct iovec> iov_;
+    std::vector<struct mmsghdr> msgs_;
+    std::vector<udp_packet> packets_;
+};
+
+#endif
+
+};//!namespace io
+
+};//!namespace zcf
+
 #endif//!ZCF_NET_H_
\ No newline at end of file
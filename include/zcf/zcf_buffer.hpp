@@ -34,6 +34,7 @@
 #define ZCF_BUFFER_HPP_
 #include <stddef.h>
 #include <stdint.h>
+#include "zcf/memory.hpp"
 
 
 namespace zcf{
@@ -54,8 +55,249 @@ void cross_byte_u8_c(const uint8_t* bytes,size_t size);
 void cross_byte_s16(const int16_t* bytes,size_t size);
 void cross_byte_s16_c(const int16_t* bytes,size_t size);
 
+/**
+ * msb first bit reader with exp-golomb(ue/se),for h264/h265/aac bitstream
+ * 
+ * bits are kept in a 64 bits cache(msb aligned),refill is branchless:
+ * load 8 bytes big endian and advance only by the whole bytes consumed,
+ * so there are always at least 56 bits after refill.
+ * the last 8 bytes are loaded by a zero padded copy,read over the end
+ * get 0 and set overrun().
+ */
 class bit_buffer{
+public:
+    bit_buffer(const uint8_t* data,size_t size);
+    ~bit_buffer() = default;
+
+    /**
+     * read n(0-32) bits
+     */
+    inline uint32_t read_bits(int n){
+        if(n <= 0) return 0;
+        if(bits_ < n) refill();
+        uint32_t value = (uint32_t)(cache_ >> (64 - n));
+        consume(n);
+        return value;
+    }
+
+    /**
+     * read n(0-64) bits
+     */
+    inline uint64_t read_bits64(int n){
+        if(n <= 32) return read_bits(n);
+        uint64_t high = read_bits(n - 32);
+        return (high << 32) | read_bits(32);
+    }
+
+    inline uint32_t read_bit(){
+        return read_bits(1);
+    }
+
+    inline bool read_flag(){
+        return read_bits(1) != 0;
+    }
+
+    /**
+     * peek n(0-32) bits without consume
+     */
+    inline uint32_t peek_bits(int n){
+        if(n <= 0) return 0;
+        if(bits_ < n) refill();
+        return (uint32_t)(cache_ >> (64 - n));
+    }
+
+    inline void skip_bits(size_t n){
+        while(n > 32){
+            read_bits(32);
+            n -= 32;
+        }
+        read_bits((int)n);
+    }
+
+    /**
+     * unsigned exp-golomb ue(v),value up to 2^32 - 2
+     */
+    inline uint32_t read_ue(){
+        if(bits_ < 32) refill();
+        int leading = cache_ ? __builtin_clzll(cache_) : 64;
+        if(leading <= 27){
+            // whole code word 2 * leading + 1 bits in cache after refill
+            int length = 2 * leading + 1;
+            if(bits_ < length) refill();
+            uint32_t value = (uint32_t)(cache_ >> (64 - length)) - 1;
+            consume(length);
+            return value;
+        }
+        return read_ue_long();
+    }
+
+    /**
+     * signed exp-golomb se(v),k->(-1)^(k+1)*ceil(k/2)
+     */
+    inline int32_t read_se(){
+        uint32_t k = read_ue();
+        return (k & 0x01) ? (int32_t)((k >> 1) + 1) : -(int32_t)(k >> 1);
+    }
+
+    /**
+     * skip to next byte boundary
+     */
+    inline void byte_align(){
+        read_bits((int)((8 - (bits_read() & 0x07)) & 0x07));
+    }
+
+    inline bool byte_aligned() const{
+        return (bits_read() & 0x07) == 0;
+    }
+
+    /**
+     * bits consumed from begin
+     */
+    inline size_t bits_read() const{
+        return pos_ * 8 - bits_;
+    }
+
+    /**
+     * bits not read,0 when overrun
+     */
+    inline size_t bits_left() const{
+        size_t total = size_ * 8;
+        size_t read = bits_read();
+        return read < total ? total - read : 0;
+    }
+
+    /**
+     * read over the end of data
+     */
+    inline bool overrun() const{
+        return bits_read() > size_ * 8;
+    }
+
+    /**
+     * more_rbsp_data() of h264/h265,whether there are bits before rbsp_stop_one_bit,
+     * the stop bit is searched at first call only
+     */
+    bool more_rbsp_data() const;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+private:
+    inline void refill(){
+        uint64_t load;
+        if(pos_ + 8 <= size_){
+            load = Z_RBE64(data_ + pos_);
+        }else{
+            load = load_tail();
+        }
+        cache_ |= load >> bits_;
+        pos_ += (63 - bits_) >> 3;
+        bits_ |= 56;
+    }
+
+    inline void consume(int n){
+        cache_ <<= n;
+        bits_ -= n;
+    }
+
+    uint64_t load_tail() const;
+    uint32_t read_ue_long();
+private:
+    const uint8_t* data_;
+    size_t size_;
+    // next byte to load
+    size_t pos_;
+    // msb aligned bits
+    uint64_t cache_;
+    int bits_;
+    // rbsp_stop_one_bit position,SIZE_MAX before searched
+    mutable size_t stop_bit_;
+};
+
+/**
+ * msb first bit writer with exp-golomb(ue/se) into caller buffer
+ * write over the capacity is dropped and set overflow()
+ */
+class bit_writer{
+public:
+    bit_writer(uint8_t* buffer,size_t capacity);
+    ~bit_writer() = default;
+
+    /**
+     * write low n(0-32) bits of value
+     */
+    inline void write_bits(uint32_t value,int n){
+        if(n <= 0) return;
+        uint64_t masked = (uint64_t)value & ((1ull << n) - 1);
+        cache_ |= masked << (64 - bits_ - n);
+        bits_ += n;
+        if(bits_ >= 32){
+            flush_word();
+        }
+    }
+
+    inline void write_bit(uint32_t bit){
+        write_bits(bit ? 1 : 0,1);
+    }
+
+    /**
+     * unsigned exp-golomb,value + 1 with leading zeros of its length - 1
+     */
+    inline void write_ue(uint32_t value){
+        uint64_t code = (uint64_t)value + 1;
+        int length = 64 - __builtin_clzll(code);
+        if(length <= 16){
+            // 2 * length - 1 bits at most 31
+            write_bits((uint32_t)code,2 * length - 1);
+            return;
+        }
+        write_bits(0,length - 1);
+        if(length > 32){
+            write_bits((uint32_t)(code >> 32),length - 32);
+            write_bits((uint32_t)code,32);
+        }else{
+            write_bits((uint32_t)code,length);
+        }
+    }
+
+    inline void write_se(int32_t value){
+        uint32_t k = value > 0 ? ((uint32_t)value << 1) - 1 : (uint32_t)(-(int64_t)value) << 1;
+        write_ue(k);
+    }
+
+    /**
+     * write 0 bits to next byte boundary
+     */
+    inline void byte_align(){
+        write_bits(0,(8 - (bits_written() & 0x07)) & 0x07);
+    }
+
+    /**
+     * rbsp_trailing_bits,stop bit 1 and align with 0
+     */
+    inline void write_trailing_bits(){
+        write_bits(1,1);
+        byte_align();
+    }
+
+    inline size_t bits_written() const{
+        return pos_ * 8 + bits_;
+    }
+
+    /**
+     * write cached bits to buffer(last byte zero padded),return bytes written
+     */
+    size_t flush();
 
+    inline bool overflow() const { return overflow_; }
+private:
+    void flush_word();
+private:
+    uint8_t* buffer_;
+    size_t capacity_;
+    size_t pos_;
+    uint64_t cache_;
+    int bits_;
+    bool overflow_;
 };
 
 }//!namespace zcf
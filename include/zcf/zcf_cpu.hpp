@@ -0,0 +1,88 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief runtime cpu feature detection,used to dispatch simd kernels
+ * so one binary can run on any host of the same arch
+ */
+
+#ifndef ZCF_CPU_HPP_
+#define ZCF_CPU_HPP_
+
+#include <stdint.h>
+
+// compile a single function for an instruction set,the caller must check
+// cpu::has() before calling it
+#if defined(__GNUC__) || defined(__clang__)
+#define Z_TARGET_ATTR(isa) __attribute__((target(isa)))
+#else
+#define Z_TARGET_ATTR(isa)
+#endif
+
+namespace zcf{
+
+namespace cpu{
+
+enum cpu_feature{
+    CPU_FEATURE_NONE        = 0,
+    // x86
+    CPU_FEATURE_SSE2        = 1 << 0,
+    CPU_FEATURE_SSSE3       = 1 << 1,
+    CPU_FEATURE_SSE42       = 1 << 2,
+    CPU_FEATURE_AVX2        = 1 << 3,
+    CPU_FEATURE_AVX512BW    = 1 << 4,
+    // arm
+    CPU_FEATURE_NEON        = 1 << 8,
+};
+
+/**
+ * @brief feature bits of current cpu,detected once(cpuid + xgetbv on x86)
+ * AVX2/AVX512 only reported when os has enabled the register state
+ * 
+ * @return uint32_t mask of cpu_feature
+ */
+uint32_t features();
+
+/**
+ * @brief whether current cpu support the feature
+ */
+inline bool has(cpu_feature feature){
+    return (features() & feature) == (uint32_t)feature;
+}
+
+/**
+ * @brief readable name of features,like "sse2 ssse3 avx2"
+ */
+const char* desc_features();
+
+};//!namespace cpu
+
+}//!namespace zcf
+
+#endif //!ZCF_CPU_HPP_
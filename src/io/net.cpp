@@ -0,0 +1,233 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief batched udp io
+ * 
+ */
+#include "zcf/io/net.h"
+
+#if defined(Z_SYS_LINUX)
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/udp.h>
+
+// linux/udp.h
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+
+// coalesced datagrams of UDP_GRO are at most 64KB
+#define UDP_GRO_PACKET_SIZE 65536
+// timestamp and gro segment size
+#define UDP_CONTROL_SIZE (CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(int)))
+#endif
+
+namespace zcf{
+
+namespace io{
+
+#if defined(Z_SYS_LINUX)
+
+udp_socket::udp_socket(size_t batch,size_t packet_size)
+    : fd_(-1),batch_(batch),packet_size_(packet_size),received_(0),gro_(false),timestamp_(false),
+    slab_(batch * packet_size),control_(batch * UDP_CONTROL_SIZE),
+    iov_(batch),msgs_(batch),packets_(batch){
+    Z_ASSERT(batch > 0 && packet_size > 0);
+}
+
+udp_socket::~udp_socket(){
+    close();
+}
+
+bool udp_socket::open(const struct sockaddr* addr,socklen_t addr_len,bool reuse_port){
+    close();
+    fd_ = ::socket(addr->sa_family,SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,0);
+    if(fd_ < 0){
+        return false;
+    }
+    int on = 1;
+    if(reuse_port){
+        setsockopt(fd_,SOL_SOCKET,SO_REUSEADDR,&on,sizeof(on));
+        setsockopt(fd_,SOL_SOCKET,SO_REUSEPORT,&on,sizeof(on));
+    }
+    if(::bind(fd_,addr,addr_len) != 0){
+        close();
+        return false;
+    }
+    return true;
+}
+
+void udp_socket::close(){
+    if(fd_ >= 0){
+        ::close(fd_);
+        fd_ = -1;
+    }
+    received_ = 0;
+    gro_ = false;
+    timestamp_ = false;
+}
+
+bool udp_socket::enable_gro(){
+    int on = 1;
+    if(fd_ < 0 || setsockopt(fd_,SOL_UDP,UDP_GRO,&on,sizeof(on)) != 0){
+        return false;
+    }
+    gro_ = true;
+    if(packet_size_ < UDP_GRO_PACKET_SIZE){
+        packet_size_ = UDP_GRO_PACKET_SIZE;
+        slab_.resize(batch_ * packet_size_);
+        received_ = 0;
+    }
+    return true;
+}
+
+bool udp_socket::enable_timestamp(){
+    int on = 1;
+    if(fd_ < 0 || setsockopt(fd_,SOL_SOCKET,SO_TIMESTAMPNS,&on,sizeof(on)) != 0){
+        return false;
+    }
+    timestamp_ = true;
+    return true;
+}
+
+bool udp_socket::set_buffer_size(int recv_size,int send_size){
+    if(fd_ < 0){
+        return false;
+    }
+    bool ok = true;
+    if(recv_size > 0){
+        ok = setsockopt(fd_,SOL_SOCKET,SO_RCVBUF,&recv_size,sizeof(recv_size)) == 0 && ok;
+    }
+    if(send_size > 0){
+        ok = setsockopt(fd_,SOL_SOCKET,SO_SNDBUF,&send_size,sizeof(send_size)) == 0 && ok;
+    }
+    return ok;
+}
+
+void udp_socket::prepare_recv(){
+    for(size_t i = 0;i < batch_;i++){
+        iov_[i].iov_base = slab_.data() + i * packet_size_;
+        iov_[i].iov_len = packet_size_;
+        struct msghdr& hdr = msgs_[i].msg_hdr;
+        hdr.msg_name = &packets_[i].addr;
+        hdr.msg_namelen = sizeof(packets_[i].addr);
+        hdr.msg_iov = &iov_[i];
+        hdr.msg_iovlen = 1;
+        hdr.msg_control = control_.data() + i * UDP_CONTROL_SIZE;
+        hdr.msg_controllen = UDP_CONTROL_SIZE;
+        hdr.msg_flags = 0;
+        msgs_[i].msg_len = 0;
+    }
+}
+
+int udp_socket::recv_batch(){
+    received_ = 0;
+    prepare_recv();
+    int count = recvmmsg(fd_,msgs_.data(),(unsigned int)batch_,MSG_DONTWAIT,nullptr);
+    if(count < 0){
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+    for(int i = 0;i < count;i++){
+        udp_packet& packet = packets_[i];
+        struct msghdr& hdr = msgs_[i].msg_hdr;
+        packet.data = (uint8_t*)iov_[i].iov_base;
+        packet.size = msgs_[i].msg_len;
+        packet.addr_len = hdr.msg_namelen;
+        packet.segment_size = 0;
+        packet.timestamp_ns = 0;
+        for(struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);cmsg;cmsg = CMSG_NXTHDR(&hdr,cmsg)){
+            if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS){
+                struct timespec ts;
+                memcpy(&ts,CMSG_DATA(cmsg),sizeof(ts));
+                packet.timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+            }else if(cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO){
+                int segment_size = 0;
+                memcpy(&segment_size,CMSG_DATA(cmsg),sizeof(segment_size));
+                if(segment_size > 0 && (size_t)segment_size < packet.size){
+                    packet.segment_size = (size_t)segment_size;
+                }
+            }
+        }
+    }
+    received_ = (size_t)count;
+    return count;
+}
+
+int udp_socket::send_batch(const udp_send_packet* packets,size_t count){
+    size_t sent = 0;
+    while(sent < count){
+        size_t batch = count - sent < batch_ ? count - sent : batch_;
+        for(size_t i = 0;i < batch;i++){
+            const udp_send_packet& packet = packets[sent + i];
+            struct msghdr& hdr = msgs_[i].msg_hdr;
+            memset(&hdr,0,sizeof(hdr));
+            hdr.msg_name = (void*)packet.addr;
+            hdr.msg_namelen = packet.addr_len;
+            hdr.msg_iov = (struct iovec*)packet.iov;
+            hdr.msg_iovlen = packet.iov_count;
+            if(packet.segment_size){
+                // GSO,kernel split the datagram
+                hdr.msg_control = control_.data() + i * UDP_CONTROL_SIZE;
+                hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+                struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+                cmsg->cmsg_level = SOL_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                uint16_t segment_size = (uint16_t)packet.segment_size;
+                memcpy(CMSG_DATA(cmsg),&segment_size,sizeof(segment_size));
+            }
+        }
+        int result = sendmmsg(fd_,msgs_.data(),(unsigned int)batch,MSG_DONTWAIT);
+        if(result < 0){
+            if(sent || errno == EAGAIN || errno == EWOULDBLOCK){
+                return (int)sent;
+            }
+            return -1;
+        }
+        sent += (size_t)result;
+        if((size_t)result < batch){
+            break;
+        }
+    }
+    return (int)sent;
+}
+
+#endif
+
+}//!namespace io
+
+}//!namespace zcf
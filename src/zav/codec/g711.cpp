@@ -32,6 +32,13 @@
 
 #include "zav/codec/g711.h"
 
+#include "zcf/zcf_cpu.hpp"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace zav
 {
 #ifdef G711_LOOKUP_TABLE
@@ -302,30 +309,15 @@ uint8_t ulaw2alaw(uint8_t ulaw)
 
 #else // not G711_LOOKUP_TABLE
 
-#ifdef __x86_64__
-static int top_bit(unsigned int bits) {
-  int res;
-
-  __asm__ __volatile__(
-      " movq $-1,%%rdx;\n"
-      " bsrq %%rax,%%rdx;\n"
-      : "=d"(res)
-      : "a"(bits));
-  return res;
-}
-
-static int bottom_bit(unsigned int bits) {
-  int res;
-
-  __asm__ __volatile__(
-      " movq $-1,%%rdx;\n"
-      " bsfq %%rax,%%rdx;\n"
-      : "=d"(res)
-      : "a"(bits));
-  return res;
-}
-#else // not __x86_64__ back to c
-static int top_bit(unsigned int bits) {
+// segment of a sample is its top bit,use count leading zero instead of bsr asm
+// the span kernels do the same with simd leading zero count
+static inline int top_bit(unsigned int bits) {
+#if defined(__GNUC__) || defined(__clang__)
+  if (bits == 0) {
+    return -1;
+  }
+  return 31 - __builtin_clz(bits);
+#else
   int i;
 
   if (bits == 0) {
@@ -353,39 +345,9 @@ static int top_bit(unsigned int bits) {
     i += 1;
   }
   return i;
+#endif
 }
 
-static  int bottom_bit(unsigned int bits) {
-  int i;
-
-  if (bits == 0) {
-    return -1;
-  }
-  i = 32;
-  if (bits & 0x0000FFFF) {
-    bits &= 0x0000FFFF;
-    i -= 16;
-  }
-  if (bits & 0x00FF00FF) {
-    bits &= 0x00FF00FF;
-    i -= 8;
-  }
-  if (bits & 0x0F0F0F0F) {
-    bits &= 0x0F0F0F0F;
-    i -= 4;
-  }
-  if (bits & 0x33333333) {
-    bits &= 0x33333333;
-    i -= 2;
-  }
-  if (bits & 0x55555555) {
-    bits &= 0x55555555;
-    i -= 1;
-  }
-  return i;
-}
-#endif // 
-
 #define ALAW_AMI_MASK 0x55
 uint8_t	linear2alaw(int16_t linear)
 {
@@ -537,4 +499,519 @@ uint8_t	ulaw2alaw(uint8_t ulaw)
     return ulaw_to_alaw_table[ulaw];
 }
 #endif
+
+/* span apis,simd kernels are bitexact with the sample functions above */
+static void alaw_decode_c(const uint8_t* alaw,size_t size,int16_t* linear){
+    for(size_t i = 0; i < size; i++){
+        linear[i] = alaw2linear(alaw[i]);
+    }
+}
+
+static void alaw_encode_c(const int16_t* linear,size_t size,uint8_t* alaw){
+    for(size_t i = 0; i < size; i++){
+        alaw[i] = linear2alaw(linear[i]);
+    }
+}
+
+static void ulaw_decode_c(const uint8_t* ulaw,size_t size,int16_t* linear){
+    for(size_t i = 0; i < size; i++){
+        linear[i] = ulaw2linear(ulaw[i]);
+    }
+}
+
+static void ulaw_encode_c(const int16_t* linear,size_t size,uint8_t* ulaw){
+    for(size_t i = 0; i < size; i++){
+        ulaw[i] = linear2ulaw(linear[i]);
+    }
+}
+
+static void alaw_to_ulaw_c(const uint8_t* alaw,size_t size,uint8_t* ulaw){
+    for(size_t i = 0; i < size; i++){
+        ulaw[i] = alaw2ulaw(alaw[i]);
+    }
+}
+
+static void ulaw_to_alaw_c(const uint8_t* ulaw,size_t size,uint8_t* alaw){
+    for(size_t i = 0; i < size; i++){
+        alaw[i] = ulaw2alaw(ulaw[i]);
+    }
+}
+
+typedef void (*g711_decode_func)(const uint8_t* codes,size_t size,int16_t* linear);
+typedef void (*g711_encode_func)(const int16_t* linear,size_t size,uint8_t* codes);
+typedef void (*g711_transcode_func)(const uint8_t* src,size_t size,uint8_t* dst);
+
+#if !defined(G711_LOOKUP_TABLE) && !defined(ULAW_ZEROTRAP)
+#define G711_SIMD_KERNEL
+#endif
+
+#if defined(G711_SIMD_KERNEL) && defined(__x86_64__)
+/*
+ * 16bit lanes,every lane hold one sample or one code(0~255)
+ * per segment constants come from pshufb lookup,index | 0x8000 keep the high byte 0
+ * encode segment is the bit length of (magnitude >> 8),pshufb on two nibbles
+ * quantization bits (m >> (seg + 3)) & 0xF done by m * 2^(7 - seg) >> 10,never overflow
+ */
+Z_TARGET_ATTR("ssse3")
+static inline __m128i alaw_decode_epi16_ssse3(__m128i code){
+    const __m128i mult_table = _mm_setr_epi8(1,1,2,4,8,16,32,64,0,0,0,0,0,0,0,0);
+    __m128i a = _mm_xor_si128(code,_mm_set1_epi16(ALAW_AMI_MASK));
+    __m128i mant = _mm_slli_epi16(_mm_and_si128(a,_mm_set1_epi16(0x0F)),4);
+    __m128i seg = _mm_and_si128(_mm_srli_epi16(a,4),_mm_set1_epi16(0x07));
+    // seg 0: mant + 8,others: (mant + 0x108) << (seg - 1)
+    __m128i nz = _mm_slli_epi16(_mm_min_epi16(seg,_mm_set1_epi16(1)),8);
+    __m128i base = _mm_add_epi16(_mm_add_epi16(mant,_mm_set1_epi16(8)),nz);
+    __m128i mult = _mm_shuffle_epi8(mult_table,_mm_or_si128(seg,_mm_set1_epi16((short)0x8000)));
+    __m128i i = _mm_mullo_epi16(base,mult);
+    // sign bit clear means negative
+    __m128i neg = _mm_cmpeq_epi16(_mm_and_si128(a,_mm_set1_epi16(0x80)),_mm_setzero_si128());
+    return _mm_sub_epi16(_mm_xor_si128(i,neg),neg);
+}
+
+Z_TARGET_ATTR("ssse3")
+static inline __m128i ulaw_decode_epi16_ssse3(__m128i code){
+    const __m128i mult_table = _mm_setr_epi8(1,2,4,8,16,32,64,(char)128,0,0,0,0,0,0,0,0);
+    __m128i u = _mm_xor_si128(code,_mm_set1_epi16(0xFF));
+    __m128i seg = _mm_and_si128(_mm_srli_epi16(u,4),_mm_set1_epi16(0x07));
+    __m128i base = _mm_add_epi16(_mm_slli_epi16(_mm_and_si128(u,_mm_set1_epi16(0x0F)),3),_mm_set1_epi16(ULAW_BIAS));
+    __m128i mult = _mm_shuffle_epi8(mult_table,_mm_or_si128(seg,_mm_set1_epi16((short)0x8000)));
+    __m128i i = _mm_sub_epi16(_mm_mullo_epi16(base,mult),_mm_set1_epi16(ULAW_BIAS));
+    __m128i neg = _mm_cmpeq_epi16(_mm_and_si128(u,_mm_set1_epi16(0x80)),_mm_set1_epi16(0x80));
+    return _mm_sub_epi16(_mm_xor_si128(i,neg),neg);
+}
+
+// bit length of (m >> 8),m must be 0~0x7FFF
+Z_TARGET_ATTR("ssse3")
+static inline __m128i g711_segment_epi16_ssse3(__m128i m){
+    const __m128i bitlen_lo = _mm_setr_epi8(0,1,2,2,3,3,3,3,4,4,4,4,4,4,4,4);
+    const __m128i bitlen_hi = _mm_setr_epi8(0,5,6,6,7,7,7,7,0,0,0,0,0,0,0,0);
+    __m128i h = _mm_srli_epi16(m,8);
+    return _mm_max_epi16(_mm_shuffle_epi8(bitlen_hi,_mm_srli_epi16(h,4)),
+                         _mm_shuffle_epi8(bitlen_lo,_mm_and_si128(h,_mm_set1_epi16(0x0F))));
+}
+
+Z_TARGET_ATTR("ssse3")
+static inline __m128i alaw_encode_epi16_ssse3(__m128i x){
+    const __m128i mult_table = _mm_setr_epi8(64,64,32,16,8,4,2,1,0,0,0,0,0,0,0,0);
+    // ~x for negative
+    __m128i sign = _mm_srai_epi16(x,15);
+    __m128i m = _mm_xor_si128(x,sign);
+    __m128i seg = g711_segment_epi16_ssse3(m);
+    __m128i mult = _mm_shuffle_epi8(mult_table,_mm_or_si128(seg,_mm_set1_epi16((short)0x8000)));
+    __m128i q = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(m,mult),10),_mm_set1_epi16(0x0F));
+    __m128i code = _mm_or_si128(_mm_slli_epi16(seg,4),q);
+    __m128i mask = _mm_xor_si128(_mm_set1_epi16(ALAW_AMI_MASK | 0x80),_mm_and_si128(sign,_mm_set1_epi16(0x80)));
+    return _mm_xor_si128(code,mask);
+}
+
+Z_TARGET_ATTR("ssse3")
+static inline __m128i ulaw_encode_epi16_ssse3(__m128i x){
+    const __m128i mult_table = _mm_setr_epi8((char)128,64,32,16,8,4,2,1,0,0,0,0,0,0,0,0);
+    __m128i sign = _mm_srai_epi16(x,15);
+    // saturate at 0x7FFF,which encode the same as out of range
+    __m128i v = _mm_adds_epi16(_mm_xor_si128(x,sign),_mm_set1_epi16(ULAW_BIAS));
+    __m128i seg = g711_segment_epi16_ssse3(v);
+    __m128i mult = _mm_shuffle_epi8(mult_table,_mm_or_si128(seg,_mm_set1_epi16((short)0x8000)));
+    __m128i q = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(v,mult),10),_mm_set1_epi16(0x0F));
+    __m128i code = _mm_or_si128(_mm_slli_epi16(seg,4),q);
+    __m128i mask = _mm_xor_si128(_mm_set1_epi16(0xFF),_mm_and_si128(sign,_mm_set1_epi16(0x80)));
+    return _mm_xor_si128(code,mask);
+}
+
+template<__m128i (*decode)(__m128i),int16_t (*decode_sample)(uint8_t)>
+Z_TARGET_ATTR("ssse3")
+static void g711_decode_ssse3(const uint8_t* codes,size_t size,int16_t* linear){
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for(; i + 16 <= size; i += 16){
+        __m128i c = _mm_loadu_si128((const __m128i*)(codes + i));
+        _mm_storeu_si128((__m128i*)(linear + i),decode(_mm_unpacklo_epi8(c,zero)));
+        _mm_storeu_si128((__m128i*)(linear + i + 8),decode(_mm_unpackhi_epi8(c,zero)));
+    }
+    for(; i < size; i++){
+        linear[i] = decode_sample(codes[i]);
+    }
+}
+
+template<__m128i (*encode)(__m128i),uint8_t (*encode_sample)(int16_t)>
+Z_TARGET_ATTR("ssse3")
+static void g711_encode_ssse3(const int16_t* linear,size_t size,uint8_t* codes){
+    size_t i = 0;
+    for(; i + 16 <= size; i += 16){
+        __m128i lo = encode(_mm_loadu_si128((const __m128i*)(linear + i)));
+        __m128i hi = encode(_mm_loadu_si128((const __m128i*)(linear + i + 8)));
+        _mm_storeu_si128((__m128i*)(codes + i),_mm_packus_epi16(lo,hi));
+    }
+    for(; i < size; i++){
+        codes[i] = encode_sample(linear[i]);
+    }
+}
+
+// same as ssse3 ones,pshufb tables broadcast to both 128bit lanes
+Z_TARGET_ATTR("avx2")
+static inline __m256i alaw_decode_epi16_avx2(__m256i code){
+    const __m256i mult_table = _mm256_broadcastsi128_si256(_mm_setr_epi8(1,1,2,4,8,16,32,64,0,0,0,0,0,0,0,0));
+    __m256i a = _mm256_xor_si256(code,_mm256_set1_epi16(ALAW_AMI_MASK));
+    __m256i mant = _mm256_slli_epi16(_mm256_and_si256(a,_mm256_set1_epi16(0x0F)),4);
+    __m256i seg = _mm256_and_si256(_mm256_srli_epi16(a,4),_mm256_set1_epi16(0x07));
+    __m256i nz = _mm256_slli_epi16(_mm256_min_epi16(seg,_mm256_set1_epi16(1)),8);
+    __m256i base = _mm256_add_epi16(_mm256_add_epi16(mant,_mm256_set1_epi16(8)),nz);
+    __m256i mult = _mm256_shuffle_epi8(mult_table,_mm256_or_si256(seg,_mm256_set1_epi16((short)0x8000)));
+    __m256i i = _mm256_mullo_epi16(base,mult);
+    __m256i neg = _mm256_cmpeq_epi16(_mm256_and_si256(a,_mm256_set1_epi16(0x80)),_mm256_setzero_si256());
+    return _mm256_sub_epi16(_mm256_xor_si256(i,neg),neg);
+}
+
+Z_TARGET_ATTR("avx2")
+static inline __m256i ulaw_decode_epi16_avx2(__m256i code){
+    const __m256i mult_table = _mm256_broadcastsi128_si256(_mm_setr_epi8(1,2,4,8,16,32,64,(char)128,0,0,0,0,0,0,0,0));
+    __m256i u = _mm256_xor_si256(code,_mm256_set1_epi16(0xFF));
+    __m256i seg = _mm256_and_si256(_mm256_srli_epi16(u,4),_mm256_set1_epi16(0x07));
+    __m256i base = _mm256_add_epi16(_mm256_slli_epi16(_mm256_and_si256(u,_mm256_set1_epi16(0x0F)),3),_mm256_set1_epi16(ULAW_BIAS));
+    __m256i mult = _mm256_shuffle_epi8(mult_table,_mm256_or_si256(seg,_mm256_set1_epi16((short)0x8000)));
+    __m256i i = _mm256_sub_epi16(_mm256_mullo_epi16(base,mult),_mm256_set1_epi16(ULAW_BIAS));
+    __m256i neg = _mm256_cmpeq_epi16(_mm256_and_si256(u,_mm256_set1_epi16(0x80)),_mm256_set1_epi16(0x80));
+    return _mm256_sub_epi16(_mm256_xor_si256(i,neg),neg);
+}
+
+Z_TARGET_ATTR("avx2")
+static inline __m256i g711_segment_epi16_avx2(__m256i m){
+    const __m256i bitlen_lo = _mm256_broadcastsi128_si256(_mm_setr_epi8(0,1,2,2,3,3,3,3,4,4,4,4,4,4,4,4));
+    const __m256i bitlen_hi = _mm256_broadcastsi128_si256(_mm_setr_epi8(0,5,6,6,7,7,7,7,0,0,0,0,0,0,0,0));
+    __m256i h = _mm256_srli_epi16(m,8);
+    return _mm256_max_epi16(_mm256_shuffle_epi8(bitlen_hi,_mm256_srli_epi16(h,4)),
+                            _mm256_shuffle_epi8(bitlen_lo,_mm256_and_si256(h,_mm256_set1_epi16(0x0F))));
+}
+
+Z_TARGET_ATTR("avx2")
+static inline __m256i alaw_encode_epi16_avx2(__m256i x){
+    const __m256i mult_table = _mm256_broadcastsi128_si256(_mm_setr_epi8(64,64,32,16,8,4,2,1,0,0,0,0,0,0,0,0));
+    __m256i sign = _mm256_srai_epi16(x,15);
+    __m256i m = _mm256_xor_si256(x,sign);
+    __m256i seg = g711_segment_epi16_avx2(m);
+    __m256i mult = _mm256_shuffle_epi8(mult_table,_mm256_or_si256(seg,_mm256_set1_epi16((short)0x8000)));
+    __m256i q = _mm256_and_si256(_mm256_srli_epi16(_mm256_mullo_epi16(m,mult),10),_mm256_set1_epi16(0x0F));
+    __m256i code = _mm256_or_si256(_mm256_slli_epi16(seg,4),q);
+    __m256i mask = _mm256_xor_si256(_mm256_set1_epi16(ALAW_AMI_MASK | 0x80),_mm256_and_si256(sign,_mm256_set1_epi16(0x80)));
+    return _mm256_xor_si256(code,mask);
+}
+
+Z_TARGET_ATTR("avx2")
+static inline __m256i ulaw_encode_epi16_avx2(__m256i x){
+    const __m256i mult_table = _mm256_broadcastsi128_si256(_mm_setr_epi8((char)128,64,32,16,8,4,2,1,0,0,0,0,0,0,0,0));
+    __m256i sign = _mm256_srai_epi16(x,15);
+    __m256i v = _mm256_adds_epi16(_mm256_xor_si256(x,sign),_mm256_set1_epi16(ULAW_BIAS));
+    __m256i seg = g711_segment_epi16_avx2(v);
+    __m256i mult = _mm256_shuffle_epi8(mult_table,_mm256_or_si256(seg,_mm256_set1_epi16((short)0x8000)));
+    __m256i q = _mm256_and_si256(_mm256_srli_epi16(_mm256_mullo_epi16(v,mult),10),_mm256_set1_epi16(0x0F));
+    __m256i code = _mm256_or_si256(_mm256_slli_epi16(seg,4),q);
+    __m256i mask = _mm256_xor_si256(_mm256_set1_epi16(0xFF),_mm256_and_si256(sign,_mm256_set1_epi16(0x80)));
+    return _mm256_xor_si256(code,mask);
+}
+
+template<__m256i (*decode)(__m256i),int16_t (*decode_sample)(uint8_t)>
+Z_TARGET_ATTR("avx2")
+static void g711_decode_avx2(const uint8_t* codes,size_t size,int16_t* linear){
+    size_t i = 0;
+    for(; i + 32 <= size; i += 32){
+        __m256i lo = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(codes + i)));
+        __m256i hi = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(codes + i + 16)));
+        _mm256_storeu_si256((__m256i*)(linear + i),decode(lo));
+        _mm256_storeu_si256((__m256i*)(linear + i + 16),decode(hi));
+    }
+    for(; i < size; i++){
+        linear[i] = decode_sample(codes[i]);
+    }
+}
+
+template<__m256i (*encode)(__m256i),uint8_t (*encode_sample)(int16_t)>
+Z_TARGET_ATTR("avx2")
+static void g711_encode_avx2(const int16_t* linear,size_t size,uint8_t* codes){
+    size_t i = 0;
+    for(; i + 32 <= size; i += 32){
+        __m256i lo = encode(_mm256_loadu_si256((const __m256i*)(linear + i)));
+        __m256i hi = encode(_mm256_loadu_si256((const __m256i*)(linear + i + 16)));
+        // packus works in 128bit lanes,put 64bit blocks back in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo,hi),0xD8);
+        _mm256_storeu_si256((__m256i*)(codes + i),packed);
+    }
+    for(; i < size; i++){
+        codes[i] = encode_sample(linear[i]);
+    }
+}
+
+/*
+ * 256 byte table lookup by pshufb,16 rows of 16 bytes indexed by the low nibble
+ * index - 16 * k (signed saturate) keep bit 7 set for rows above the high nibble,
+ * pshufb give 0 for them,row k store row k ^ row k-1 so the rows left telescope
+ * to the wanted one,codes >= 128 use rows 8~15 with index ^ 0x80
+ * src load before dst store,so transcode in place is fine
+ */
+template<const uint8_t* table>
+Z_TARGET_ATTR("ssse3")
+static void g711_transcode_ssse3(const uint8_t* src,size_t size,uint8_t* dst){
+    __m128i rows[16];
+    for(int k = 0; k < 16; k++){
+        rows[k] = _mm_loadu_si128((const __m128i*)(table + 16 * k));
+    }
+    for(int k = 15; k > 0; k--){
+        if(k & 7) rows[k] = _mm_xor_si128(rows[k],rows[k - 1]);
+    }
+    const __m128i step = _mm_set1_epi8(16);
+    const __m128i flip = _mm_set1_epi8((char)0x80);
+    size_t i = 0;
+    for(; i + 16 <= size; i += 16){
+        __m128i lo = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i hi = _mm_xor_si128(lo,flip);
+        // two chains,only one of them hit for each byte
+        __m128i r_lo = _mm_setzero_si128();
+        __m128i r_hi = _mm_setzero_si128();
+        #pragma GCC unroll 8
+        for(int k = 0; k < 8; k++){
+            r_lo = _mm_xor_si128(r_lo,_mm_shuffle_epi8(rows[k],lo));
+            r_hi = _mm_xor_si128(r_hi,_mm_shuffle_epi8(rows[k + 8],hi));
+            lo = _mm_subs_epi8(lo,step);
+            hi = _mm_subs_epi8(hi,step);
+        }
+        _mm_storeu_si128((__m128i*)(dst + i),_mm_or_si128(r_lo,r_hi));
+    }
+    for(; i < size; i++){
+        dst[i] = table[src[i]];
+    }
+}
+
+template<const uint8_t* table>
+Z_TARGET_ATTR("avx2")
+static void g711_transcode_avx2(const uint8_t* src,size_t size,uint8_t* dst){
+    __m256i rows[16];
+    for(int k = 0; k < 16; k++){
+        rows[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(table + 16 * k)));
+    }
+    for(int k = 15; k > 0; k--){
+        if(k & 7) rows[k] = _mm256_xor_si256(rows[k],rows[k - 1]);
+    }
+    const __m256i step = _mm256_set1_epi8(16);
+    const __m256i flip = _mm256_set1_epi8((char)0x80);
+    size_t i = 0;
+    for(; i + 32 <= size; i += 32){
+        __m256i lo = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i hi = _mm256_xor_si256(lo,flip);
+        // two chains,only one of them hit for each byte
+        __m256i r_lo = _mm256_setzero_si256();
+        __m256i r_hi = _mm256_setzero_si256();
+        #pragma GCC unroll 8
+        for(int k = 0; k < 8; k++){
+            r_lo = _mm256_xor_si256(r_lo,_mm256_shuffle_epi8(rows[k],lo));
+            r_hi = _mm256_xor_si256(r_hi,_mm256_shuffle_epi8(rows[k + 8],hi));
+            lo = _mm256_subs_epi8(lo,step);
+            hi = _mm256_subs_epi8(hi,step);
+        }
+        _mm256_storeu_si256((__m256i*)(dst + i),_mm256_or_si256(r_lo,r_hi));
+    }
+    for(; i < size; i++){
+        dst[i] = table[src[i]];
+    }
+}
+#endif
+
+#if defined(G711_SIMD_KERNEL) && defined(__ARM_NEON)
+// neon has variable shift and clz on 16bit lanes,no lookup needed
+static inline int16x8_t alaw_decode_s16_neon(uint16x8_t code){
+    uint16x8_t a = veorq_u16(code,vdupq_n_u16(ALAW_AMI_MASK));
+    uint16x8_t mant = vshlq_n_u16(vandq_u16(a,vdupq_n_u16(0x0F)),4);
+    uint16x8_t seg = vandq_u16(vshrq_n_u16(a,4),vdupq_n_u16(0x07));
+    // seg 0: mant + 8,others: (mant + 0x108) << (seg - 1)
+    uint16x8_t nz = vminq_u16(seg,vdupq_n_u16(1));
+    uint16x8_t base = vaddq_u16(vaddq_u16(mant,vdupq_n_u16(8)),vshlq_n_u16(nz,8));
+    int16x8_t i = vreinterpretq_s16_u16(vshlq_u16(base,vreinterpretq_s16_u16(vsubq_u16(seg,nz))));
+    // sign bit clear means negative
+    uint16x8_t pos = vtstq_u16(a,vdupq_n_u16(0x80));
+    return vbslq_s16(pos,i,vnegq_s16(i));
+}
+
+static inline int16x8_t ulaw_decode_s16_neon(uint16x8_t code){
+    uint16x8_t u = veorq_u16(code,vdupq_n_u16(0xFF));
+    uint16x8_t seg = vandq_u16(vshrq_n_u16(u,4),vdupq_n_u16(0x07));
+    uint16x8_t base = vaddq_u16(vshlq_n_u16(vandq_u16(u,vdupq_n_u16(0x0F)),3),vdupq_n_u16(ULAW_BIAS));
+    uint16x8_t t = vshlq_u16(base,vreinterpretq_s16_u16(seg));
+    int16x8_t i = vreinterpretq_s16_u16(vsubq_u16(t,vdupq_n_u16(ULAW_BIAS)));
+    uint16x8_t neg = vtstq_u16(u,vdupq_n_u16(0x80));
+    return vbslq_s16(neg,vnegq_s16(i),i);
+}
+
+// bit length - 8 of (m | 0xFF),m must be 0~0x7FFF
+static inline int16x8_t g711_segment_s16_neon(uint16x8_t m){
+    uint16x8_t lz = vclzq_u16(vorrq_u16(m,vdupq_n_u16(0xFF)));
+    return vsubq_s16(vdupq_n_s16(8),vreinterpretq_s16_u16(lz));
+}
+
+static inline uint16x8_t alaw_encode_u16_neon(int16x8_t x){
+    // ~x for negative
+    int16x8_t sign = vshrq_n_s16(x,15);
+    uint16x8_t m = vreinterpretq_u16_s16(veorq_s16(x,sign));
+    int16x8_t seg = g711_segment_s16_neon(m);
+    // shift right seg + 3,segment 0 shift 4
+    int16x8_t shift = vnegq_s16(vaddq_s16(vmaxq_s16(seg,vdupq_n_s16(1)),vdupq_n_s16(3)));
+    uint16x8_t q = vandq_u16(vshlq_u16(m,shift),vdupq_n_u16(0x0F));
+    uint16x8_t code = vorrq_u16(vshlq_n_u16(vreinterpretq_u16_s16(seg),4),q);
+    uint16x8_t mask = veorq_u16(vdupq_n_u16(ALAW_AMI_MASK | 0x80),vandq_u16(vreinterpretq_u16_s16(sign),vdupq_n_u16(0x80)));
+    return veorq_u16(code,mask);
+}
+
+static inline uint16x8_t ulaw_encode_u16_neon(int16x8_t x){
+    int16x8_t sign = vshrq_n_s16(x,15);
+    // saturate at 0x7FFF,which encode the same as out of range
+    uint16x8_t v = vreinterpretq_u16_s16(vqaddq_s16(veorq_s16(x,sign),vdupq_n_s16(ULAW_BIAS)));
+    int16x8_t seg = g711_segment_s16_neon(v);
+    int16x8_t shift = vnegq_s16(vaddq_s16(seg,vdupq_n_s16(3)));
+    uint16x8_t q = vandq_u16(vshlq_u16(v,shift),vdupq_n_u16(0x0F));
+    uint16x8_t code = vorrq_u16(vshlq_n_u16(vreinterpretq_u16_s16(seg),4),q);
+    uint16x8_t mask = veorq_u16(vdupq_n_u16(0xFF),vandq_u16(vreinterpretq_u16_s16(sign),vdupq_n_u16(0x80)));
+    return veorq_u16(code,mask);
+}
+
+template<int16x8_t (*decode)(uint16x8_t),int16_t (*decode_sample)(uint8_t)>
+static void g711_decode_neon(const uint8_t* codes,size_t size,int16_t* linear){
+    size_t i = 0;
+    for(; i + 16 <= size; i += 16){
+        uint8x16_t c = vld1q_u8(codes + i);
+        vst1q_s16(linear + i,decode(vmovl_u8(vget_low_u8(c))));
+        vst1q_s16(linear + i + 8,decode(vmovl_u8(vget_high_u8(c))));
+    }
+    for(; i < size; i++){
+        linear[i] = decode_sample(codes[i]);
+    }
+}
+
+template<uint16x8_t (*encode)(int16x8_t),uint8_t (*encode_sample)(int16_t)>
+static void g711_encode_neon(const int16_t* linear,size_t size,uint8_t* codes){
+    size_t i = 0;
+    for(; i + 16 <= size; i += 16){
+        uint16x8_t lo = encode(vld1q_s16(linear + i));
+        uint16x8_t hi = encode(vld1q_s16(linear + i + 8));
+        vst1q_u8(codes + i,vcombine_u8(vmovn_u16(lo),vmovn_u16(hi)));
+    }
+    for(; i < size; i++){
+        codes[i] = encode_sample(linear[i]);
+    }
+}
+
+#if defined(__aarch64__)
+// tbl on 64 byte tables,tbx keep the last result for out of range index
+template<const uint8_t* table>
+static void g711_transcode_neon(const uint8_t* src,size_t size,uint8_t* dst){
+    const uint8x16x4_t t0 = {{vld1q_u8(table),vld1q_u8(table + 16),vld1q_u8(table + 32),vld1q_u8(table + 48)}};
+    const uint8x16x4_t t1 = {{vld1q_u8(table + 64),vld1q_u8(table + 80),vld1q_u8(table + 96),vld1q_u8(table + 112)}};
+    const uint8x16x4_t t2 = {{vld1q_u8(table + 128),vld1q_u8(table + 144),vld1q_u8(table + 160),vld1q_u8(table + 176)}};
+    const uint8x16x4_t t3 = {{vld1q_u8(table + 192),vld1q_u8(table + 208),vld1q_u8(table + 224),vld1q_u8(table + 240)}};
+    const uint8x16_t step = vdupq_n_u8(64);
+    size_t i = 0;
+    for(; i + 16 <= size; i += 16){
+        uint8x16_t x = vld1q_u8(src + i);
+        uint8x16_t r = vqtbl4q_u8(t0,x);
+        x = vsubq_u8(x,step);
+        r = vqtbx4q_u8(r,t1,x);
+        x = vsubq_u8(x,step);
+        r = vqtbx4q_u8(r,t2,x);
+        x = vsubq_u8(x,step);
+        r = vqtbx4q_u8(r,t3,x);
+        vst1q_u8(dst + i,r);
+    }
+    for(; i < size; i++){
+        dst[i] = table[src[i]];
+    }
+}
+#endif
+#endif
+
+struct g711_kernel_t{
+    g711_decode_func alaw_decode;
+    g711_encode_func alaw_encode;
+    g711_decode_func ulaw_decode;
+    g711_encode_func ulaw_encode;
+    g711_transcode_func alaw_to_ulaw;
+    g711_transcode_func ulaw_to_alaw;
+    const char* name;
+};
+
+static g711_kernel_t select_g711_kernel(){
+#if defined(G711_SIMD_KERNEL) && defined(__x86_64__)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_AVX2)){
+        return {g711_decode_avx2<alaw_decode_epi16_avx2,alaw2linear>,
+                g711_encode_avx2<alaw_encode_epi16_avx2,linear2alaw>,
+                g711_decode_avx2<ulaw_decode_epi16_avx2,ulaw2linear>,
+                g711_encode_avx2<ulaw_encode_epi16_avx2,linear2ulaw>,
+                g711_transcode_avx2<alaw_to_ulaw_table>,
+                g711_transcode_avx2<ulaw_to_alaw_table>,
+                "avx2"};
+    }
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_SSSE3)){
+        return {g711_decode_ssse3<alaw_decode_epi16_ssse3,alaw2linear>,
+                g711_encode_ssse3<alaw_encode_epi16_ssse3,linear2alaw>,
+                g711_decode_ssse3<ulaw_decode_epi16_ssse3,ulaw2linear>,
+                g711_encode_ssse3<ulaw_encode_epi16_ssse3,linear2ulaw>,
+                g711_transcode_ssse3<alaw_to_ulaw_table>,
+                g711_transcode_ssse3<ulaw_to_alaw_table>,
+                "ssse3"};
+    }
+#elif defined(G711_SIMD_KERNEL) && defined(__ARM_NEON)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_NEON)){
+        return {g711_decode_neon<alaw_decode_s16_neon,alaw2linear>,
+                g711_encode_neon<alaw_encode_u16_neon,linear2alaw>,
+                g711_decode_neon<ulaw_decode_s16_neon,ulaw2linear>,
+                g711_encode_neon<ulaw_encode_u16_neon,linear2ulaw>,
+#if defined(__aarch64__)
+                g711_transcode_neon<alaw_to_ulaw_table>,
+                g711_transcode_neon<ulaw_to_alaw_table>,
+#else
+                alaw_to_ulaw_c,
+                ulaw_to_alaw_c,
+#endif
+                "neon"};
+    }
+#endif
+    return {alaw_decode_c,alaw_encode_c,ulaw_decode_c,ulaw_encode_c,alaw_to_ulaw_c,ulaw_to_alaw_c,"c"};
+}
+
+static const g711_kernel_t& g711_kernel_selected(){
+    // cpuid checked only once
+    static const g711_kernel_t selected = select_g711_kernel();
+    return selected;
+}
+
+void alaw_decode(const uint8_t* alaw,size_t size,int16_t* linear){
+    g711_kernel_selected().alaw_decode(alaw,size,linear);
+}
+
+void alaw_encode(const int16_t* linear,size_t size,uint8_t* alaw){
+    g711_kernel_selected().alaw_encode(linear,size,alaw);
+}
+
+void ulaw_decode(const uint8_t* ulaw,size_t size,int16_t* linear){
+    g711_kernel_selected().ulaw_decode(ulaw,size,linear);
+}
+
+void ulaw_encode(const int16_t* linear,size_t size,uint8_t* ulaw){
+    g711_kernel_selected().ulaw_encode(linear,size,ulaw);
+}
+
+void alaw_to_ulaw(const uint8_t* alaw,size_t size,uint8_t* ulaw){
+    g711_kernel_selected().alaw_to_ulaw(alaw,size,ulaw);
+}
+
+void ulaw_to_alaw(const uint8_t* ulaw,size_t size,uint8_t* alaw){
+    g711_kernel_selected().ulaw_to_alaw(ulaw,size,alaw);
+}
+
+void alaw_to_ulaw(uint8_t* codes,size_t size){
+    g711_kernel_selected().alaw_to_ulaw(codes,size,codes);
+}
+
+void ulaw_to_alaw(uint8_t* codes,size_t size){
+    g711_kernel_selected().ulaw_to_alaw(codes,size,codes);
+}
+
+const char* g711_kernel(){
+    return g711_kernel_selected().name;
+}
 }
\ No newline at end of file
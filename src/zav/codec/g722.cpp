@@ -32,6 +32,12 @@
 #include "zav/codec/g722.h"
 #include <string.h>
 #include <zcf/zcf.h>
+#include "zcf/zcf_cpu.hpp"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #if !defined(FALSE)
 #define FALSE 0
@@ -260,6 +266,102 @@ static void reset_state(G722State* s,G722BitRateMode bitrate,G722SampleOption op
     s->band[1].det = 8;
 }
 
+/*
+ * QMF history,x[2i] and x[2i + 1] of the reference are kept in their own ring,
+ * every sample is written twice(at pos and pos + 12),so the 12 taps are always
+ * contiguous from qmf_pos and nothing is shuffled per sample
+ */
+static inline void g722_qmf_push(G722State* s,int x22,int x23)
+{
+    s->qmf_even[s->qmf_pos] = s->qmf_even[s->qmf_pos + 12] = (int16_t) x22;
+    s->qmf_odd[s->qmf_pos] = s->qmf_odd[s->qmf_pos + 12] = (int16_t) x23;
+    s->qmf_pos = (s->qmf_pos + 1) % 12;
+}
+
+/* taps for x[2i] and x[2i + 1],zero padded for 16 lanes loads */
+static constexpr int16_t qmf_even_taps[16] =
+    {
+           3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11,
+           0,    0,    0,    0
+    };
+static constexpr int16_t qmf_odd_taps[16] =
+    {
+         -11,   53, -156,  362, -805, 3876,  951, -210,   32,   12,  -11,    3,
+           0,    0,    0,    0
+    };
+
+typedef void (*g722_qmf_func)(const int16_t* even,const int16_t* odd,int* even_sum,int* odd_sum);
+
+static void g722_qmf_c(const int16_t* even,const int16_t* odd,int* even_sum,int* odd_sum)
+{
+    int sum_even = 0;
+    int sum_odd = 0;
+    for (int i = 0;  i < 12;  i++)
+    {
+        sum_even += even[i]*qmf_coeffs[i];
+        sum_odd += odd[i]*qmf_coeffs[11 - i];
+    }
+    *even_sum = sum_even;
+    *odd_sum = sum_odd;
+}
+
+#if defined(__x86_64__)
+// 16bit products never overflow the 32bit pair sums,so madd is exact
+Z_TARGET_ATTR("avx2")
+static void g722_qmf_avx2(const int16_t* even,const int16_t* odd,int* even_sum,int* odd_sum)
+{
+    // lanes 12~15 read the ring padding,their taps are 0
+    __m256i pe = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)even),
+                                   _mm256_loadu_si256((const __m256i*)qmf_even_taps));
+    __m256i po = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)odd),
+                                   _mm256_loadu_si256((const __m256i*)qmf_odd_taps));
+    // [e e o o | e e o o] -> [e o e o | e o e o]
+    __m256i sum = _mm256_hadd_epi32(pe,po);
+    sum = _mm256_hadd_epi32(sum,sum);
+    __m128i r = _mm_add_epi32(_mm256_castsi256_si128(sum),_mm256_extracti128_si256(sum,1));
+    *even_sum = _mm_cvtsi128_si32(r);
+    *odd_sum = _mm_extract_epi32(r,1);
+}
+#elif defined(__ARM_NEON)
+static void g722_qmf_neon(const int16_t* even,const int16_t* odd,int* even_sum,int* odd_sum)
+{
+    int32x4_t e = vmull_s16(vld1_s16(even),vld1_s16(qmf_even_taps));
+    e = vmlal_s16(e,vld1_s16(even + 4),vld1_s16(qmf_even_taps + 4));
+    e = vmlal_s16(e,vld1_s16(even + 8),vld1_s16(qmf_even_taps + 8));
+    int32x4_t o = vmull_s16(vld1_s16(odd),vld1_s16(qmf_odd_taps));
+    o = vmlal_s16(o,vld1_s16(odd + 4),vld1_s16(qmf_odd_taps + 4));
+    o = vmlal_s16(o,vld1_s16(odd + 8),vld1_s16(qmf_odd_taps + 8));
+    int32x2_t r = vpadd_s32(vadd_s32(vget_low_s32(e),vget_high_s32(e)),
+                            vadd_s32(vget_low_s32(o),vget_high_s32(o)));
+    *even_sum = vget_lane_s32(r,0);
+    *odd_sum = vget_lane_s32(r,1);
+}
+#endif
+
+static g722_qmf_func select_g722_qmf(){
+#if defined(__x86_64__)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_AVX2)){
+        return g722_qmf_avx2;
+    }
+#elif defined(__ARM_NEON)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_NEON)){
+        return g722_qmf_neon;
+    }
+#endif
+    return g722_qmf_c;
+}
+
+static g722_qmf_func g722_qmf_kernel_selected(){
+    // cpuid checked only once
+    static const g722_qmf_func selected = select_g722_qmf();
+    return selected;
+}
+
+/*
+ * bits_per_sample,packed and eight_k never change between Reset(),
+ * so the loops are specialized on them and picked once at Reset()
+ */
+template<int BITS,bool PACKED,bool EIGHT_K>
 static size_t g722_decode(G722DecoderState* s,
     const uint8_t* g722_data,size_t len,
     int16_t* amp){
@@ -275,50 +377,49 @@ static size_t g722_decode(G722DecoderState* s,
     int wd3;
     int code;
     size_t outlen;
-    int i;
     size_t j;
+    const g722_qmf_func qmf = g722_qmf_kernel_selected();
 
     outlen = 0;
     rhigh = 0;
     for (j = 0;  j < len;  )
     {
-        if (s->packed)
+        if (PACKED)
         {
             /* Unpack the code bits */
-            if (s->in_bits < s->bits_per_sample)
+            if (s->in_bits < BITS)
             {
                 s->in_buffer |= (g722_data[j++] << s->in_bits);
                 s->in_bits += 8;
             }
-            code = s->in_buffer & ((1 << s->bits_per_sample) - 1);
-            s->in_buffer >>= s->bits_per_sample;
-            s->in_bits -= s->bits_per_sample;
+            code = s->in_buffer & ((1 << BITS) - 1);
+            s->in_buffer >>= BITS;
+            s->in_bits -= BITS;
         }
         else
         {
             code = g722_data[j++];
         }
 
-        switch (s->bits_per_sample)
+        if (BITS == 8)
         {
-        default:
-        case 8:
             wd1 = code & 0x3F;
             ihigh = (code >> 6) & 0x03;
             wd2 = qm6[wd1];
             wd1 >>= 2;
-            break;
-        case 7:
+        }
+        else if (BITS == 7)
+        {
             wd1 = code & 0x1F;
             ihigh = (code >> 5) & 0x03;
             wd2 = qm5[wd1];
             wd1 >>= 1;
-            break;
-        case 6:
+        }
+        else
+        {
             wd1 = code & 0x0F;
             ihigh = (code >> 4) & 0x03;
             wd2 = qm4[wd1];
-            break;
         }
         /* Block 5L, LOW BAND INVQBL */
         wd2 = (s->band[0].det*wd2) >> 15;
@@ -352,7 +453,7 @@ static size_t g722_decode(G722DecoderState* s,
 
         block4(s, 0, dlowt);
 
-        if (!s->eight_k)
+        if (!EIGHT_K)
         {
             /* Block 2H, INVQAH */
             wd2 = qm2[ihigh];
@@ -391,25 +492,15 @@ static size_t g722_decode(G722DecoderState* s,
         }
         else
         {
-            if (s->eight_k)
+            if (EIGHT_K)
             {
                 amp[outlen++] = (int16_t) (rlow << 1);
             }
             else
             {
                 /* Apply the receive QMF */
-                for (i = 0;  i < 22;  i++)
-                    s->x[i] = s->x[i + 2];
-                s->x[22] = rlow + rhigh;
-                s->x[23] = rlow - rhigh;
-
-                xout1 = 0;
-                xout2 = 0;
-                for (i = 0;  i < 12;  i++)
-                {
-                    xout2 += s->x[2*i]*qmf_coeffs[i];
-                    xout1 += s->x[2*i + 1]*qmf_coeffs[11 - i];
-                }
+                g722_qmf_push(s,rlow + rhigh,rlow - rhigh);
+                qmf(s->qmf_even + s->qmf_pos,s->qmf_odd + s->qmf_pos,&xout2,&xout1);
                 /* We shift by 12 to allow for the QMF filters (DC gain = 4096), less 1
                    to allow for the 15 bit input to the G.722 algorithm. */
                 /* WebRtc, tlegrand: added saturation */
@@ -421,6 +512,7 @@ static size_t g722_decode(G722DecoderState* s,
     return outlen;
 }
 
+template<int BITS,bool PACKED,bool EIGHT_K>
 static size_t g722_encode(G722EncoderState* s,const int16_t* amp,size_t len,uint8_t* g722_data){
     int dlow;
     int dhigh;
@@ -447,6 +539,8 @@ static size_t g722_encode(G722EncoderState* s,const int16_t* amp,size_t len,uint
     int ilow;
     int code;
 
+    const g722_qmf_func qmf = g722_qmf_kernel_selected();
+
     g722_bytes = 0;
     xhigh = 0;
     for (j = 0;  j < len;  )
@@ -458,7 +552,7 @@ static size_t g722_encode(G722EncoderState* s,const int16_t* amp,size_t len,uint
         }
         else
         {
-            if (s->eight_k)
+            if (EIGHT_K)
             {
                 /* We shift by 1 to allow for the 15 bit input to the G.722 algorithm. */
                 xlow = amp[j++] >> 1;
@@ -466,20 +560,11 @@ static size_t g722_encode(G722EncoderState* s,const int16_t* amp,size_t len,uint
             else
             {
                 /* Apply the transmit QMF */
-                /* Shuffle the buffer down */
-                for (i = 0;  i < 22;  i++)
-                    s->x[i] = s->x[i + 2];
-                s->x[22] = amp[j++];
-                s->x[23] = amp[j++];
+                g722_qmf_push(s,amp[j],amp[j + 1]);
+                j += 2;
 
                 /* Discard every other QMF output */
-                sumeven = 0;
-                sumodd = 0;
-                for (i = 0;  i < 12;  i++)
-                {
-                    sumodd += s->x[2*i]*qmf_coeffs[i];
-                    sumeven += s->x[2*i + 1]*qmf_coeffs[11 - i];
-                }
+                qmf(s->qmf_even + s->qmf_pos,s->qmf_odd + s->qmf_pos,&sumodd,&sumeven);
                 /* We shift by 12 to allow for the QMF filters (DC gain = 4096), plus 1
                    to allow for us summing two filters, plus 1 to allow for the 15 bit
                    input to the G.722 algorithm. */
@@ -532,10 +617,10 @@ static size_t g722_encode(G722EncoderState* s,const int16_t* amp,size_t len,uint
 
         block4(s, 0, dlow);
 
-        if (s->eight_k)
+        if (EIGHT_K)
         {
             /* Just leave the high bits as zero */
-            code = (0xC0 | ilow) >> (8 - s->bits_per_sample);
+            code = (0xC0 | ilow) >> (8 - BITS);
         }
         else
         {
@@ -568,14 +653,14 @@ static size_t g722_encode(G722EncoderState* s,const int16_t* amp,size_t len,uint
             s->band[1].det = wd3 << 2;
 
             block4(s, 1, dhigh);
-            code = ((ihigh << 6) | ilow) >> (8 - s->bits_per_sample);
+            code = ((ihigh << 6) | ilow) >> (8 - BITS);
         }
 
-        if (s->packed)
+        if (PACKED)
         {
             /* Pack the code bits */
             s->out_buffer |= (code << s->out_bits);
-            s->out_bits += s->bits_per_sample;
+            s->out_bits += BITS;
             if (s->out_bits >= 8)
             {
                 g722_data[g722_bytes++] = (uint8_t) (s->out_buffer & 0xFF);
@@ -591,6 +676,22 @@ static size_t g722_encode(G722EncoderState* s,const int16_t* amp,size_t len,uint
     return g722_bytes;
 }
 
+template<int BITS>
+static G722Decoder::decode_func select_g722_decode(const G722DecoderState* s){
+    if(s->packed){
+        return s->eight_k ? g722_decode<BITS,true,true> : g722_decode<BITS,true,false>;
+    }
+    return s->eight_k ? g722_decode<BITS,false,true> : g722_decode<BITS,false,false>;
+}
+
+template<int BITS>
+static G722Encoder::encode_func select_g722_encode(const G722EncoderState* s){
+    if(s->packed){
+        return s->eight_k ? g722_encode<BITS,true,true> : g722_encode<BITS,true,false>;
+    }
+    return s->eight_k ? g722_encode<BITS,false,true> : g722_encode<BITS,false,false>;
+}
+
 G722Decoder::G722Decoder(G722BitRateMode bitrate,G722SampleOption option){
     decoder_state_ = new G722DecoderState();
     Reset(bitrate,option);
@@ -604,10 +705,17 @@ G722Decoder::~G722Decoder(){
 void G722Decoder::Reset(G722BitRateMode bitrate,G722SampleOption option){
     Z_ASSERT(decoder_state_);
     reset_state(decoder_state_,bitrate,option);
+    if(decoder_state_->bits_per_sample == 6){
+        decode_ = select_g722_decode<6>(decoder_state_);
+    }else if(decoder_state_->bits_per_sample == 7){
+        decode_ = select_g722_decode<7>(decoder_state_);
+    }else{
+        decode_ = select_g722_decode<8>(decoder_state_);
+    }
 }
 
 size_t G722Decoder::Decode(const uint8_t* g722_data,size_t len,int16_t* amp){
-    return g722_decode(decoder_state_,g722_data,len,amp);
+    return decode_(decoder_state_,g722_data,len,amp);
 }
 
 G722Encoder::G722Encoder(G722BitRateMode bitrate,G722SampleOption option){
@@ -621,12 +729,757 @@ G722Encoder::~G722Encoder(){
 }
 
 size_t G722Encoder::Encode(const int16_t* amp,size_t len,uint8_t* g722_data){
-    return g722_encode(encoder_state_,amp,len,g722_data);
+    return encode_(encoder_state_,amp,len,g722_data);
 }
 
 void G722Encoder::Reset(G722BitRateMode bitrate,G722SampleOption option){
     Z_ASSERT(encoder_state_);
     reset_state(encoder_state_,bitrate,option);
+    if(encoder_state_->bits_per_sample == 6){
+        encode_ = select_g722_encode<6>(encoder_state_);
+    }else if(encoder_state_->bits_per_sample == 7){
+        encode_ = select_g722_encode<7>(encoder_state_);
+    }else{
+        encode_ = select_g722_encode<8>(encoder_state_);
+    }
+}
+
+/*
+ * batch codec,many channels in structure of arrays
+ * the algorithm below is written once on lane traits(c 1 lane,avx2 8 lanes,neon 4 lanes),
+ * every simd kernel is flattened into one target function,so it is bitexact with
+ * g722_encode/g722_decode of each channel
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+// generic kernels are always flattened into the target function and never called
+// with the default abi.helpers returning vectors are lane members,gcc reports -Wpsabi
+// of a generic template at end of file,out of this push/pop
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define G722_FLATTEN __attribute__((flatten))
+#else
+#define G722_FLATTEN
+#endif
+
+// all channels move together,so the bit packer and qmf position are shared
+struct G722BatchState{
+    size_t channels;
+    // channels rounded up to G722_BATCH_ALIGN,padding lanes run on silence
+    size_t stride;
+    int packed;
+    int eight_k;
+    int bits_per_sample;
+    int in_bits;
+    int out_bits;
+    // qmf history ring position,see g722_batch_qmf
+    int qmf_pos;
+    // G722_BATCH_ROWS rows of stride int32
+    int32_t* rows;
+};
+
+static constexpr size_t G722_BATCH_ALIGN = 8;
+
+// rows of one band
+enum G722BatchBandRow{
+    G722_ROW_S = 0,
+    G722_ROW_SZ,
+    G722_ROW_R,                      // r[3]
+    G722_ROW_A = G722_ROW_R + 3,     // a[3]
+    G722_ROW_P = G722_ROW_A + 3,     // p[3]
+    G722_ROW_D = G722_ROW_P + 3,     // d[7]
+    G722_ROW_B = G722_ROW_D + 7,     // b[7]
+    G722_ROW_NB = G722_ROW_B + 7,
+    G722_ROW_DET,
+    G722_BAND_ROWS
+};
+
+// band[0],band[1],bit buffer,qmf history of 2 * 24 samples
+static constexpr size_t G722_ROW_BITS = 2 * G722_BAND_ROWS;
+static constexpr size_t G722_ROW_QMF = G722_ROW_BITS + 1;
+static constexpr size_t G722_BATCH_ROWS = G722_ROW_QMF + 48;
+
+struct g722_lanes_c{
+    typedef int32_t v;
+    static constexpr size_t LANES = 1;
+
+    static inline v load(const int32_t* p){ return *p; }
+    static inline void store(int32_t* p,v x){ *p = x; }
+    static inline v set1(int32_t x){ return x; }
+    static inline v add(v a,v b){ return a + b; }
+    static inline v sub(v a,v b){ return a - b; }
+    static inline v mul(v a,v b){ return a * b; }
+    static inline v and_(v a,v b){ return a & b; }
+    static inline v or_(v a,v b){ return a | b; }
+    static inline v sra(v a,int n){ return a >> n; }
+    static inline v sll(v a,int n){ return (v)((uint32_t)a << n); }
+    static inline v srl(v a,int n){ return (v)((uint32_t)a >> n); }
+    // n > 0 right,n < 0 left
+    static inline v shift(v a,v n){ return (n < 0) ? (v)((uint32_t)a << -n) : (a >> n); }
+    static inline v min(v a,v b){ return a < b ? a : b; }
+    static inline v max(v a,v b){ return a > b ? a : b; }
+    static inline v cmpeq(v a,v b){ return -(v)(a == b); }
+    static inline v cmplt(v a,v b){ return -(v)(a < b); }
+    static inline v select(v mask,v a,v b){ return mask ? a : b; }
+    static inline v gather(const int* table,v index){ return table[index]; }
+    static inline v clamp(v x,int32_t lo,int32_t hi){ return min(max(x,lo),hi); }
+    static inline v saturate(v x){ return clamp(x,WEBRTC_INT16_MIN,WEBRTC_INT16_MAX); }
+};
+
+#if defined(__x86_64__)
+struct g722_lanes_avx2{
+    typedef __m256i v;
+    static constexpr size_t LANES = 8;
+
+    Z_TARGET_ATTR("avx2") static inline v load(const int32_t* p){ return _mm256_loadu_si256((const __m256i*)p); }
+    Z_TARGET_ATTR("avx2") static inline void store(int32_t* p,v x){ _mm256_storeu_si256((__m256i*)p,x); }
+    Z_TARGET_ATTR("avx2") static inline v set1(int32_t x){ return _mm256_set1_epi32(x); }
+    Z_TARGET_ATTR("avx2") static inline v add(v a,v b){ return _mm256_add_epi32(a,b); }
+    Z_TARGET_ATTR("avx2") static inline v sub(v a,v b){ return _mm256_sub_epi32(a,b); }
+    Z_TARGET_ATTR("avx2") static inline v mul(v a,v b){ return _mm256_mullo_epi32(a,b); }
+    Z_TARGET_ATTR("avx2") static inline v and_(v a,v b){ return _mm256_and_si256(a,b); }
+    Z_TARGET_ATTR("avx2") static inline v or_(v a,v b){ return _mm256_or_si256(a,b); }
+    Z_TARGET_ATTR("avx2") static inline v sra(v a,int n){ return _mm256_sra_epi32(a,_mm_cvtsi32_si128(n)); }
+    Z_TARGET_ATTR("avx2") static inline v sll(v a,int n){ return _mm256_sll_epi32(a,_mm_cvtsi32_si128(n)); }
+    Z_TARGET_ATTR("avx2") static inline v srl(v a,int n){ return _mm256_srl_epi32(a,_mm_cvtsi32_si128(n)); }
+    Z_TARGET_ATTR("avx2") static inline v shift(v a,v n){
+        v left = _mm256_sllv_epi32(a,_mm256_sub_epi32(_mm256_setzero_si256(),n));
+        return _mm256_blendv_epi8(_mm256_srav_epi32(a,n),left,n);
+    }
+    Z_TARGET_ATTR("avx2") static inline v min(v a,v b){ return _mm256_min_epi32(a,b); }
+    Z_TARGET_ATTR("avx2") static inline v max(v a,v b){ return _mm256_max_epi32(a,b); }
+    Z_TARGET_ATTR("avx2") static inline v cmpeq(v a,v b){ return _mm256_cmpeq_epi32(a,b); }
+    Z_TARGET_ATTR("avx2") static inline v cmplt(v a,v b){ return _mm256_cmpgt_epi32(b,a); }
+    Z_TARGET_ATTR("avx2") static inline v select(v mask,v a,v b){ return _mm256_blendv_epi8(b,a,mask); }
+    Z_TARGET_ATTR("avx2") static inline v gather(const int* table,v index){ return _mm256_i32gather_epi32(table,index,4); }
+    Z_TARGET_ATTR("avx2") static inline v clamp(v x,int32_t lo,int32_t hi){ return min(max(x,set1(lo)),set1(hi)); }
+    Z_TARGET_ATTR("avx2") static inline v saturate(v x){ return clamp(x,WEBRTC_INT16_MIN,WEBRTC_INT16_MAX); }
+};
+#endif
+
+#if defined(__ARM_NEON)
+struct g722_lanes_neon{
+    typedef int32x4_t v;
+    static constexpr size_t LANES = 4;
+
+    static inline v load(const int32_t* p){ return vld1q_s32(p); }
+    static inline void store(int32_t* p,v x){ vst1q_s32(p,x); }
+    static inline v set1(int32_t x){ return vdupq_n_s32(x); }
+    static inline v add(v a,v b){ return vaddq_s32(a,b); }
+    static inline v sub(v a,v b){ return vsubq_s32(a,b); }
+    static inline v mul(v a,v b){ return vmulq_s32(a,b); }
+    static inline v and_(v a,v b){ return vandq_s32(a,b); }
+    static inline v or_(v a,v b){ return vorrq_s32(a,b); }
+    static inline v sra(v a,int n){ return vshlq_s32(a,vdupq_n_s32(-n)); }
+    static inline v sll(v a,int n){ return vshlq_s32(a,vdupq_n_s32(n)); }
+    static inline v srl(v a,int n){ return vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_s32(a),vdupq_n_s32(-n))); }
+    static inline v shift(v a,v n){ return vshlq_s32(a,vnegq_s32(n)); }
+    static inline v min(v a,v b){ return vminq_s32(a,b); }
+    static inline v max(v a,v b){ return vmaxq_s32(a,b); }
+    static inline v cmpeq(v a,v b){ return vreinterpretq_s32_u32(vceqq_s32(a,b)); }
+    static inline v cmplt(v a,v b){ return vreinterpretq_s32_u32(vcltq_s32(a,b)); }
+    static inline v select(v mask,v a,v b){ return vbslq_s32(vreinterpretq_u32_s32(mask),a,b); }
+    // no gather on neon
+    static inline v gather(const int* table,v index){
+        int32_t i[4];
+        vst1q_s32(i,index);
+        int32_t r[4] = {table[i[0]],table[i[1]],table[i[2]],table[i[3]]};
+        return vld1q_s32(r);
+    }
+    static inline v clamp(v x,int32_t lo,int32_t hi){ return min(max(x,set1(lo)),set1(hi)); }
+    static inline v saturate(v x){ return clamp(x,WEBRTC_INT16_MIN,WEBRTC_INT16_MAX); }
+};
+#endif
+
+template<class V>
+struct g722_batch_band{
+    typedef typename V::v v;
+    v s;
+    v sz;
+    v r[3];
+    v a[3];
+    v p[3];
+    v d[7];
+    v b[7];
+    v nb;
+    v det;
+
+    void load(const int32_t* rows,size_t stride){
+        s = V::load(rows + G722_ROW_S * stride);
+        sz = V::load(rows + G722_ROW_SZ * stride);
+        for(int i = 0; i < 3; i++){
+            r[i] = V::load(rows + (G722_ROW_R + i) * stride);
+            a[i] = V::load(rows + (G722_ROW_A + i) * stride);
+            p[i] = V::load(rows + (G722_ROW_P + i) * stride);
+        }
+        for(int i = 0; i < 7; i++){
+            d[i] = V::load(rows + (G722_ROW_D + i) * stride);
+            b[i] = V::load(rows + (G722_ROW_B + i) * stride);
+        }
+        nb = V::load(rows + G722_ROW_NB * stride);
+        det = V::load(rows + G722_ROW_DET * stride);
+    }
+
+    void store(int32_t* rows,size_t stride) const{
+        V::store(rows + G722_ROW_S * stride,s);
+        V::store(rows + G722_ROW_SZ * stride,sz);
+        for(int i = 0; i < 3; i++){
+            V::store(rows + (G722_ROW_R + i) * stride,r[i]);
+            V::store(rows + (G722_ROW_A + i) * stride,a[i]);
+            V::store(rows + (G722_ROW_P + i) * stride,p[i]);
+        }
+        for(int i = 0; i < 7; i++){
+            V::store(rows + (G722_ROW_D + i) * stride,d[i]);
+            V::store(rows + (G722_ROW_B + i) * stride,b[i]);
+        }
+        V::store(rows + G722_ROW_NB * stride,nb);
+        V::store(rows + G722_ROW_DET * stride,det);
+    }
+};
+
+// same as block4
+template<class V>
+static inline void g722_batch_block4(g722_batch_band<V>& band,const typename V::v& d){
+    typedef typename V::v v;
+    const v zero = V::set1(0);
+    v wd1;
+    v wd2;
+    v wd3;
+
+    /* Block 4, RECONS */
+    band.d[0] = d;
+    band.r[0] = V::saturate(V::add(band.s,d));
+
+    /* Block 4, PARREC */
+    band.p[0] = V::saturate(V::add(band.sz,d));
+
+    /* Block 4, UPPOL2 */
+    v sg0 = V::sra(band.p[0],15);
+    v sg1 = V::sra(band.p[1],15);
+    v sg2 = V::sra(band.p[2],15);
+    wd1 = V::saturate(V::sll(band.a[1],2));
+    wd2 = V::select(V::cmpeq(sg0,sg1),V::sub(zero,wd1),wd1);
+    wd2 = V::min(wd2,V::set1(32767));
+    wd3 = V::select(V::cmpeq(sg0,sg2),V::set1(128),V::set1(-128));
+    wd3 = V::add(wd3,V::sra(wd2,7));
+    wd3 = V::add(wd3,V::sra(V::mul(band.a[2],V::set1(32512)),15));
+    v ap2 = V::clamp(wd3,-12288,12288);
+
+    /* Block 4, UPPOL1 */
+    wd1 = V::select(V::cmpeq(sg0,sg1),V::set1(192),V::set1(-192));
+    wd2 = V::sra(V::mul(band.a[1],V::set1(32640)),15);
+    v ap1 = V::saturate(V::add(wd1,wd2));
+    wd3 = V::saturate(V::sub(V::set1(15360),ap2));
+    ap1 = V::min(V::max(ap1,V::sub(zero,wd3)),wd3);
+
+    /* Block 4, UPZERO */
+    wd1 = V::select(V::cmpeq(d,zero),zero,V::set1(128));
+    sg0 = V::sra(d,15);
+    v bp[7];
+    for(int i = 1; i < 7; i++){
+        v sg = V::sra(band.d[i],15);
+        wd2 = V::select(V::cmpeq(sg,sg0),wd1,V::sub(zero,wd1));
+        wd3 = V::sra(V::mul(band.b[i],V::set1(32640)),15);
+        bp[i] = V::saturate(V::add(wd2,wd3));
+    }
+
+    /* Block 4, DELAYA */
+    for(int i = 6; i > 0; i--){
+        band.d[i] = band.d[i - 1];
+        band.b[i] = bp[i];
+    }
+    band.r[2] = band.r[1];
+    band.r[1] = band.r[0];
+    band.p[2] = band.p[1];
+    band.p[1] = band.p[0];
+    band.a[2] = ap2;
+    band.a[1] = ap1;
+
+    /* Block 4, FILTEP */
+    wd1 = V::saturate(V::add(band.r[1],band.r[1]));
+    wd1 = V::sra(V::mul(band.a[1],wd1),15);
+    wd2 = V::saturate(V::add(band.r[2],band.r[2]));
+    wd2 = V::sra(V::mul(band.a[2],wd2),15);
+    v sp = V::saturate(V::add(wd1,wd2));
+
+    /* Block 4, FILTEZ */
+    v sz = zero;
+    for(int i = 6; i > 0; i--){
+        wd1 = V::saturate(V::add(band.d[i],band.d[i]));
+        sz = V::add(sz,V::sra(V::mul(band.b[i],wd1),15));
+    }
+    band.sz = V::saturate(sz);
+
+    /* Block 4, PREDIC */
+    band.s = V::saturate(V::add(sp,band.sz));
+}
+
+// Block 3L/3H LOGSCL and SCALEL,return the new det
+template<class V>
+static inline void g722_batch_scale(g722_batch_band<V>& band,const typename V::v& wl_value,int32_t nb_max,int32_t det_shift){
+    typedef typename V::v v;
+    v nb = V::add(V::sra(V::mul(band.nb,V::set1(127)),7),wl_value);
+    band.nb = V::clamp(nb,0,nb_max);
+    v wd1 = V::and_(V::sra(band.nb,6),V::set1(31));
+    v wd2 = V::sub(V::set1(det_shift),V::sra(band.nb,11));
+    band.det = V::sll(V::shift(V::gather(ilb,wd1),wd2),2);
+}
+
+/*
+ * qmf history of 24 samples kept twice in 48 rows,a new pair is written at pos and pos + 24,
+ * then x[i] of the reference is rows[pos + 2 + i] and no shuffle is needed
+ */
+template<class V>
+static inline void g722_batch_qmf(int32_t* qmf,size_t stride,int pos,
+    const typename V::v& x22,const typename V::v& x23,typename V::v* even,typename V::v* odd){
+    typedef typename V::v v;
+    V::store(qmf + pos * stride,x22);
+    V::store(qmf + (pos + 24) * stride,x22);
+    V::store(qmf + (pos + 1) * stride,x23);
+    V::store(qmf + (pos + 25) * stride,x23);
+    const int32_t* x = qmf + (pos + 2) * stride;
+    v sum_even = V::set1(0);
+    v sum_odd = V::set1(0);
+    for(int i = 0; i < 12; i++){
+        sum_even = V::add(sum_even,V::mul(V::load(x + 2 * i * stride),V::set1(qmf_coeffs[i])));
+        sum_odd = V::add(sum_odd,V::mul(V::load(x + (2 * i + 1) * stride),V::set1(qmf_coeffs[11 - i])));
+    }
+    *even = sum_even;
+    *odd = sum_odd;
+}
+
+template<class V>
+static size_t g722_batch_decode_group(G722BatchState* s,size_t group,
+    const uint8_t* const* g722_data,size_t len,int16_t* const* amp,
+    int* in_bits_io,int* qmf_pos_io){
+    typedef typename V::v v;
+    const size_t stride = s->stride;
+    const size_t first = group * V::LANES;
+    const size_t lanes = (s->channels - first) < V::LANES ? (s->channels - first) : V::LANES;
+    int32_t* rows = s->rows + first;
+    int32_t* qmf = rows + G722_ROW_QMF * stride;
+    int32_t io[V::LANES];
+
+    g722_batch_band<V> low;
+    g722_batch_band<V> high;
+    low.load(rows,stride);
+    high.load(rows + G722_BAND_ROWS * stride,stride);
+    v in_buffer = V::load(rows + G722_ROW_BITS * stride);
+    int in_bits = *in_bits_io;
+    int qmf_pos = *qmf_pos_io;
+    const int bits = s->bits_per_sample;
+
+    size_t outlen = 0;
+    v rhigh = V::set1(0);
+    for(size_t j = 0; j < len; ){
+        v code;
+        if(s->packed){
+            /* Unpack the code bits */
+            if(in_bits < bits){
+                for(size_t c = 0; c < V::LANES; c++){
+                    io[c] = c < lanes ? g722_data[first + c][j] : 0;
+                }
+                j++;
+                in_buffer = V::or_(in_buffer,V::sll(V::load(io),in_bits));
+                in_bits += 8;
+            }
+            code = V::and_(in_buffer,V::set1((1 << bits) - 1));
+            in_buffer = V::srl(in_buffer,bits);
+            in_bits -= bits;
+        }else{
+            for(size_t c = 0; c < V::LANES; c++){
+                io[c] = c < lanes ? g722_data[first + c][j] : 0;
+            }
+            j++;
+            code = V::load(io);
+        }
+
+        v wd1;
+        v wd2;
+        v ihigh;
+        switch(bits){
+        default:
+        case 8:
+            wd1 = V::and_(code,V::set1(0x3F));
+            ihigh = V::and_(V::sra(code,6),V::set1(0x03));
+            wd2 = V::gather(qm6,wd1);
+            wd1 = V::sra(wd1,2);
+            break;
+        case 7:
+            wd1 = V::and_(code,V::set1(0x1F));
+            ihigh = V::and_(V::sra(code,5),V::set1(0x03));
+            wd2 = V::gather(qm5,wd1);
+            wd1 = V::sra(wd1,1);
+            break;
+        case 6:
+            wd1 = V::and_(code,V::set1(0x0F));
+            ihigh = V::and_(V::sra(code,4),V::set1(0x03));
+            wd2 = V::gather(qm4,wd1);
+            break;
+        }
+        /* Block 5L, LOW BAND INVQBL */
+        wd2 = V::sra(V::mul(low.det,wd2),15);
+        /* Block 5L, RECONS, Block 6L, LIMIT */
+        v rlow = V::clamp(V::add(low.s,wd2),-16384,16383);
+
+        /* Block 2L, INVQAL */
+        v dlowt = V::sra(V::mul(low.det,V::gather(qm4,wd1)),15);
+
+        /* Block 3L, LOGSCL, SCALEL */
+        g722_batch_scale<V>(low,V::gather(wl,V::gather(rl42,wd1)),18432,8);
+
+        g722_batch_block4<V>(low,dlowt);
+
+        if(!s->eight_k){
+            /* Block 2H, INVQAH */
+            v dhigh = V::sra(V::mul(high.det,V::gather(qm2,ihigh)),15);
+            /* Block 5H, RECONS, Block 6H, LIMIT */
+            rhigh = V::clamp(V::add(dhigh,high.s),-16384,16383);
+
+            /* Block 3H, LOGSCH, SCALEH */
+            g722_batch_scale<V>(high,V::gather(wh,V::gather(rh2,ihigh)),22528,10);
+
+            g722_batch_block4<V>(high,dhigh);
+        }
+
+        if(s->eight_k){
+            V::store(io,V::sll(rlow,1));
+            for(size_t c = 0; c < lanes; c++){
+                amp[first + c][outlen] = (int16_t)io[c];
+            }
+            outlen++;
+        }else{
+            /* Apply the receive QMF */
+            v xout1;
+            v xout2;
+            g722_batch_qmf<V>(qmf,stride,qmf_pos,V::add(rlow,rhigh),V::sub(rlow,rhigh),&xout2,&xout1);
+            qmf_pos = (qmf_pos + 2) % 24;
+            V::store(io,V::saturate(V::sra(xout1,11)));
+            for(size_t c = 0; c < lanes; c++){
+                amp[first + c][outlen] = (int16_t)io[c];
+            }
+            V::store(io,V::saturate(V::sra(xout2,11)));
+            for(size_t c = 0; c < lanes; c++){
+                amp[first + c][outlen + 1] = (int16_t)io[c];
+            }
+            outlen += 2;
+        }
+    }
+
+    low.store(rows,stride);
+    high.store(rows + G722_BAND_ROWS * stride,stride);
+    V::store(rows + G722_ROW_BITS * stride,in_buffer);
+    *in_bits_io = in_bits;
+    *qmf_pos_io = qmf_pos;
+    return outlen;
+}
+
+template<class V>
+static size_t g722_batch_encode_group(G722BatchState* s,size_t group,
+    const int16_t* const* amp,size_t len,uint8_t* const* g722_data,
+    int* out_bits_io,int* qmf_pos_io){
+    typedef typename V::v v;
+    const size_t stride = s->stride;
+    const size_t first = group * V::LANES;
+    const size_t lanes = (s->channels - first) < V::LANES ? (s->channels - first) : V::LANES;
+    int32_t* rows = s->rows + first;
+    int32_t* qmf = rows + G722_ROW_QMF * stride;
+    int32_t io[V::LANES];
+    const v zero = V::set1(0);
+
+    g722_batch_band<V> low;
+    g722_batch_band<V> high;
+    low.load(rows,stride);
+    high.load(rows + G722_BAND_ROWS * stride,stride);
+    v out_buffer = V::load(rows + G722_ROW_BITS * stride);
+    int out_bits = *out_bits_io;
+    int qmf_pos = *qmf_pos_io;
+    const int bits = s->bits_per_sample;
+
+    size_t g722_bytes = 0;
+    v xhigh = zero;
+    for(size_t j = 0; j < len; ){
+        v xlow;
+        if(s->eight_k){
+            for(size_t c = 0; c < V::LANES; c++){
+                io[c] = c < lanes ? amp[first + c][j] : 0;
+            }
+            j++;
+            /* We shift by 1 to allow for the 15 bit input to the G.722 algorithm. */
+            xlow = V::sra(V::load(io),1);
+        }else{
+            /* Apply the transmit QMF */
+            for(size_t c = 0; c < V::LANES; c++){
+                io[c] = c < lanes ? amp[first + c][j] : 0;
+            }
+            v x22 = V::load(io);
+            for(size_t c = 0; c < V::LANES; c++){
+                io[c] = c < lanes ? amp[first + c][j + 1] : 0;
+            }
+            v x23 = V::load(io);
+            j += 2;
+            v sumodd;
+            v sumeven;
+            g722_batch_qmf<V>(qmf,stride,qmf_pos,x22,x23,&sumodd,&sumeven);
+            qmf_pos = (qmf_pos + 2) % 24;
+            xlow = V::sra(V::add(sumeven,sumodd),14);
+            xhigh = V::sra(V::sub(sumeven,sumodd),14);
+        }
+        /* Block 1L, SUBTRA */
+        v el = V::saturate(V::sub(xlow,low.s));
+
+        /* Block 1L, QUANTL */
+        // thresholds grow with i,so the break index is 1 + count of passed ones
+        v negative = V::cmplt(el,zero);
+        v wd = V::select(negative,V::sub(V::set1(-1),el),el);
+        v index = V::set1(1);
+        for(int i = 1; i < 30; i++){
+            v wd1 = V::sra(V::mul(V::set1(q6[i]),low.det),12);
+            // wd >= wd1
+            index = V::sub(index,V::select(V::cmplt(wd,wd1),zero,V::set1(-1)));
+        }
+        v ilow = V::select(negative,V::gather(iln,index),V::gather(ilp,index));
+
+        /* Block 2L, INVQAL */
+        v ril = V::sra(ilow,2);
+        v dlow = V::sra(V::mul(low.det,V::gather(qm4,ril)),15);
+
+        /* Block 3L, LOGSCL, SCALEL */
+        g722_batch_scale<V>(low,V::gather(wl,V::gather(rl42,ril)),18432,8);
+
+        g722_batch_block4<V>(low,dlow);
+
+        v code;
+        if(s->eight_k){
+            /* Just leave the high bits as zero */
+            code = V::sra(V::or_(V::set1(0xC0),ilow),8 - bits);
+        }else{
+            /* Block 1H, SUBTRA */
+            v eh = V::saturate(V::sub(xhigh,high.s));
+
+            /* Block 1H, QUANTH */
+            v eh_negative = V::cmplt(eh,zero);
+            wd = V::select(eh_negative,V::sub(V::set1(-1),eh),eh);
+            v wd1 = V::sra(V::mul(V::set1(564),high.det),12);
+            v mih = V::select(V::cmplt(wd,wd1),V::set1(1),V::set1(2));
+            v ihigh = V::select(eh_negative,V::gather(ihn,mih),V::gather(ihp,mih));
+
+            /* Block 2H, INVQAH */
+            v dhigh = V::sra(V::mul(high.det,V::gather(qm2,ihigh)),15);
+
+            /* Block 3H, LOGSCH, SCALEH */
+            g722_batch_scale<V>(high,V::gather(wh,V::gather(rh2,ihigh)),22528,10);
+
+            g722_batch_block4<V>(high,dhigh);
+            code = V::sra(V::or_(V::sll(ihigh,6),ilow),8 - bits);
+        }
+
+        if(s->packed){
+            /* Pack the code bits */
+            out_buffer = V::or_(out_buffer,V::sll(code,out_bits));
+            out_bits += bits;
+            if(out_bits >= 8){
+                V::store(io,out_buffer);
+                for(size_t c = 0; c < lanes; c++){
+                    g722_data[first + c][g722_bytes] = (uint8_t)(io[c] & 0xFF);
+                }
+                g722_bytes++;
+                out_bits -= 8;
+                out_buffer = V::srl(out_buffer,8);
+            }
+        }else{
+            V::store(io,code);
+            for(size_t c = 0; c < lanes; c++){
+                g722_data[first + c][g722_bytes] = (uint8_t)io[c];
+            }
+            g722_bytes++;
+        }
+    }
+
+    low.store(rows,stride);
+    high.store(rows + G722_BAND_ROWS * stride,stride);
+    V::store(rows + G722_ROW_BITS * stride,out_buffer);
+    *out_bits_io = out_bits;
+    *qmf_pos_io = qmf_pos;
+    return g722_bytes;
+}
+
+// every group start from the shared bit/qmf position and end at the same one
+template<class V>
+static size_t g722_batch_decode(G722BatchState* s,const uint8_t* const* g722_data,size_t len,int16_t* const* amp){
+    size_t outlen = 0;
+    int in_bits = s->in_bits;
+    int qmf_pos = s->qmf_pos;
+    for(size_t group = 0; group * V::LANES < s->channels; group++){
+        in_bits = s->in_bits;
+        qmf_pos = s->qmf_pos;
+        outlen = g722_batch_decode_group<V>(s,group,g722_data,len,amp,&in_bits,&qmf_pos);
+    }
+    s->in_bits = in_bits;
+    s->qmf_pos = qmf_pos;
+    return outlen;
+}
+
+template<class V>
+static size_t g722_batch_encode(G722BatchState* s,const int16_t* const* amp,size_t len,uint8_t* const* g722_data){
+    size_t g722_bytes = 0;
+    int out_bits = s->out_bits;
+    int qmf_pos = s->qmf_pos;
+    for(size_t group = 0; group * V::LANES < s->channels; group++){
+        out_bits = s->out_bits;
+        qmf_pos = s->qmf_pos;
+        g722_bytes = g722_batch_encode_group<V>(s,group,amp,len,g722_data,&out_bits,&qmf_pos);
+    }
+    s->out_bits = out_bits;
+    s->qmf_pos = qmf_pos;
+    return g722_bytes;
+}
+
+typedef size_t (*g722_batch_decode_func)(G722BatchState* s,const uint8_t* const* g722_data,size_t len,int16_t* const* amp);
+typedef size_t (*g722_batch_encode_func)(G722BatchState* s,const int16_t* const* amp,size_t len,uint8_t* const* g722_data);
+
+struct g722_batch_kernel_t{
+    g722_batch_decode_func decode;
+    g722_batch_encode_func encode;
+    const char* name;
+};
+
+G722_FLATTEN
+static size_t g722_batch_decode_c(G722BatchState* s,const uint8_t* const* g722_data,size_t len,int16_t* const* amp){
+    return g722_batch_decode<g722_lanes_c>(s,g722_data,len,amp);
+}
+
+G722_FLATTEN
+static size_t g722_batch_encode_c(G722BatchState* s,const int16_t* const* amp,size_t len,uint8_t* const* g722_data){
+    return g722_batch_encode<g722_lanes_c>(s,amp,len,g722_data);
+}
+
+#if defined(__x86_64__)
+Z_TARGET_ATTR("avx2") G722_FLATTEN
+static size_t g722_batch_decode_avx2(G722BatchState* s,const uint8_t* const* g722_data,size_t len,int16_t* const* amp){
+    return g722_batch_decode<g722_lanes_avx2>(s,g722_data,len,amp);
+}
+
+Z_TARGET_ATTR("avx2") G722_FLATTEN
+static size_t g722_batch_encode_avx2(G722BatchState* s,const int16_t* const* amp,size_t len,uint8_t* const* g722_data){
+    return g722_batch_encode<g722_lanes_avx2>(s,amp,len,g722_data);
+}
+#elif defined(__ARM_NEON)
+G722_FLATTEN
+static size_t g722_batch_decode_neon(G722BatchState* s,const uint8_t* const* g722_data,size_t len,int16_t* const* amp){
+    return g722_batch_decode<g722_lanes_neon>(s,g722_data,len,amp);
+}
+
+G722_FLATTEN
+static size_t g722_batch_encode_neon(G722BatchState* s,const int16_t* const* amp,size_t len,uint8_t* const* g722_data){
+    return g722_batch_encode<g722_lanes_neon>(s,amp,len,g722_data);
+}
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+static g722_batch_kernel_t select_g722_batch_kernel(){
+#if defined(__x86_64__)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_AVX2)){
+        return {g722_batch_decode_avx2,g722_batch_encode_avx2,"avx2"};
+    }
+#elif defined(__ARM_NEON)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_NEON)){
+        return {g722_batch_decode_neon,g722_batch_encode_neon,"neon"};
+    }
+#endif
+    return {g722_batch_decode_c,g722_batch_encode_c,"c"};
+}
+
+static const g722_batch_kernel_t& g722_batch_kernel_selected(){
+    // cpuid checked only once
+    static const g722_batch_kernel_t selected = select_g722_batch_kernel();
+    return selected;
+}
+
+const char* g722_batch_kernel(){
+    return g722_batch_kernel_selected().name;
+}
+
+static G722BatchState* create_batch_state(size_t channels){
+    Z_ASSERT(channels > 0);
+    G722BatchState* s = new G722BatchState();
+    s->channels = channels;
+    s->stride = (channels + G722_BATCH_ALIGN - 1) / G722_BATCH_ALIGN * G722_BATCH_ALIGN;
+    s->rows = new int32_t[G722_BATCH_ROWS * s->stride];
+    return s;
+}
+
+static void destroy_batch_state(G722BatchState* s){
+    delete[] s->rows;
+    delete s;
+}
+
+static void reset_batch_state(G722BatchState* s,G722BitRateMode bitrate,G722SampleOption option){
+    // same options as reset_state
+    G722State single;
+    reset_state(&single,bitrate,option);
+    s->packed = single.packed;
+    s->eight_k = single.eight_k;
+    s->bits_per_sample = single.bits_per_sample;
+    s->in_bits = 0;
+    s->out_bits = 0;
+    s->qmf_pos = 0;
+    ::memset(s->rows,0,G722_BATCH_ROWS * s->stride * sizeof(int32_t));
+    for(size_t c = 0; c < s->stride; c++){
+        s->rows[G722_ROW_DET * s->stride + c] = single.band[0].det;
+        s->rows[(G722_BAND_ROWS + G722_ROW_DET) * s->stride + c] = single.band[1].det;
+    }
+}
+
+G722BatchDecoder::G722BatchDecoder(size_t channels,G722BitRateMode bitrate,G722SampleOption option){
+    state_ = create_batch_state(channels);
+    Reset(bitrate,option);
+}
+
+G722BatchDecoder::~G722BatchDecoder(){
+    destroy_batch_state(state_);
+    state_ = nullptr;
+}
+
+void G722BatchDecoder::Reset(G722BitRateMode bitrate,G722SampleOption option){
+    Z_ASSERT(state_);
+    reset_batch_state(state_,bitrate,option);
+}
+
+size_t G722BatchDecoder::Decode(const uint8_t* const* g722_data,size_t len,int16_t* const* amp){
+    return g722_batch_kernel_selected().decode(state_,g722_data,len,amp);
+}
+
+size_t G722BatchDecoder::channels() const{
+    return state_->channels;
+}
+
+G722BatchEncoder::G722BatchEncoder(size_t channels,G722BitRateMode bitrate,G722SampleOption option){
+    state_ = create_batch_state(channels);
+    Reset(bitrate,option);
+}
+
+G722BatchEncoder::~G722BatchEncoder(){
+    destroy_batch_state(state_);
+    state_ = nullptr;
+}
+
+void G722BatchEncoder::Reset(G722BitRateMode bitrate,G722SampleOption option){
+    Z_ASSERT(state_);
+    reset_batch_state(state_,bitrate,option);
+}
+
+size_t G722BatchEncoder::Encode(const int16_t* const* amp,size_t len,uint8_t* const* g722_data){
+    return g722_batch_kernel_selected().encode(state_,amp,len,g722_data);
+}
+
+size_t G722BatchEncoder::channels() const{
+    return state_->channels;
 }
 
 };//!namesapce zav
\ No newline at end of file
@@ -34,25 +34,18 @@
 #include <string.h>
 
 #include "zcf/memory.hpp"
+#include "zcf/zcf_cpu.hpp"
+#if defined(__x86_64__)
 #include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 namespace zav{
 
 namespace h26x{
 
 static const uint8_t h26x_start_prefix[3] = {0x00,0x00,0x01};
 
-/**
- *  @brief  Helper structure to simplify work with 256-bit registers.
- */
-typedef union sz_u256_vec_t {
-    __m256i ymm;
-    __m128i xmms[2];
-    uint64_t u64s[4];
-    uint32_t u32s[8];
-    uint16_t u16s[16];
-    uint8_t u8s[32];
-} sz_u256_vec_t;
-
 /**
  *  @brief  Helper structure to simplify work with 64-bit words.
  *  @see    sz_u64_load
@@ -64,20 +57,6 @@ typedef union sz_u64_vec_t {
     uint8_t u8s[8];
 } sz_u64_vec_t;
 
-/**
- *  @brief  Byte-level equality comparison between two 64-bit integers.
- *  @return 64-bit integer, where every top bit in each byte signifies a match.
- */
-sz_u64_vec_t _sz_u64_each_byte_equal(sz_u64_vec_t a, sz_u64_vec_t b) {
-    sz_u64_vec_t vec;
-    vec.u64 = ~(a.u64 ^ b.u64);
-    // The match is valid, if every bit within each byte is set.
-    // For that take the bottom 7 bits of each byte, add one to them,
-    // and if this sets the top bit to one, then all the 7 bits are ones as well.
-    vec.u64 = ((vec.u64 & 0x7F7F7F7F7F7F7F7Full) + 0x0101010101010101ull) & ((vec.u64 & 0x8080808080808080ull));
-    return vec;
-}
-
 /**
  *  @brief  3Byte-level equality comparison between two 64-bit integers.
  *  @return 64-bit integer, where every top bit in each 3byte signifies a match.
@@ -92,120 +71,6 @@ sz_u64_vec_t _sz_u64_each_3byte_equal(sz_u64_vec_t a, sz_u64_vec_t b) {
     return vec;
 }
 
-uint8_t* sz_find_byte_serial(uint8_t* h, size_t h_length, uint8_t* n) {
-
-    if (!h_length) return nullptr;
-    uint8_t* const h_end = h + h_length;
-
-    // Broadcast the n into every byte of a 64-bit integer to use SWAR
-    // techniques and process eight characters at a time.
-    sz_u64_vec_t h_vec, n_vec, match_vec;
-    match_vec.u64 = 0;
-    n_vec.u64 = (uint64_t)n[0] * 0x0101010101010101ull;
-    for (; h + 8 <= h_end; h += 8) {
-        h_vec.u64 = *(uint64_t const *)h;
-        match_vec = _sz_u64_each_byte_equal(h_vec, n_vec);
-        if (match_vec.u64) return h + __builtin_ctzll(match_vec.u64) / 8;
-    }
-
-    // Handle the misaligned tail.
-    for (; h < h_end; ++h)
-        if (*h == *n) return h;
-    return nullptr;
-}
-
-uint8_t* sz_find_byte_avx2(uint8_t* bytes, size_t sizeBytes) {
-    int mask;
-    sz_u256_vec_t h_vec, n_vec;
-    n_vec.ymm = _mm256_set1_epi8(h26x_start_prefix[0]);
-    
-    uint8_t* h = bytes;
-    size_t h_length = sizeBytes;
-    while (h_length >= 32) {
-        h_vec.ymm = _mm256_lddqu_si256((__m256i const *)h);
-        mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(h_vec.ymm, n_vec.ymm));
-        if (mask) return bytes + __builtin_ctz(mask);
-        h += 32, h_length -= 32;
-    }
-
-    return sz_find_byte_serial(h, h_length, (uint8_t*)h26x_start_prefix);
-}
-
-/**
- *  @brief  Chooses the offsets of the most interesting characters in a search needle.
- *
- *  Search throughput can significantly deteriorate if we are matching the wrong characters.
- *  Say the needle is "aXaYa", and we are comparing the first, second, and last character.
- *  If we use SIMD and compare many offsets at a time, comparing against "a" in every register is a waste.
- *
- *  Similarly, dealing with UTF8 inputs, we know that the lower bits of each character code carry more information.
- *  Cyrillic alphabet, for example, falls into [0x0410, 0x042F] code range for uppercase [А, Я], and
- *  into [0x0430, 0x044F] for lowercase [а, я]. Scanning through a text written in Russian, half of the
- *  bytes will carry absolutely no value and will be equal to 0x04.
- */
-void _sz_locate_needle_anomalies(uint8_t* start, size_t length, //
-                                             size_t *first, size_t *second, size_t *third) {
-    *first = 0;
-    *second = length / 2;
-    *third = length - 1;
-
-    //
-    int has_duplicates =                   //
-        start[*first] == start[*second] || //
-        start[*first] == start[*third] ||  //
-        start[*second] == start[*third];
-
-    // Loop through letters to find non-colliding variants.
-    if (length > 3 && has_duplicates) {
-        // Pivot the middle point right, until we find a character different from the first one.
-        for (; start[*second] == start[*first] && *second + 1 < *third; ++(*second)) {}
-        // Pivot the third (last) point left, until we find a different character.
-        for (; (start[*third] == start[*second] || start[*third] == start[*first]) && *third > (*second + 1);
-             --(*third)) {}
-    }
-
-    // TODO: Investigate alternative strategies for long needles.
-    // On very long needles we have the luxury to choose!
-    // Often dealing with UTF8, we will likely benfit from shifting the first and second characters
-    // further to the right, to achieve not only uniqness within the needle, but also avoid common
-    // rune prefixes of 2-, 3-, and 4-byte codes.
-    if (length > 8) {
-        // Pivot the first and second points right, until we find a character, that:
-        // > is different from others.
-        // > doesn't start with 0b'110x'xxxx - only 5 bits of relevant info.
-        // > doesn't start with 0b'1110'xxxx - only 4 bits of relevant info.
-        // > doesn't start with 0b'1111'0xxx - only 3 bits of relevant info.
-        //
-        // So we are practically searching for byte values that start with 0b0xxx'xxxx or 0b'10xx'xxxx.
-        // Meaning they fall in the range [0, 127] and [128, 191], in other words any unsigned int up to 191.
-        uint8_t const *start_u8 = (uint8_t const *)start;
-        size_t vibrant_first = *first, vibrant_second = *second, vibrant_third = *third;
-
-        // Let's begin with the seccond character, as the termination criterea there is more obvious
-        // and we may end up with more variants to check for the first candidate.
-        for (; (start_u8[vibrant_second] > 191 || start_u8[vibrant_second] == start_u8[vibrant_third]) &&
-               (vibrant_second + 1 < vibrant_third);
-             ++vibrant_second) {}
-
-        // Now check if we've indeed found a good candidate or should revert the `vibrant_second` to `second`.
-        if (start_u8[vibrant_second] < 191) { *second = vibrant_second; }
-        else { vibrant_second = *second; }
-
-        // Now check the first character.
-        for (; (start_u8[vibrant_first] > 191 || start_u8[vibrant_first] == start_u8[vibrant_second] ||
-                start_u8[vibrant_first] == start_u8[vibrant_third]) &&
-               (vibrant_first + 1 < vibrant_second);
-             ++vibrant_first) {}
-
-        // Now check if we've indeed found a good candidate or should revert the `vibrant_first` to `first`.
-        // We don't need to shift the third one when dealing with texts as the last byte of the text is
-        // also the last byte of a rune and contains the most information.
-        if (start_u8[vibrant_first] < 191) { *first = vibrant_first; }
-    }
-}
-
-
-
 uint8_t* _sz_find_3byte_serial(uint8_t* h, size_t h_length, uint8_t* n) {
 
     // This is an internal method, and the haystack is guaranteed to be at least 4 bytes long.
@@ -217,7 +82,8 @@ uint8_t* _sz_find_3byte_serial(uint8_t* h, size_t h_length, uint8_t* n) {
     sz_u64_vec_t matches0_vec, matches1_vec, matches2_vec, matches3_vec, matches4_vec;
     sz_u64_vec_t n_vec;
     n_vec.u64 = 0;
-    n_vec.u8s[0] = n[0], n_vec.u8s[1] = n[1], n_vec.u8s[2] = n[2], n_vec.u8s[3] = n[3];
+    // only 3 bytes of needle,the 4th byte must stay zero or the broadcast corrupts the second lane
+    n_vec.u8s[0] = n[0], n_vec.u8s[1] = n[1], n_vec.u8s[2] = n[2];
     n_vec.u64 *= 0x0000000001000001ull; // broadcast
 
     // This code simulates hyper-scalar execution, analyzing 8 offsets at a time using three 64-bit words.
@@ -253,121 +119,6 @@ uint8_t* _sz_find_3byte_serial(uint8_t* h, size_t h_length, uint8_t* n) {
     return nullptr;
 }
 
-uint8_t* sz_find_avx2(uint8_t* h, size_t h_length, uint8_t* n, size_t n_length) {
-
-    // This almost never fires, but it's better to be safe than sorry.
-    // if (h_length < n_length || !n_length) return SZ_NULL_CHAR;
-    // if (n_length == 1) return sz_find_byte_avx2(h, h_length, n);
-
-    // Pick the parts of the needle that are worth comparing.
-    size_t offset_first, offset_mid, offset_last;
-    _sz_locate_needle_anomalies(n, n_length, &offset_first, &offset_mid, &offset_last);
-
-    // Broadcast those characters into YMM registers.
-    int matches;
-    sz_u256_vec_t h_first_vec, h_mid_vec, h_last_vec, n_first_vec, n_mid_vec, n_last_vec;
-    n_first_vec.ymm = _mm256_set1_epi8(n[offset_first]);
-    n_mid_vec.ymm = _mm256_set1_epi8(n[offset_mid]);
-    n_last_vec.ymm = _mm256_set1_epi8(n[offset_last]);
-
-    // Scan through the string.
-    for (; h_length >= n_length + 32; h += 32, h_length -= 32) {
-        h_first_vec.ymm = _mm256_lddqu_si256((__m256i const *)(h + offset_first));
-        h_mid_vec.ymm = _mm256_lddqu_si256((__m256i const *)(h + offset_mid));
-        h_last_vec.ymm = _mm256_lddqu_si256((__m256i const *)(h + offset_last));
-        matches = _mm256_movemask_epi8(_mm256_cmpeq_epi8(h_first_vec.ymm, n_first_vec.ymm)) &
-                  _mm256_movemask_epi8(_mm256_cmpeq_epi8(h_mid_vec.ymm, n_mid_vec.ymm)) &
-                  _mm256_movemask_epi8(_mm256_cmpeq_epi8(h_last_vec.ymm, n_last_vec.ymm));
-        while (matches) {
-            int potential_offset = __builtin_ctz(matches);
-            if (memcmp(h + potential_offset, n, n_length) == 0) return h + potential_offset;
-            matches &= matches - 1;
-        }
-    }
-
-    return _sz_find_3byte_serial(h, h_length, n);
-}
-
-// sz_cptr_t sz_find_neon(sz_cptr_t h, sz_size_t h_length, sz_cptr_t n, sz_size_t n_length) {
-
-//     // This almost never fires, but it's better to be safe than sorry.
-//     if (h_length < n_length || !n_length) return SZ_NULL_CHAR;
-//     if (n_length == 1) return sz_find_byte_neon(h, h_length, n);
-
-//     // Scan through the string.
-//     // Assuming how tiny the Arm NEON registers are, we should avoid internal branches at all costs.
-//     // That's why, for smaller needles, we use different loops.
-//     if (n_length == 2) {
-//         // Broadcast needle characters into SIMD registers.
-//         sz_u64_t matches;
-//         sz_u128_vec_t h_first_vec, h_last_vec, n_first_vec, n_last_vec, matches_vec;
-//         // Dealing with 16-bit values, we can load 2 registers at a time and compare 31 possible offsets
-//         // in a single loop iteration.
-//         n_first_vec.u8x16 = vld1q_dup_u8((sz_u8_t const *)&n[0]);
-//         n_last_vec.u8x16 = vld1q_dup_u8((sz_u8_t const *)&n[1]);
-//         for (; h_length >= 17; h += 16, h_length -= 16) {
-//             h_first_vec.u8x16 = vld1q_u8((sz_u8_t const *)(h + 0));
-//             h_last_vec.u8x16 = vld1q_u8((sz_u8_t const *)(h + 1));
-//             matches_vec.u8x16 =
-//                 vandq_u8(vceqq_u8(h_first_vec.u8x16, n_first_vec.u8x16), vceqq_u8(h_last_vec.u8x16, n_last_vec.u8x16));
-//             matches = vreinterpretq_u8_u4(matches_vec.u8x16);
-//             if (matches) return h + sz_u64_ctz(matches) / 4;
-//         }
-//     }
-//     else if (n_length == 3) {
-//         // Broadcast needle characters into SIMD registers.
-//         sz_u64_t matches;
-//         sz_u128_vec_t h_first_vec, h_mid_vec, h_last_vec, n_first_vec, n_mid_vec, n_last_vec, matches_vec;
-//         // Comparing 24-bit values is a bumer. Being lazy, I went with the same approach
-//         // as when searching for string over 4 characters long. I only avoid the last comparison.
-//         n_first_vec.u8x16 = vld1q_dup_u8((sz_u8_t const *)&n[0]);
-//         n_mid_vec.u8x16 = vld1q_dup_u8((sz_u8_t const *)&n[1]);
-//         n_last_vec.u8x16 = vld1q_dup_u8((sz_u8_t const *)&n[2]);
-//         for (; h_length >= 18; h += 16, h_length -= 16) {
-//             h_first_vec.u8x16 = vld1q_u8((sz_u8_t const *)(h + 0));
-//             h_mid_vec.u8x16 = vld1q_u8((sz_u8_t const *)(h + 1));
-//             h_last_vec.u8x16 = vld1q_u8((sz_u8_t const *)(h + 2));
-//             matches_vec.u8x16 = vandq_u8(                           //
-//                 vandq_u8(                                           //
-//                     vceqq_u8(h_first_vec.u8x16, n_first_vec.u8x16), //
-//                     vceqq_u8(h_mid_vec.u8x16, n_mid_vec.u8x16)),
-//                 vceqq_u8(h_last_vec.u8x16, n_last_vec.u8x16));
-//             matches = vreinterpretq_u8_u4(matches_vec.u8x16);
-//             if (matches) return h + sz_u64_ctz(matches) / 4;
-//         }
-//     }
-//     else {
-//         // Pick the parts of the needle that are worth comparing.
-//         sz_size_t offset_first, offset_mid, offset_last;
-//         _sz_locate_needle_anomalies(n, n_length, &offset_first, &offset_mid, &offset_last);
-//         // Broadcast those characters into SIMD registers.
-//         sz_u64_t matches;
-//         sz_u128_vec_t h_first_vec, h_mid_vec, h_last_vec, n_first_vec, n_mid_vec, n_last_vec, matches_vec;
-//         n_first_vec.u8x16 = vld1q_dup_u8((sz_u8_t const *)&n[offset_first]);
-//         n_mid_vec.u8x16 = vld1q_dup_u8((sz_u8_t const *)&n[offset_mid]);
-//         n_last_vec.u8x16 = vld1q_dup_u8((sz_u8_t const *)&n[offset_last]);
-//         // Walk through the string.
-//         for (; h_length >= n_length + 16; h += 16, h_length -= 16) {
-//             h_first_vec.u8x16 = vld1q_u8((sz_u8_t const *)(h + offset_first));
-//             h_mid_vec.u8x16 = vld1q_u8((sz_u8_t const *)(h + offset_mid));
-//             h_last_vec.u8x16 = vld1q_u8((sz_u8_t const *)(h + offset_last));
-//             matches_vec.u8x16 = vandq_u8(                           //
-//                 vandq_u8(                                           //
-//                     vceqq_u8(h_first_vec.u8x16, n_first_vec.u8x16), //
-//                     vceqq_u8(h_mid_vec.u8x16, n_mid_vec.u8x16)),
-//                 vceqq_u8(h_last_vec.u8x16, n_last_vec.u8x16));
-//             matches = vreinterpretq_u8_u4(matches_vec.u8x16);
-//             while (matches) {
-//                 int potential_offset = sz_u64_ctz(matches) / 4;
-//                 if (sz_equal(h + potential_offset, n, n_length)) return h + potential_offset;
-//                 matches &= matches - 1;
-//             }
-//         }
-//     }
-
-//     return sz_find_serial(h, h_length, n, n_length);
-// }
-
 // two-way
 uint8_t* annexb_find_start_memmem(const uint8_t* bytes,size_t sizeBytes)
 {
@@ -459,17 +210,218 @@ uint8_t* annexb_find_start_3byte(const uint8_t* bytes,size_t sizeBytes)
 {
     return _sz_find_3byte_serial((uint8_t*)bytes,sizeBytes,(uint8_t*)h26x_start_prefix);
 }
+/**
+ * dedicated kernels for the fixed 00 00 01 pattern work on 64 bytes block bit masks
+ * (bit i for byte i of block):
+ *   zero:  byte == 0x00
+ *   pair:  zero[i] && zero[i-1],a zero pair end at i
+ *   cand:  pair[i-1],byte i is the only place 0x01 can be
+ * a start code end at i when cand[i] && byte[i] == 0x01,and begin at i - 2.
+ * bit 63 of zero/pair is carried into the next block so start codes
+ * across blocks are found without overlapped loads.
+ * coded data rarely has zero pairs,so the 0x01 compare is mostly skipped.
+ */
+struct annexb_zero_carry{
+    uint64_t zero_hi;
+    uint64_t pair_hi;
+};
+
+static inline uint64_t annexb_start_candidates(uint64_t zero,annexb_zero_carry* carry){
+    uint64_t pair = zero & ((zero << 1) | carry->zero_hi);
+    uint64_t cand = (pair << 1) | carry->pair_hi;
+    carry->zero_hi = zero >> 63;
+    carry->pair_hi = pair >> 63;
+    return cand;
+}
+
+#if defined(__x86_64__)
+Z_TARGET_ATTR("sse4.2")
+static inline uint64_t annexb_eq_mask_sse42(const uint8_t* h,__m128i value){
+    uint64_t m0 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(h)),value));
+    uint64_t m1 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(h + 16)),value));
+    uint64_t m2 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(h + 32)),value));
+    uint64_t m3 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(h + 48)),value));
+    return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+}
+
+Z_TARGET_ATTR("sse4.2")
+uint8_t* annexb_find_start_sse42(const uint8_t* bytes,size_t sizeBytes)
+{
+    const uint8_t* h = bytes;
+    const uint8_t* const h_end = bytes + sizeBytes;
+    const __m128i zero_vec = _mm_setzero_si128();
+    const __m128i one_vec = _mm_set1_epi8(0x01);
+    annexb_zero_carry carry = {0,0};
+
+    for(; h + 64 <= h_end; h += 64){
+        uint64_t cand = annexb_start_candidates(annexb_eq_mask_sse42(h,zero_vec),&carry);
+        if(!cand) continue;
+        uint64_t ends = cand & annexb_eq_mask_sse42(h,one_vec);
+        if(ends) return (uint8_t*)(h + __builtin_ctzll(ends) - 2);
+    }
+
+    // the last two bytes of previous block may still begin a start code
+    const uint8_t* tail = (h - bytes >= 2) ? h - 2 : bytes;
+    return (uint8_t*)annexb_find_start_sbm(tail,h_end - tail);
+}
+
+Z_TARGET_ATTR("avx2")
+static inline uint64_t annexb_eq_mask_avx2(const uint8_t* h,__m256i value){
+    uint64_t m0 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(h)),value));
+    uint64_t m1 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(h + 32)),value));
+    return m0 | (m1 << 32);
+}
+
+Z_TARGET_ATTR("avx2")
 uint8_t* annexb_find_start_avx2(const uint8_t* bytes,size_t sizeBytes)
 {
-    return sz_find_avx2((uint8_t*)bytes,sizeBytes,(uint8_t*)h26x_start_prefix,3);
+    const uint8_t* h = bytes;
+    const uint8_t* const h_end = bytes + sizeBytes;
+    const __m256i zero_vec = _mm256_setzero_si256();
+    const __m256i one_vec = _mm256_set1_epi8(0x01);
+    annexb_zero_carry carry = {0,0};
+
+    for(; h + 64 <= h_end; h += 64){
+        uint64_t cand = annexb_start_candidates(annexb_eq_mask_avx2(h,zero_vec),&carry);
+        if(!cand) continue;
+        uint64_t ends = cand & annexb_eq_mask_avx2(h,one_vec);
+        if(ends) return (uint8_t*)(h + __builtin_ctzll(ends) - 2);
+    }
+
+    // the last two bytes of previous block may still begin a start code
+    const uint8_t* tail = (h - bytes >= 2) ? h - 2 : bytes;
+    return (uint8_t*)annexb_find_start_sbm(tail,h_end - tail);
+}
+
+Z_TARGET_ATTR("avx512f,avx512bw")
+uint8_t* annexb_find_start_avx512(const uint8_t* bytes,size_t sizeBytes)
+{
+    const uint8_t* h = bytes;
+    const uint8_t* const h_end = bytes + sizeBytes;
+    const __m512i zero_vec = _mm512_setzero_si512();
+    const __m512i one_vec = _mm512_set1_epi8(0x01);
+    annexb_zero_carry carry = {0,0};
+
+    for(; h + 64 <= h_end; h += 64){
+        __m512i h_vec = _mm512_loadu_si512((const void*)h);
+        uint64_t cand = annexb_start_candidates(_mm512_cmpeq_epi8_mask(h_vec,zero_vec),&carry);
+        if(!cand) continue;
+        uint64_t ends = cand & _mm512_cmpeq_epi8_mask(h_vec,one_vec);
+        if(ends) return (uint8_t*)(h + __builtin_ctzll(ends) - 2);
+    }
+
+    // masked load never touch bytes over the end,masked out bytes read as 0x00
+    size_t remain = h_end - h;
+    if(remain){
+        __mmask64 valid = _cvtu64_mask64((1ull << remain) - 1);
+        __m512i h_vec = _mm512_maskz_loadu_epi8(valid,(const void*)h);
+        uint64_t zero = _mm512_mask_cmpeq_epi8_mask(valid,h_vec,zero_vec);
+        uint64_t ends = annexb_start_candidates(zero,&carry) & _mm512_cmpeq_epi8_mask(h_vec,one_vec);
+        if(ends) return (uint8_t*)(h + __builtin_ctzll(ends) - 2);
+    }
+    return nullptr;
+}
+#endif
+
+#ifdef __ARM_NEON
+// 4 bits for each byte of a compare result,bit 4*i for byte i
+static inline uint64_t annexb_nibble_mask_neon(uint8x16_t eq){
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq),4)),0);
+}
+
+uint8_t* annexb_find_start_neon(const uint8_t* bytes,size_t sizeBytes)
+{
+    const uint8_t* h = bytes;
+    const uint8_t* const h_end = bytes + sizeBytes;
+    const uint8x16_t zero_vec = vdupq_n_u8(0x00);
+    const uint8x16_t one_vec = vdupq_n_u8(0x01);
+
+    // 16 positions each round need bytes [0,18),keep the next block loaded
+    if(sizeBytes >= 32){
+        uint8x16_t cur = vld1q_u8(h);
+        uint8x16_t cur_zero = vceqq_u8(cur,zero_vec);
+        for(; h + 32 <= h_end; h += 16){
+            uint8x16_t next = vld1q_u8(h + 16);
+            uint8x16_t next_zero = vceqq_u8(next,zero_vec);
+            // zero pair begin at i
+            uint8x16_t pair = vandq_u8(cur_zero,vextq_u8(cur_zero,next_zero,1));
+            if(annexb_nibble_mask_neon(pair)){
+                uint8x16_t third_one = vceqq_u8(vextq_u8(cur,next,2),one_vec);
+                uint64_t found = annexb_nibble_mask_neon(vandq_u8(pair,third_one));
+                if(found) return (uint8_t*)(h + (__builtin_ctzll(found) >> 2));
+            }
+            cur = next;
+            cur_zero = next_zero;
+        }
+    }
+
+    return (uint8_t*)annexb_find_start_sbm(h,h_end - h);
+}
+#endif
+
+typedef const uint8_t* (*annexb_find_start_func)(const uint8_t* bytes,size_t sizeBytes);
+
+struct annexb_find_start_kernel_t{
+    annexb_find_start_func find;
+    const char* name;
+};
+
+#if defined(__x86_64__)
+static const uint8_t* annexb_find_start_avx512_c(const uint8_t* bytes,size_t sizeBytes){
+    return annexb_find_start_avx512(bytes,sizeBytes);
+}
+static const uint8_t* annexb_find_start_avx2_c(const uint8_t* bytes,size_t sizeBytes){
+    return annexb_find_start_avx2(bytes,sizeBytes);
+}
+static const uint8_t* annexb_find_start_sse42_c(const uint8_t* bytes,size_t sizeBytes){
+    return annexb_find_start_sse42(bytes,sizeBytes);
+}
+#endif
+#ifdef __ARM_NEON
+static const uint8_t* annexb_find_start_neon_c(const uint8_t* bytes,size_t sizeBytes){
+    return annexb_find_start_neon(bytes,sizeBytes);
+}
+#endif
+
+static annexb_find_start_kernel_t select_annexb_find_start(){
+#if defined(__x86_64__)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_AVX512BW)){
+        return {annexb_find_start_avx512_c,"avx512"};
+    }
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_AVX2)){
+        return {annexb_find_start_avx2_c,"avx2"};
+    }
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_SSE42)){
+        return {annexb_find_start_sse42_c,"sse42"};
+    }
+#elif defined(__ARM_NEON)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_NEON)){
+        return {annexb_find_start_neon_c,"neon"};
+    }
+#endif
+    // sbm is portable and the fastest scalar one (memmem(two-way) only on linux glibc)
+    return {annexb_find_start_sbm,"sbm"};
+}
+
+static const annexb_find_start_kernel_t& annexb_find_start_kernel_selected(){
+    // cpuid checked only once
+    static const annexb_find_start_kernel_t selected = select_annexb_find_start();
+    return selected;
+}
+
+const uint8_t* annexb_find_start(const uint8_t* bytes,size_t sizeBytes){
+    return annexb_find_start_kernel_selected().find(bytes,sizeBytes);
+}
+
+const char* annexb_find_start_kernel(){
+    return annexb_find_start_kernel_selected().name;
 }
 
 const uint8_t* annexb_find_next_nalu_start(const uint8_t* bytes,size_t sizeBytes,NALU_PREFIX_SIZE* prefix){
     // 至少需要3字节，如果最后的字节是00 00 01也应该抛弃掉 
     if(sizeBytes < 3) return nullptr;
 
-    // default use sbm search (memmem(two-way) only on linux glibc)
-    const uint8_t* found = annexb_find_start_sbm(bytes,sizeBytes);
+    const uint8_t* found = annexb_find_start(bytes,sizeBytes);
     if(found){
         *prefix = NALU_PREFIX_SIZE::NALU_SHORT_PREFIX;
         if(found > bytes && *(found - 1) == 0x00){
@@ -480,98 +432,521 @@ const uint8_t* annexb_find_next_nalu_start(const uint8_t* bytes,size_t sizeBytes
     return found;
 }
 
+static inline void annexb_fill_nalu(h26x_nalu* nalu,const uint8_t* start,NALU_PREFIX_SIZE prefix,const uint8_t* end){
+    nalu->prefix = prefix;
+    nalu->start = start;
+    nalu->end = end;
+    nalu->header = (end >= start + prefix) ? start[prefix] : 0;
+}
+
 int annexb_find_next_nalu(const uint8_t* bytes,size_t sizeBytes,h26x_nalu* nalu){
     // 能判断NALU类型的至少需要4字节，少于4字节不可识别
     // (00) 00 00 01 xx(type) xx(data)
     if(sizeBytes < 4) return 0;
 
     // 第一次查找头
-    const uint8_t* p = bytes;
-    size_t remain_size = sizeBytes;
+    const uint8_t* pend = bytes + sizeBytes;
     zav::NALU_PREFIX_SIZE prefix;
-    const uint8_t* found = annexb_find_next_nalu_start(p,remain_size,&prefix);
+    const uint8_t* found = annexb_find_next_nalu_start(bytes,sizeBytes,&prefix);
     if(!found) return 0;
     
-    // 第二次查找头
-    nalu->prefix = prefix;
-    nalu->start = found;
-
-    p = found + prefix;
-    remain_size -= prefix;
-    found = annexb_find_next_nalu_start(p,remain_size,&prefix);
+    // 第二次查找头,从本nalu的头之后到buffer结尾
+    const uint8_t* start = found;
+    NALU_PREFIX_SIZE start_prefix = prefix;
+    const uint8_t* p = found + prefix;
+    found = annexb_find_next_nalu_start(p,pend - p,&prefix);
     if(!found){
         // 说明只有一个nalu
-        nalu->end = bytes + sizeBytes - 1;
+        annexb_fill_nalu(nalu,start,start_prefix,pend - 1);
         return 1;
     }
     // 说明后面还有
-    nalu->end = found - 1;
+    annexb_fill_nalu(nalu,start,start_prefix,found - 1);
     return 1;
 }
 
-};//!namepsace h26x
-
-const uint8_t* h264::annexb_skip_unsupported_nalu(const uint8_t* bytes,size_t sizeBytes){
-    const uint8_t* p = bytes;
+/**
+ * walk nalus of bytes,the start code found for a nalu also ends the one before,
+ * so each byte is scanned once.on_nalu return false to stop
+ */
+template<typename OnNalu>
+static size_t annexb_walk_nalus(const uint8_t* bytes,size_t sizeBytes,OnNalu&& on_nalu){
     const uint8_t* pend = bytes + sizeBytes;
-    const uint8_t* support = NULL;
+    NALU_PREFIX_SIZE prefix;
+    const uint8_t* start = annexb_find_next_nalu_start(bytes,sizeBytes,&prefix);
+    size_t count = 0;
+    while(start){
+        const uint8_t* p = start + prefix;
+        NALU_PREFIX_SIZE next_prefix = NALU_INVALID_PREFIX;
+        const uint8_t* next = annexb_find_next_nalu_start(p,pend - p,&next_prefix);
+
+        h26x_nalu nalu;
+        annexb_fill_nalu(&nalu,start,prefix,next ? next - 1 : pend - 1);
+        ++count;
+        if(!on_nalu(nalu)){
+            break;
+        }
+        start = next;
+        prefix = next_prefix;
+    }
+    return count;
+}
+
+size_t annexb_index_nalus(const uint8_t* bytes,size_t sizeBytes,std::vector<h26x_nalu>& nalus){
+    nalus.clear();
+    return annexb_walk_nalus(bytes,sizeBytes,[&nalus](const h26x_nalu& nalu){
+        nalus.push_back(nalu);
+        return true;
+    });
+}
+
+size_t annexb_index_nalus(const uint8_t* bytes,size_t sizeBytes,h26x_nalu* nalus,size_t max_nalus){
+    if(!max_nalus) return 0;
+    size_t filled = 0;
+    annexb_walk_nalus(bytes,sizeBytes,[nalus,max_nalus,&filled](const h26x_nalu& nalu){
+        nalus[filled++] = nalu;
+        return filled < max_nalus;
+    });
+    return filled;
+}
+
+annexb_stream_splitter::annexb_stream_splitter(on_nalu_t on_nalu)
+    :on_nalu_(std::move(on_nalu)),
+    chunk_start_(nullptr),
+    open_prefix_(NALU_INVALID_PREFIX),
+    opened_(false),
+    trailing_zeros_(0){
+
+}
+
+void annexb_stream_splitter::emit(const uint8_t* start,const uint8_t* end){
     h26x_nalu nalu;
-    while(p < pend){
-        int found = h26x::annexb_find_next_nalu(p, pend - p, &nalu);
-        if(found){
-            if(nalu.end > nalu.start + nalu.prefix){
-                // 有效的nalu
-                H264_NAL_UNIT_TYPE nalu_type = (H264_NAL_UNIT_TYPE)H264_NALU_TYPE(nalu.start[nalu.prefix]);
-                if(nalu_type == H264_NALU_SEI
-                    || nalu_type == H264_NALU_AUD
-                    || nalu_type == H264_NALU_UNSPECIFIED
-                    || nalu_type > H264_NALU_CODEC_SLICE_EXTENSION_3D_AVC
-                    ){
-                    // 0 6 9 22-31 skip
-                    p = nalu.end + 1;
-                    continue;
-                }
-                // 是IBP SPS PPS等等
-                support = nalu.start;
-                break;
+    annexb_fill_nalu(&nalu,start,open_prefix_,end);
+    if(on_nalu_){
+        on_nalu_(nalu);
+    }
+}
+
+void annexb_stream_splitter::close_nalu(const uint8_t* chunk,const uint8_t* cut,size_t trim){
+    if(!opened_) return;
+    if(chunk_start_){
+        // whole nalu in this chunk
+        emit(chunk_start_,cut - 1);
+        return;
+    }
+    // the next start code may begin in previous chunk,trim its zeros
+    pending_.resize(pending_.size() - trim);
+    pending_.insert(pending_.end(),chunk,cut);
+    emit(pending_.data(),pending_.data() + pending_.size() - 1);
+}
+
+void annexb_stream_splitter::open_nalu(const uint8_t* start,size_t before_chunk,NALU_PREFIX_SIZE prefix){
+    opened_ = true;
+    open_prefix_ = prefix;
+    if(before_chunk){
+        // prefix bytes in previous chunk are all 0x00
+        chunk_start_ = nullptr;
+        pending_.assign(before_chunk,0x00);
+    }else{
+        chunk_start_ = start;
+        pending_.clear();
+    }
+}
+
+void annexb_stream_splitter::push(const uint8_t* bytes,size_t sizeBytes){
+    if(!sizeBytes) return;
+    const uint8_t* pend = bytes + sizeBytes;
+    const uint8_t* search = bytes;
+
+    // start code across previous chunk and this one
+    // zeros:2+ chunk:01  or  zeros:1+ chunk:00 01
+    size_t before_chunk = 0;
+    NALU_PREFIX_SIZE across_prefix = NALU_SHORT_PREFIX;
+    if(trailing_zeros_ >= 2 && bytes[0] == 0x01){
+        before_chunk = trailing_zeros_ >= 3 ? 3 : 2;
+        across_prefix = before_chunk == 3 ? NALU_LONG_PREFIX : NALU_SHORT_PREFIX;
+        search = bytes + 1;
+    }else if(trailing_zeros_ >= 1 && sizeBytes >= 2 && bytes[0] == 0x00 && bytes[1] == 0x01){
+        before_chunk = trailing_zeros_ >= 2 ? 2 : 1;
+        across_prefix = before_chunk == 2 ? NALU_LONG_PREFIX : NALU_SHORT_PREFIX;
+        search = bytes + 2;
+    }
+    if(before_chunk){
+        close_nalu(bytes,bytes,before_chunk);
+        open_nalu(bytes,before_chunk,across_prefix);
+    }
+
+    // only new bytes are searched
+    while(search < pend){
+        NALU_PREFIX_SIZE prefix;
+        const uint8_t* found = annexb_find_next_nalu_start(search,pend - search,&prefix);
+        if(!found) break;
+        size_t found_before_chunk = 0;
+        if(found == bytes && prefix == NALU_SHORT_PREFIX && trailing_zeros_ >= 1){
+            // 00 | 00 00 01,the zero_byte is in previous chunk
+            found_before_chunk = 1;
+            prefix = NALU_LONG_PREFIX;
+        }
+        close_nalu(bytes,found,found_before_chunk);
+        open_nalu(found,found_before_chunk,prefix);
+        search = found + prefix - found_before_chunk;
+    }
+
+    // keep the open nalu,this chunk will be gone after return
+    if(opened_){
+        if(chunk_start_){
+            pending_.assign(chunk_start_,pend);
+            chunk_start_ = nullptr;
+        }else{
+            pending_.insert(pending_.end(),bytes,pend);
+        }
+    }
+
+    size_t zeros = 0;
+    while(zeros < 3 && zeros < sizeBytes && pend[-1 - (ptrdiff_t)zeros] == 0x00){
+        ++zeros;
+    }
+    if(zeros == sizeBytes){
+        // all zero chunk extend the previous zeros
+        zeros += trailing_zeros_;
+    }
+    trailing_zeros_ = zeros > 3 ? 3 : zeros;
+}
+
+void annexb_stream_splitter::flush(){
+    if(opened_ && !pending_.empty()){
+        emit(pending_.data(),pending_.data() + pending_.size() - 1);
+    }
+    reset();
+}
+
+void annexb_stream_splitter::reset(){
+    pending_.clear();
+    chunk_start_ = nullptr;
+    open_prefix_ = NALU_INVALID_PREFIX;
+    opened_ = false;
+    trailing_zeros_ = 0;
+}
+
+/**
+ * emulation prevention:0x03 is inserted after two 0x00 when next byte <= 0x03,
+ * so an ebsp 0x03 with two 0x00 before it is always dropped.
+ * it is the same pattern as start code with 0x03 as third byte,so the
+ * zero pair candidates of start code kernels are reused.
+ */
+static inline uint64_t ebsp_zero_state(const annexb_zero_carry& carry){
+    return carry.pair_hi ? 2 : carry.zero_hi;
+}
+
+static inline annexb_zero_carry ebsp_zero_carry(size_t zeros){
+    annexb_zero_carry carry = {zeros >= 1 ? 1u : 0u,zeros >= 2 ? 1u : 0u};
+    return carry;
+}
+
+// move [r,r + n) to w,skip the bytes marked in drop(bit i for r[i])
+static inline uint8_t* ebsp_copy_drop(uint8_t* w,const uint8_t* r,size_t n,uint64_t drop){
+    size_t from = 0;
+    while(drop){
+        size_t i = __builtin_ctzll(drop);
+        if(w != r + from) ::memmove(w,r + from,i - from);
+        w += i - from;
+        from = i + 1;
+        drop &= drop - 1;
+    }
+    if(w != r + from) ::memmove(w,r + from,n - from);
+    return w + (n - from);
+}
+
+static size_t ebsp_to_rbsp_tail(const uint8_t* r,const uint8_t* end,uint8_t* w,size_t zeros){
+    uint8_t* w_start = w;
+    for(; r < end; ++r){
+        if(zeros >= 2 && *r == 0x03){
+            zeros = 0;
+            continue;
+        }
+        zeros = *r ? 0 : zeros + 1;
+        *w++ = *r;
+    }
+    return w - w_start;
+}
+
+size_t ebsp_to_rbsp_c(const uint8_t* ebsp,size_t size,uint8_t* rbsp){
+    return ebsp_to_rbsp_tail(ebsp,ebsp + size,rbsp,0);
+}
+
+// insert 0x03 for [r,end),zeros is 0x00 count before r,return bytes written
+static size_t rbsp_to_ebsp_block(const uint8_t* r,const uint8_t* end,uint8_t* w,size_t* zeros){
+    uint8_t* w_start = w;
+    size_t z = *zeros;
+    for(; r < end; ++r){
+        if(z >= 2 && *r <= 0x03){
+            *w++ = 0x03;
+            z = 0;
+        }
+        z = *r ? 0 : z + 1;
+        *w++ = *r;
+    }
+    *zeros = z;
+    return w - w_start;
+}
+
+// ebsp end with 00 00(cabac_zero_word) need a final 0x03,
+// or the zeros will be taken as part of next start code
+static inline size_t rbsp_to_ebsp_final(size_t zeros,uint8_t* w){
+    if(zeros >= 2){
+        *w = 0x03;
+        return 1;
+    }
+    return 0;
+}
+
+size_t rbsp_to_ebsp_c(const uint8_t* rbsp,size_t size,uint8_t* ebsp){
+    size_t zeros = 0;
+    size_t written = rbsp_to_ebsp_block(rbsp,rbsp + size,ebsp,&zeros);
+    return written + rbsp_to_ebsp_final(zeros,ebsp + written);
+}
+
+#if defined(__x86_64__)
+Z_TARGET_ATTR("sse4.2")
+size_t ebsp_to_rbsp_sse42(const uint8_t* ebsp,size_t size,uint8_t* rbsp){
+    const uint8_t* r = ebsp;
+    const uint8_t* const end = ebsp + size;
+    uint8_t* w = rbsp;
+    const __m128i zero_vec = _mm_setzero_si128();
+    const __m128i three_vec = _mm_set1_epi8(0x03);
+    annexb_zero_carry carry = {0,0};
+    for(; r + 64 <= end; r += 64){
+        uint64_t cand = annexb_start_candidates(annexb_eq_mask_sse42(r,zero_vec),&carry);
+        uint64_t drop = cand ? cand & annexb_eq_mask_sse42(r,three_vec) : 0;
+        w = ebsp_copy_drop(w,r,64,drop);
+    }
+    return (w - rbsp) + ebsp_to_rbsp_tail(r,end,w,ebsp_zero_state(carry));
+}
+
+Z_TARGET_ATTR("sse4.2")
+size_t rbsp_to_ebsp_sse42(const uint8_t* rbsp,size_t size,uint8_t* ebsp){
+    const uint8_t* r = rbsp;
+    const uint8_t* const end = rbsp + size;
+    uint8_t* w = ebsp;
+    const __m128i zero_vec = _mm_setzero_si128();
+    // byte <= 0x03 equals byte == min(byte,0x03)
+    const __m128i three_vec = _mm_set1_epi8(0x03);
+    annexb_zero_carry carry = {0,0};
+    for(; r + 64 <= end; r += 64){
+        annexb_zero_carry block_carry = carry;
+        uint64_t cand = annexb_start_candidates(annexb_eq_mask_sse42(r,zero_vec),&carry);
+        if(cand){
+            uint64_t low = 0;
+            for(int i = 0; i < 4; i++){
+                __m128i v = _mm_loadu_si128((const __m128i*)(r + 16 * i));
+                low |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v,three_vec),v)) << (16 * i);
+            }
+            if(cand & low){
+                // an inserted 0x03 reset the zero count,so scalar for this block
+                size_t zeros = ebsp_zero_state(block_carry);
+                w += rbsp_to_ebsp_block(r,r + 64,w,&zeros);
+                carry = ebsp_zero_carry(zeros);
+                continue;
             }
-            // nalu.end == nalu.start + prefix 00 00 00 01 67没有后面的数据没有意义
-            p = nalu.end + 1;
+        }
+        _mm_storeu_si128((__m128i*)(w),_mm_loadu_si128((const __m128i*)(r)));
+        _mm_storeu_si128((__m128i*)(w + 16),_mm_loadu_si128((const __m128i*)(r + 16)));
+        _mm_storeu_si128((__m128i*)(w + 32),_mm_loadu_si128((const __m128i*)(r + 32)));
+        _mm_storeu_si128((__m128i*)(w + 48),_mm_loadu_si128((const __m128i*)(r + 48)));
+        w += 64;
+    }
+    size_t zeros = ebsp_zero_state(carry);
+    w += rbsp_to_ebsp_block(r,end,w,&zeros);
+    return (w - ebsp) + rbsp_to_ebsp_final(zeros,w);
+}
+
+Z_TARGET_ATTR("avx2")
+size_t ebsp_to_rbsp_avx2(const uint8_t* ebsp,size_t size,uint8_t* rbsp){
+    const uint8_t* r = ebsp;
+    const uint8_t* const end = ebsp + size;
+    uint8_t* w = rbsp;
+    const __m256i zero_vec = _mm256_setzero_si256();
+    const __m256i three_vec = _mm256_set1_epi8(0x03);
+    annexb_zero_carry carry = {0,0};
+    for(; r + 64 <= end; r += 64){
+        uint64_t cand = annexb_start_candidates(annexb_eq_mask_avx2(r,zero_vec),&carry);
+        uint64_t drop = cand ? cand & annexb_eq_mask_avx2(r,three_vec) : 0;
+        w = ebsp_copy_drop(w,r,64,drop);
+    }
+    return (w - rbsp) + ebsp_to_rbsp_tail(r,end,w,ebsp_zero_state(carry));
+}
+
+Z_TARGET_ATTR("avx2")
+size_t rbsp_to_ebsp_avx2(const uint8_t* rbsp,size_t size,uint8_t* ebsp){
+    const uint8_t* r = rbsp;
+    const uint8_t* const end = rbsp + size;
+    uint8_t* w = ebsp;
+    const __m256i zero_vec = _mm256_setzero_si256();
+    // byte <= 0x03 equals byte == min(byte,0x03)
+    const __m256i three_vec = _mm256_set1_epi8(0x03);
+    annexb_zero_carry carry = {0,0};
+    for(; r + 64 <= end; r += 64){
+        annexb_zero_carry block_carry = carry;
+        uint64_t cand = annexb_start_candidates(annexb_eq_mask_avx2(r,zero_vec),&carry);
+        __m256i v0 = _mm256_loadu_si256((const __m256i*)(r));
+        __m256i v1 = _mm256_loadu_si256((const __m256i*)(r + 32));
+        if(cand){
+            uint64_t low = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(v0,three_vec),v0)) |
+                ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(v1,three_vec),v1)) << 32);
+            if(cand & low){
+                // an inserted 0x03 reset the zero count,so scalar for this block
+                size_t zeros = ebsp_zero_state(block_carry);
+                w += rbsp_to_ebsp_block(r,r + 64,w,&zeros);
+                carry = ebsp_zero_carry(zeros);
+                continue;
+            }
+        }
+        _mm256_storeu_si256((__m256i*)(w),v0);
+        _mm256_storeu_si256((__m256i*)(w + 32),v1);
+        w += 64;
+    }
+    size_t zeros = ebsp_zero_state(carry);
+    w += rbsp_to_ebsp_block(r,end,w,&zeros);
+    return (w - ebsp) + rbsp_to_ebsp_final(zeros,w);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+// one bit for each byte of 64 bytes compare result
+static inline uint64_t annexb_eq_mask_neon(const uint8_t* h,uint8x16_t value){
+    static const uint8_t kBitWeights[16] = {1,2,4,8,16,32,64,128,1,2,4,8,16,32,64,128};
+    const uint8x16_t weights = vld1q_u8(kBitWeights);
+    uint8x16_t m0 = vandq_u8(vceqq_u8(vld1q_u8(h),value),weights);
+    uint8x16_t m1 = vandq_u8(vceqq_u8(vld1q_u8(h + 16),value),weights);
+    uint8x16_t m2 = vandq_u8(vceqq_u8(vld1q_u8(h + 32),value),weights);
+    uint8x16_t m3 = vandq_u8(vceqq_u8(vld1q_u8(h + 48),value),weights);
+    uint8x16_t sum = vpaddq_u8(vpaddq_u8(m0,m1),vpaddq_u8(m2,m3));
+    sum = vpaddq_u8(sum,sum);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum),0);
+}
+
+size_t ebsp_to_rbsp_neon(const uint8_t* ebsp,size_t size,uint8_t* rbsp){
+    const uint8_t* r = ebsp;
+    const uint8_t* const end = ebsp + size;
+    uint8_t* w = rbsp;
+    const uint8x16_t zero_vec = vdupq_n_u8(0x00);
+    const uint8x16_t three_vec = vdupq_n_u8(0x03);
+    annexb_zero_carry carry = {0,0};
+    for(; r + 64 <= end; r += 64){
+        uint64_t cand = annexb_start_candidates(annexb_eq_mask_neon(r,zero_vec),&carry);
+        uint64_t drop = cand ? cand & annexb_eq_mask_neon(r,three_vec) : 0;
+        w = ebsp_copy_drop(w,r,64,drop);
+    }
+    return (w - rbsp) + ebsp_to_rbsp_tail(r,end,w,ebsp_zero_state(carry));
+}
+
+size_t rbsp_to_ebsp_neon(const uint8_t* rbsp,size_t size,uint8_t* ebsp){
+    const uint8_t* r = rbsp;
+    const uint8_t* const end = rbsp + size;
+    uint8_t* w = ebsp;
+    const uint8x16_t zero_vec = vdupq_n_u8(0x00);
+    annexb_zero_carry carry = {0,0};
+    for(; r + 64 <= end; r += 64){
+        annexb_zero_carry block_carry = carry;
+        uint64_t cand = annexb_start_candidates(annexb_eq_mask_neon(r,zero_vec),&carry);
+        if(cand){
+            // bytes <= 0x03 are not tested by vector,the candidates are rare
+            size_t zeros = ebsp_zero_state(block_carry);
+            w += rbsp_to_ebsp_block(r,r + 64,w,&zeros);
+            carry = ebsp_zero_carry(zeros);
             continue;
         }
-        // not found has no nalu,skip
-        break;
+        vst1q_u8(w,vld1q_u8(r));
+        vst1q_u8(w + 16,vld1q_u8(r + 16));
+        vst1q_u8(w + 32,vld1q_u8(r + 32));
+        vst1q_u8(w + 48,vld1q_u8(r + 48));
+        w += 64;
+    }
+    size_t zeros = ebsp_zero_state(carry);
+    w += rbsp_to_ebsp_block(r,end,w,&zeros);
+    return (w - ebsp) + rbsp_to_ebsp_final(zeros,w);
+}
+#endif
+
+typedef size_t (*rbsp_convert_func)(const uint8_t* src,size_t size,uint8_t* dst);
+
+struct rbsp_kernel_t{
+    rbsp_convert_func to_rbsp;
+    rbsp_convert_func to_ebsp;
+};
+
+static rbsp_kernel_t select_rbsp_kernel(){
+#if defined(__x86_64__)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_AVX2)){
+        return {ebsp_to_rbsp_avx2,rbsp_to_ebsp_avx2};
+    }
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_SSE42)){
+        return {ebsp_to_rbsp_sse42,rbsp_to_ebsp_sse42};
     }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_NEON)){
+        return {ebsp_to_rbsp_neon,rbsp_to_ebsp_neon};
+    }
+#endif
+    return {ebsp_to_rbsp_c,rbsp_to_ebsp_c};
+}
+
+static const rbsp_kernel_t& rbsp_kernel_selected(){
+    static const rbsp_kernel_t selected = select_rbsp_kernel();
+    return selected;
+}
+
+size_t ebsp_to_rbsp(const uint8_t* ebsp,size_t size,uint8_t* rbsp){
+    return rbsp_kernel_selected().to_rbsp(ebsp,size,rbsp);
+}
+
+size_t rbsp_to_ebsp(const uint8_t* rbsp,size_t size,uint8_t* ebsp){
+    return rbsp_kernel_selected().to_ebsp(rbsp,size,ebsp);
+}
+
+};//!namepsace h26x
+
+const uint8_t* h264::annexb_skip_unsupported_nalu(const uint8_t* bytes,size_t sizeBytes){
+    const uint8_t* support = NULL;
+    h26x::annexb_walk_nalus(bytes,sizeBytes,[&support](const h26x_nalu& nalu){
+        // nalu.end == nalu.start + prefix 00 00 00 01 67没有后面的数据没有意义
+        if(nalu.end <= nalu.start + nalu.prefix){
+            return true;
+        }
+        // 有效的nalu
+        H264_NAL_UNIT_TYPE nalu_type = (H264_NAL_UNIT_TYPE)H264_NALU_TYPE(nalu.header);
+        if(nalu_type == H264_NALU_SEI
+            || nalu_type == H264_NALU_AUD
+            || nalu_type == H264_NALU_UNSPECIFIED
+            || nalu_type > H264_NALU_CODEC_SLICE_EXTENSION_3D_AVC
+            ){
+            // 0 6 9 22-31 skip
+            return true;
+        }
+        // 是IBP SPS PPS等等
+        support = nalu.start;
+        return false;
+    });
     return support;
 }
 
 const uint8_t* h265::annexb_skip_unsupported_nalu(const uint8_t* bytes,size_t sizeBytes){
-    const uint8_t* p = bytes;
-    const uint8_t* pend = bytes + sizeBytes;
     const uint8_t* support = NULL;
-    h26x_nalu nalu;
-    while(p < pend){
-        int found = h26x::annexb_find_next_nalu(p, pend - p, &nalu);
-        if(found){
-            if(nalu.end > nalu.start + nalu.prefix){
-                // 有效的nalu
-                H265_NAL_UNIT_TYPE nalu_type = (H265_NAL_UNIT_TYPE)H265_NALU_TYPE(nalu.start[nalu.prefix]);
-                if(nalu_type == H265_NALU_AUD || nalu_type > H265_NALU_PREFIX_SEI){
-                    // 35 39-xxxx skip
-                    p = nalu.end + 1;
-                    continue;
-                }
-                // 是IBP SPS PPS等等
-                support = nalu.start;
-                break;
-            }
-            // nalu.end == nalu.start + prefix 00 00 00 01 67没有后面的数据没有意义
-            p = nalu.end + 1;
-            continue;
+    h26x::annexb_walk_nalus(bytes,sizeBytes,[&support](const h26x_nalu& nalu){
+        // nalu.end == nalu.start + prefix 00 00 00 01 67没有后面的数据没有意义
+        if(nalu.end <= nalu.start + nalu.prefix){
+            return true;
         }
-        // not found has no nalu,skip
-        break;
-    }
+        // 有效的nalu
+        H265_NAL_UNIT_TYPE nalu_type = (H265_NAL_UNIT_TYPE)H265_NALU_TYPE(nalu.header);
+        if(nalu_type == H265_NALU_AUD || nalu_type > H265_NALU_PREFIX_SEI){
+            // 35 39-xxxx skip
+            return true;
+        }
+        // 是IBP SPS PPS等等
+        support = nalu.start;
+        return false;
+    });
     return support;
 }
 
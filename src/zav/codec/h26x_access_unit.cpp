@@ -0,0 +1,250 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+
+#include "zav/codec/h26x.h"
+
+#include "zcf/zcf_buffer.hpp"
+
+namespace zav{
+
+// enough for first_mb_in_slice/slice_type or h265 slice segment head
+#define H26X_SLICE_HEAD_SIZE 16
+
+/**
+ * reader of the head bytes of slice header(after nalu header)
+ */
+class slice_head_reader{
+public:
+    slice_head_reader(const h26x_nalu& nalu,size_t header_size)
+        :bits_(head_,unescape(nalu,header_size)){
+
+    }
+
+    zcf::bit_buffer& bits() { return bits_; }
+private:
+    size_t unescape(const h26x_nalu& nalu,size_t header_size){
+        size_t size = h26x::nalu_size(nalu);
+        if(size <= header_size){
+            return 0;
+        }
+        size -= header_size;
+        return h26x::ebsp_to_rbsp_c(h26x::nalu_data(nalu) + header_size,
+            size < H26X_SLICE_HEAD_SIZE ? size : H26X_SLICE_HEAD_SIZE,head_);
+    }
+private:
+    uint8_t head_[H26X_SLICE_HEAD_SIZE];
+    zcf::bit_buffer bits_;
+};
+
+static inline H26X_FRAME_TYPE merge_frame_type(H26X_FRAME_TYPE current,H26X_FRAME_TYPE slice){
+    return slice > current ? slice : current;
+}
+
+access_unit_builder::access_unit_builder(AVCodecID codec,on_frame_t on_frame)
+    :codec_(codec),on_frame_(on_frame),flags_(0),type_(H26X_FRAME_UNKNOWN),has_vcl_(false){
+
+}
+
+void access_unit_builder::push(const h26x_nalu& nalu){
+    if(!h26x::nalu_size(nalu)){
+        return;
+    }
+    if(codec_ == AV_CODEC_VIDEO_H265){
+        push_h265(nalu);
+    }else{
+        push_h264(nalu);
+    }
+}
+
+void access_unit_builder::push_h264(const h26x_nalu& nalu){
+    H264_NAL_UNIT_TYPE type = (H264_NAL_UNIT_TYPE)H264_NALU_TYPE(nalu.header);
+    H26X_FRAME_TYPE slice_type = H26X_FRAME_UNKNOWN;
+    bool first_slice = false;
+    // 17..18 reserved,not in H264_NAL_UNIT_TYPE
+    switch((uint8_t)type){
+        case H264_NALU_CODED_SLICE_NON_IDR:
+        case H264_NALU_CODED_SLICE_DATAPARTITIONA:
+        case H264_NALU_CODED_SLICE_IDR:{
+            // first_mb_in_slice slice_type
+            slice_head_reader reader(nalu,1);
+            first_slice = reader.bits().read_ue() == 0;
+            uint32_t value = reader.bits().read_ue();
+            if(!reader.bits().overrun() && value <= 9){
+                // P B I SP SI
+                static const H26X_FRAME_TYPE slice_types[5] = {
+                    H26X_FRAME_P,H26X_FRAME_B,H26X_FRAME_I,H26X_FRAME_P,H26X_FRAME_I
+                };
+                slice_type = slice_types[value % 5];
+            }
+            if(has_vcl_ && first_slice){
+                emit();
+            }
+            break;
+        }
+        case H264_NALU_SEI:
+        case H264_NALU_SPS:
+        case H264_NALU_PPS:
+        case H264_NALU_AUD:
+        case H264_NALU_PREFIX_NAL:
+        case H264_NALU_SUBSET_SPS:
+        case H264_NALU_DPS:
+        case 17:
+        case 18:
+            if(has_vcl_){
+                emit();
+            }
+            break;
+        default:
+            break;
+    }
+
+    nalus_.push_back(nalu);
+    switch(type){
+        case H264_NALU_CODED_SLICE_IDR:
+            flags_ |= H26X_FRAME_FLAG_KEY;
+            // fall through
+        case H264_NALU_CODED_SLICE_NON_IDR:
+        case H264_NALU_CODED_SLICE_DATAPARTITIONA:
+        case H264_NALU_CODED_SLICE_DATAPARTITIONB:
+        case H264_NALU_CODED_SLICE_DATAPARTITIONC:
+            has_vcl_ = true;
+            type_ = merge_frame_type(type_,slice_type);
+            break;
+        case H264_NALU_SPS:
+        case H264_NALU_PPS:
+            flags_ |= H26X_FRAME_FLAG_PARAM_SETS;
+            h264_params_.update(nalu);
+            break;
+        case H264_NALU_AUD:
+            flags_ |= H26X_FRAME_FLAG_AUD;
+            break;
+        default:
+            break;
+    }
+}
+
+void access_unit_builder::push_h265(const h26x_nalu& nalu){
+    H265_NAL_UNIT_TYPE type = (H265_NAL_UNIT_TYPE)H265_NALU_TYPE(nalu.header);
+    if(type <= H265_NALU_RSV_VCL31){
+        // first_slice_segment_in_pic_flag,slice_type only from the first segment
+        slice_head_reader reader(nalu,2);
+        zcf::bit_buffer& bits = reader.bits();
+        bool first_slice = bits.read_flag() && !bits.overrun();
+        if(has_vcl_ && first_slice){
+            emit();
+        }
+        has_vcl_ = true;
+        if(type >= H265_NALU_BLA_W_LP && type <= H265_NALU_RSV_IRAP_VCL23){
+            flags_ |= H26X_FRAME_FLAG_KEY;
+            bits.read_bit();// no_output_of_prior_pics_flag
+        }
+        if(first_slice){
+            const h265_pps* pps = h265_params_.pps(bits.read_ue());
+            bits.skip_bits(pps ? pps->num_extra_slice_header_bits : 0);
+            uint32_t value = bits.read_ue();
+            if(!bits.overrun() && value <= 2){
+                // B P I
+                static const H26X_FRAME_TYPE slice_types[3] = {
+                    H26X_FRAME_B,H26X_FRAME_P,H26X_FRAME_I
+                };
+                type_ = merge_frame_type(type_,slice_types[value]);
+            }
+        }
+        nalus_.push_back(nalu);
+        return;
+    }
+
+    switch(type){
+        case H265_NALU_VPS:
+        case H265_NALU_SPS:
+        case H265_NALU_PPS:
+        case H265_NALU_AUD:
+        case H265_NALU_PREFIX_SEI:
+        case H265_NALU_RSV_NVCL41:
+        case H265_NALU_RSV_NVCL42:
+        case H265_NALU_RSV_NVCL43:
+        case H265_NALU_RSV_NVCL44:
+            if(has_vcl_){
+                emit();
+            }
+            break;
+        default:
+            // 48..55 unspecified also begin access unit
+            if(type >= H265_NALU_UNSPEC48 && type <= H265_NALU_UNSPEC55 && has_vcl_){
+                emit();
+            }
+            break;
+    }
+    nalus_.push_back(nalu);
+    if(type == H265_NALU_VPS || type == H265_NALU_SPS || type == H265_NALU_PPS){
+        flags_ |= H26X_FRAME_FLAG_PARAM_SETS;
+        h265_params_.update(nalu);
+    }else if(type == H265_NALU_AUD){
+        flags_ |= H26X_FRAME_FLAG_AUD;
+    }
+}
+
+void access_unit_builder::emit(){
+    if(nalus_.empty()){
+        return;
+    }
+    h26x_frame frame;
+    frame.nalus = nalus_.data();
+    frame.nalu_count = nalus_.size();
+    frame.start = nalus_.front().start;
+    frame.end = nalus_.back().end;
+    frame.flags = flags_ | H26X_FRAME_FLAG_CONTIGUOUS;
+    frame.type = type_;
+    for(size_t i = 1;i < nalus_.size();i++){
+        if(nalus_[i].start != nalus_[i - 1].end + 1){
+            frame.flags &= ~H26X_FRAME_FLAG_CONTIGUOUS;
+            break;
+        }
+    }
+    if(on_frame_){
+        on_frame_(frame);
+    }
+    reset();
+}
+
+void access_unit_builder::flush(){
+    emit();
+}
+
+void access_unit_builder::reset(){
+    nalus_.clear();
+    flags_ = 0;
+    type_ = H26X_FRAME_UNKNOWN;
+    has_vcl_ = false;
+}
+
+};//!namespace zav
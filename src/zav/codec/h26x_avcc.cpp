@@ -0,0 +1,281 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+
+#include "zav/codec/h26x.h"
+#include <string.h>
+#include <zpkg/utility.h>
+
+#include "zcf/memory.hpp"
+#if defined(Z_SYS_LINUX)
+#include <sys/uio.h>
+#endif
+
+namespace zav{
+
+#if defined(Z_SYS_LINUX)
+static_assert(sizeof(av_iovec) == sizeof(struct iovec)
+    && offsetof(av_iovec,iov_base) == offsetof(struct iovec,iov_base)
+    && offsetof(av_iovec,iov_len) == offsetof(struct iovec,iov_len),"av_iovec must be layout of struct iovec");
+#endif
+
+size_t avcc_converter::convert(uint8_t* bytes,size_t sizeBytes){
+    iov_.clear();
+    data_ = nullptr;
+    in_place_ = false;
+    size_t count = h26x::annexb_index_nalus(bytes,sizeBytes,nalus_);
+    size_t avcc_size = 0;
+    size_t avcc_count = 0;
+    bool in_place = true;
+    for(const auto& nalu : nalus_){
+        size_t size = h26x::nalu_size_trimmed(nalu);
+        if(size){
+            avcc_size += 4 + size;
+            ++avcc_count;
+        }
+        // length replace start code only when nalus are back to back
+        in_place = in_place && nalu.prefix == NALU_LONG_PREFIX && size && size == h26x::nalu_size(nalu);
+    }
+    if(!avcc_count){
+        return 0;
+    }
+    if(in_place){
+        // nalus are continuous,00 00 00 01 -> length
+        for(const auto& nalu : nalus_){
+            Z_WBE32((uint8_t*)nalu.start,(uint32_t)h26x::nalu_size(nalu));
+        }
+        data_ = nalus_.front().start;
+        in_place_ = true;
+        return avcc_size;
+    }
+    // length headers are kept in lengths_,iov point to them after resize
+    lengths_.resize(avcc_count * 4);
+    iov_.resize(avcc_count * 2);
+    size_t k = 0;
+    for(size_t i = 0;i < count;i++){
+        const h26x_nalu& nalu = nalus_[i];
+        size_t size = h26x::nalu_size_trimmed(nalu);
+        if(!size){
+            continue;
+        }
+        uint8_t* length = lengths_.data() + k * 4;
+        Z_WBE32(length,(uint32_t)size);
+        iov_[k * 2].iov_base = length;
+        iov_[k * 2].iov_len = 4;
+        iov_[k * 2 + 1].iov_base = (void*)h26x::nalu_data(nalu);
+        iov_[k * 2 + 1].iov_len = size;
+        ++k;
+    }
+    return avcc_size;
+}
+
+namespace h26x{
+
+static inline size_t avcc_read_length(const uint8_t* p,int length_size){
+    switch(length_size){
+        case 1:
+            return p[0];
+        case 2:
+            return Z_RBE16(p);
+        default:
+            return Z_RBE32(p);
+    }
+}
+
+size_t avcc_to_annexb_size(const uint8_t* avcc,size_t sizeBytes,int length_size){
+    if(length_size != 1 && length_size != 2 && length_size != 4){
+        return 0;
+    }
+    size_t annexb_size = 0;
+    size_t offset = 0;
+    while(offset + length_size <= sizeBytes){
+        size_t length = avcc_read_length(avcc + offset,length_size);
+        offset += length_size;
+        if(length > sizeBytes - offset){
+            return 0;
+        }
+        offset += length;
+        annexb_size += 4 + length;
+    }
+    return offset == sizeBytes ? annexb_size : 0;
+}
+
+size_t avcc_to_annexb(const uint8_t* avcc,size_t sizeBytes,int length_size,uint8_t* annexb){
+    if(length_size != 1 && length_size != 2 && length_size != 4){
+        return 0;
+    }
+    uint8_t* w = annexb;
+    size_t offset = 0;
+    while(offset + length_size <= sizeBytes){
+        size_t length = avcc_read_length(avcc + offset,length_size);
+        offset += length_size;
+        if(length > sizeBytes - offset){
+            return 0;
+        }
+        Z_WBE32(w,0x00000001);
+        ::memcpy(w + 4,avcc + offset,length);
+        w += 4 + length;
+        offset += length;
+    }
+    return offset == sizeBytes ? (size_t)(w - annexb) : 0;
+}
+
+bool avcc_to_annexb_inplace(uint8_t* avcc,size_t sizeBytes){
+    size_t offset = 0;
+    while(offset + 4 <= sizeBytes){
+        size_t length = Z_RBE32(avcc + offset);
+        if(length > sizeBytes - offset - 4){
+            return false;
+        }
+        Z_WBE32(avcc + offset,0x00000001);
+        offset += 4 + length;
+    }
+    return offset == sizeBytes;
+}
+
+template<typename T,size_t N>
+static size_t count_param_sets(const param_set_entry<T> (&entries)[N]){
+    size_t count = 0;
+    for(const auto& entry : entries){
+        count += entry.valid ? 1 : 0;
+    }
+    return count;
+}
+
+/**
+ * 16 bits length + nalu of every valid entry
+ */
+template<typename T,size_t N>
+static void append_param_sets(const param_set_entry<T> (&entries)[N],std::vector<uint8_t>& record){
+    for(const auto& entry : entries){
+        if(!entry.valid){
+            continue;
+        }
+        uint8_t length[2];
+        Z_WBE16(length,(uint16_t)entry.ebsp.size());
+        record.insert(record.end(),length,length + 2);
+        record.insert(record.end(),entry.ebsp.begin(),entry.ebsp.end());
+    }
+}
+
+};//!namespace h26x
+
+bool h264_param_cache::build_avcc_record(std::vector<uint8_t>& record) const{
+    record.clear();
+    size_t sps_count = h26x::count_param_sets(sps_);
+    size_t pps_count = h26x::count_param_sets(pps_);
+    if(!sps_count || !pps_count || sps_count > 31){
+        return false;
+    }
+    const h264_sps* sps = nullptr;
+    for(const auto& entry : sps_){
+        if(entry.valid){
+            sps = &entry.param;
+            break;
+        }
+    }
+    record.push_back(1);// configurationVersion
+    record.push_back(sps->profile_idc);
+    record.push_back(sps->constraint_flags);
+    record.push_back(sps->level_idc);
+    record.push_back(0xFC | 3);// lengthSizeMinusOne
+    record.push_back((uint8_t)(0xE0 | sps_count));
+    h26x::append_param_sets(sps_,record);
+    record.push_back((uint8_t)pps_count);
+    h26x::append_param_sets(pps_,record);
+    if(sps->profile_idc == 100 || sps->profile_idc == 110
+        || sps->profile_idc == 122 || sps->profile_idc == 144){
+        record.push_back(0xFC | sps->chroma_format_idc);
+        record.push_back((uint8_t)(0xF8 | (sps->bit_depth_luma - 8)));
+        record.push_back((uint8_t)(0xF8 | (sps->bit_depth_chroma - 8)));
+        record.push_back(0);// numOfSequenceParameterSetExt
+    }
+    return true;
+}
+
+bool h265_param_cache::build_hvcc_record(std::vector<uint8_t>& record) const{
+    record.clear();
+    size_t vps_count = h26x::count_param_sets(vps_);
+    size_t sps_count = h26x::count_param_sets(sps_);
+    size_t pps_count = h26x::count_param_sets(pps_);
+    if(!vps_count || !sps_count || !pps_count){
+        return false;
+    }
+    const h265_sps* sps = nullptr;
+    for(const auto& entry : sps_){
+        if(entry.valid){
+            sps = &entry.param;
+            break;
+        }
+    }
+    const h265_profile_tier_level& ptl = sps->ptl;
+    uint8_t head[23];
+    head[0] = 1;// configurationVersion
+    head[1] = (uint8_t)((ptl.general_profile_space << 6) | (ptl.general_tier_flag << 5) | ptl.general_profile_idc);
+    Z_WBE32(head + 2,ptl.general_profile_compatibility_flags);
+    Z_WBE16(head + 6,(uint16_t)(ptl.general_constraint_indicator_flags >> 32));
+    Z_WBE32(head + 8,(uint32_t)ptl.general_constraint_indicator_flags);
+    head[12] = ptl.general_level_idc;
+    // reserved 1111 + min_spatial_segmentation_idc 0
+    head[13] = 0xF0;
+    head[14] = 0x00;
+    head[15] = 0xFC;// reserved 111111 + parallelismType 0
+    head[16] = (uint8_t)(0xFC | sps->chroma_format_idc);
+    head[17] = (uint8_t)(0xF8 | (sps->bit_depth_luma - 8));
+    head[18] = (uint8_t)(0xF8 | (sps->bit_depth_chroma - 8));
+    Z_WBE16(head + 19,0);// avgFrameRate
+    // constantFrameRate 0 numTemporalLayers temporalIdNested lengthSizeMinusOne 3
+    head[21] = (uint8_t)((sps->max_sub_layers << 3) | (sps->temporal_id_nesting_flag << 2) | 3);
+    head[22] = 3;// numOfArrays
+    record.assign(head,head + sizeof(head));
+
+    struct{
+        H265_NAL_UNIT_TYPE type;
+        size_t count;
+    } arrays[3] = {{H265_NALU_VPS,vps_count},{H265_NALU_SPS,sps_count},{H265_NALU_PPS,pps_count}};
+    for(const auto& array : arrays){
+        // array_completeness 1 + reserved 0 + NAL_unit_type
+        record.push_back((uint8_t)(0x80 | array.type));
+        uint8_t count[2];
+        Z_WBE16(count,(uint16_t)array.count);
+        record.insert(record.end(),count,count + 2);
+        if(array.type == H265_NALU_VPS){
+            h26x::append_param_sets(vps_,record);
+        }else if(array.type == H265_NALU_SPS){
+            h26x::append_param_sets(sps_,record);
+        }else{
+            h26x::append_param_sets(pps_,record);
+        }
+    }
+    return true;
+}
+
+};//!namespace zav
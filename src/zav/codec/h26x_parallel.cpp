@@ -0,0 +1,121 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+
+#include "zav/codec/h26x.h"
+#include <thread>
+
+namespace zav{
+
+namespace h26x{
+
+// chunk smaller than this is not worth a thread
+#ifndef H26X_PARALLEL_MIN_CHUNK
+#define H26X_PARALLEL_MIN_CHUNK (4 * 1024 * 1024)
+#endif
+
+/**
+ * find 00 00 01 beginning in [begin,chunk_end),the search may read 2 bytes
+ * over chunk_end for a start code across the edge
+ */
+static void annexb_chunk_starts(const uint8_t* begin,const uint8_t* chunk_end,const uint8_t* pend,
+    std::vector<const uint8_t*>& starts){
+    const uint8_t* search_end = (pend - chunk_end) > 2 ? chunk_end + 2 : pend;
+    const uint8_t* p = begin;
+    while(search_end - p >= 3){
+        const uint8_t* found = annexb_find_start(p,search_end - p);
+        if(!found || found >= chunk_end){
+            break;
+        }
+        starts.push_back(found);
+        p = found + 3;
+    }
+}
+
+size_t parallel_annexb_index(const uint8_t* bytes,size_t sizeBytes,std::vector<h26x_nalu>& nalus,size_t threads){
+    if(!threads){
+        threads = std::thread::hardware_concurrency();
+    }
+    size_t max_threads = sizeBytes / H26X_PARALLEL_MIN_CHUNK;
+    threads = threads < max_threads ? threads : max_threads;
+    if(threads <= 1){
+        return annexb_index_nalus(bytes,sizeBytes,nalus);
+    }
+
+    const uint8_t* pend = bytes + sizeBytes;
+    size_t chunk_size = sizeBytes / threads;
+    std::vector<std::vector<const uint8_t*>> chunk_starts(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for(size_t i = 1;i < threads;i++){
+        const uint8_t* begin = bytes + i * chunk_size;
+        const uint8_t* chunk_end = (i == threads - 1) ? pend : begin + chunk_size;
+        std::vector<const uint8_t*>& starts = chunk_starts[i];
+        workers.emplace_back([begin,chunk_end,pend,&starts](){
+            annexb_chunk_starts(begin,chunk_end,pend,starts);
+        });
+    }
+    // first chunk in caller thread
+    annexb_chunk_starts(bytes,bytes + chunk_size,pend,chunk_starts[0]);
+    for(auto& worker : workers){
+        worker.join();
+    }
+
+    // merge,00 before a start code is taken as long prefix like annexb_find_next_nalu_start
+    size_t count = 0;
+    for(const auto& starts : chunk_starts){
+        count += starts.size();
+    }
+    nalus.clear();
+    nalus.resize(count);
+    size_t index = 0;
+    for(const auto& starts : chunk_starts){
+        for(const uint8_t* found : starts){
+            h26x_nalu& nalu = nalus[index++];
+            nalu.prefix = NALU_SHORT_PREFIX;
+            nalu.start = found;
+            if(found > bytes && *(found - 1) == 0x00){
+                nalu.prefix = NALU_LONG_PREFIX;
+                --nalu.start;
+            }
+        }
+    }
+    for(size_t i = 0;i < count;i++){
+        h26x_nalu& nalu = nalus[i];
+        nalu.end = (i + 1 < count) ? nalus[i + 1].start - 1 : pend - 1;
+        nalu.header = (nalu.end >= nalu.start + nalu.prefix) ? nalu.start[nalu.prefix] : 0;
+    }
+    return count;
+}
+
+};//!namespace h26x
+
+};//!namespace zav
@@ -0,0 +1,983 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+
+#include "zav/codec/h26x.h"
+#include <string.h>
+
+#include "zcf/zcf_buffer.hpp"
+
+namespace zav{
+
+namespace h26x{
+/**
+ * rbsp of a parameter set nalu,point to the nalu itself(zero copy)
+ * when there is no emulation prevention byte
+ */
+class rbsp_view{
+public:
+    rbsp_view(const uint8_t* ebsp,size_t size){
+        if(!has_emulation_prevention(ebsp,size)){
+            data_ = ebsp;
+            size_ = size;
+            return;
+        }
+        uint8_t* rbsp = local_;
+        if(size > sizeof(local_)){
+            heap_.resize(size);
+            rbsp = heap_.data();
+        }
+        size_ = ebsp_to_rbsp(ebsp,size,rbsp);
+        data_ = rbsp;
+    }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+private:
+    static bool has_emulation_prevention(const uint8_t* bytes,size_t size){
+        for(size_t i = 2;i < size;i++){
+            if(bytes[i] == 0x03 && !bytes[i - 1] && !bytes[i - 2]){
+                return true;
+            }
+        }
+        return false;
+    }
+private:
+    const uint8_t* data_;
+    size_t size_;
+    uint8_t local_[512];
+    std::vector<uint8_t> heap_;
+};
+
+/**
+ * unescape head bytes of a parameter set nalu,for the id before compare
+ */
+#define H26X_PEEK_HEAD_SIZE 128
+static size_t rbsp_head(const uint8_t* nalu,size_t size,uint8_t* head){
+    return ebsp_to_rbsp_c(nalu,size < H26X_PEEK_HEAD_SIZE ? size : H26X_PEEK_HEAD_SIZE,head);
+}
+
+/**
+ * ue(v) at bit offset of a nalu
+ */
+static uint32_t peek_ue(const uint8_t* nalu,size_t size,size_t skip_bits){
+    uint8_t head[H26X_PEEK_HEAD_SIZE];
+    zcf::bit_buffer bits(head,rbsp_head(nalu,size,head));
+    bits.skip_bits(skip_bits);
+    uint32_t value = bits.read_ue();
+    return bits.overrun() ? UINT32_MAX : value;
+}
+
+/**
+ * parse unless same nalu bytes are cached in entry,
+ * parse(nalu,size,T*) return false when invalid
+ */
+template<typename T,typename Parse>
+static const T* update_param_set(param_set_entry<T>& entry,const uint8_t* nalu,size_t size,bool* changed,Parse&& parse){
+    if(entry.valid && entry.ebsp.size() == size && !::memcmp(entry.ebsp.data(),nalu,size)){
+        return &entry.param;
+    }
+    T param;
+    if(!parse(nalu,size,&param)){
+        return nullptr;
+    }
+    entry.ebsp.assign(nalu,nalu + size);
+    entry.param = param;
+    entry.valid = true;
+    if(changed){
+        *changed = true;
+    }
+    return &entry.param;
+}
+
+template<typename T,size_t N>
+static const T* find_param_set(const param_set_entry<T> (&entries)[N],uint32_t id){
+    if(id >= N || !entries[id].valid){
+        return nullptr;
+    }
+    return &entries[id].param;
+}
+
+template<typename T,size_t N>
+static void reset_param_sets(param_set_entry<T> (&entries)[N]){
+    for(auto& entry : entries){
+        entry.valid = false;
+        entry.ebsp.clear();
+    }
+}
+
+/**
+ * scaling_list(),7.3.2.1.1.1,values are not kept
+ */
+static void skip_scaling_list(zcf::bit_buffer& bits,int size){
+    int last_scale = 8;
+    int next_scale = 8;
+    for(int j = 0;j < size;j++){
+        if(next_scale){
+            int delta_scale = bits.read_se();
+            next_scale = (last_scale + delta_scale + 256) % 256;
+        }
+        last_scale = next_scale ? next_scale : last_scale;
+    }
+}
+
+};//!namespace h26x
+
+/**
+ * Table E-1 – Meaning of sample aspect ratio indicator
+ */
+static const uint16_t h264_sar_table[17][2] = {
+    {0,0},{1,1},{12,11},{10,11},{16,11},{40,33},{24,11},{20,11},
+    {32,11},{80,33},{18,11},{15,11},{64,33},{160,99},{4,3},{3,2},{2,1}
+};
+
+/**
+ * hrd_parameters(),E.1.2
+ */
+static void h264_skip_hrd(zcf::bit_buffer& bits){
+    uint32_t cpb_cnt = bits.read_ue() + 1;
+    if(cpb_cnt > 32){
+        // invalid,stop at overrun
+        cpb_cnt = 32;
+    }
+    bits.skip_bits(4 + 4);// bit_rate_scale cpb_size_scale
+    for(uint32_t i = 0;i < cpb_cnt;i++){
+        bits.read_ue();// bit_rate_value_minus1
+        bits.read_ue();// cpb_size_value_minus1
+        bits.read_bit();// cbr_flag
+    }
+    // initial_cpb_removal_delay_length_minus1 cpb_removal_delay_length_minus1
+    // dpb_output_delay_length_minus1 time_offset_length
+    bits.skip_bits(5 * 4);
+}
+
+/**
+ * vui_parameters(),E.1.1
+ */
+static void h264_parse_vui(zcf::bit_buffer& bits,h264_sps* sps){
+    if(bits.read_flag()){// aspect_ratio_info_present_flag
+        uint8_t aspect_ratio_idc = (uint8_t)bits.read_bits(8);
+        if(aspect_ratio_idc == 255){// Extended_SAR
+            sps->sar_width = (uint16_t)bits.read_bits(16);
+            sps->sar_height = (uint16_t)bits.read_bits(16);
+        }else if(aspect_ratio_idc < 17){
+            sps->sar_width = h264_sar_table[aspect_ratio_idc][0];
+            sps->sar_height = h264_sar_table[aspect_ratio_idc][1];
+        }
+    }
+    if(bits.read_flag()){// overscan_info_present_flag
+        bits.read_bit();// overscan_appropriate_flag
+    }
+    if(bits.read_flag()){// video_signal_type_present_flag
+        bits.skip_bits(3);// video_format
+        sps->video_full_range_flag = (uint8_t)bits.read_bit();
+        if(bits.read_flag()){// colour_description_present_flag
+            sps->colour_primaries = (uint8_t)bits.read_bits(8);
+            sps->transfer_characteristics = (uint8_t)bits.read_bits(8);
+            sps->matrix_coefficients = (uint8_t)bits.read_bits(8);
+        }
+    }
+    if(bits.read_flag()){// chroma_loc_info_present_flag
+        bits.read_ue();
+        bits.read_ue();
+    }
+    sps->timing_info_present_flag = (uint8_t)bits.read_bit();
+    if(sps->timing_info_present_flag){
+        sps->num_units_in_tick = bits.read_bits(32);
+        sps->time_scale = bits.read_bits(32);
+        sps->fixed_frame_rate_flag = (uint8_t)bits.read_bit();
+        if(sps->num_units_in_tick){
+            // one frame is two field ticks
+            sps->fps = (double)sps->time_scale / (2.0 * sps->num_units_in_tick);
+        }
+    }
+    bool nal_hrd = bits.read_flag();
+    if(nal_hrd){
+        h264_skip_hrd(bits);
+    }
+    bool vcl_hrd = bits.read_flag();
+    if(vcl_hrd){
+        h264_skip_hrd(bits);
+    }
+    if(nal_hrd || vcl_hrd){
+        bits.read_bit();// low_delay_hrd_flag
+    }
+    bits.read_bit();// pic_struct_present_flag
+    sps->bitstream_restriction_flag = (uint8_t)bits.read_bit();
+    if(sps->bitstream_restriction_flag){
+        bits.read_bit();// motion_vectors_over_pic_boundaries_flag
+        bits.read_ue();// max_bytes_per_pic_denom
+        bits.read_ue();// max_bits_per_mb_denom
+        bits.read_ue();// log2_max_mv_length_horizontal
+        bits.read_ue();// log2_max_mv_length_vertical
+        sps->max_num_reorder_frames = bits.read_ue();
+        sps->max_dec_frame_buffering = bits.read_ue();
+    }
+}
+
+bool h264::parse_sps(const uint8_t* nalu,size_t sizeBytes,h264_sps* sps){
+    if(!nalu || sizeBytes < 2 || H264_NALU_TYPE(nalu[0]) != H264_NALU_SPS){
+        return false;
+    }
+    h26x::rbsp_view rbsp(nalu + 1,sizeBytes - 1);
+    zcf::bit_buffer bits(rbsp.data(),rbsp.size());
+    ::memset(sps,0,sizeof(h264_sps));
+
+    sps->profile_idc = (uint8_t)bits.read_bits(8);
+    sps->constraint_flags = (uint8_t)bits.read_bits(8);
+    sps->level_idc = (uint8_t)bits.read_bits(8);
+    uint32_t sps_id = bits.read_ue();
+    if(sps_id >= H264_MAX_SPS_COUNT){
+        return false;
+    }
+    sps->sps_id = (uint8_t)sps_id;
+    sps->chroma_format_idc = 1;
+    sps->bit_depth_luma = 8;
+    sps->bit_depth_chroma = 8;
+    switch(sps->profile_idc){
+        // high profiles carry chroma format and bit depth
+        case 100: case 110: case 122: case 244: case 44: case 83:
+        case 86: case 118: case 128: case 138: case 139: case 134: case 135:{
+            uint32_t chroma_format_idc = bits.read_ue();
+            if(chroma_format_idc > 3){
+                return false;
+            }
+            sps->chroma_format_idc = (uint8_t)chroma_format_idc;
+            if(chroma_format_idc == 3){
+                sps->separate_colour_plane_flag = (uint8_t)bits.read_bit();
+            }
+            uint32_t bit_depth_luma_minus8 = bits.read_ue();
+            uint32_t bit_depth_chroma_minus8 = bits.read_ue();
+            if(bit_depth_luma_minus8 > 6 || bit_depth_chroma_minus8 > 6){
+                return false;
+            }
+            sps->bit_depth_luma = (uint8_t)(bit_depth_luma_minus8 + 8);
+            sps->bit_depth_chroma = (uint8_t)(bit_depth_chroma_minus8 + 8);
+            bits.read_bit();// qpprime_y_zero_transform_bypass_flag
+            if(bits.read_flag()){// seq_scaling_matrix_present_flag
+                int lists = chroma_format_idc != 3 ? 8 : 12;
+                for(int i = 0;i < lists;i++){
+                    if(bits.read_flag()){
+                        h26x::skip_scaling_list(bits,i < 6 ? 16 : 64);
+                    }
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    uint32_t log2_max_frame_num_minus4 = bits.read_ue();
+    if(log2_max_frame_num_minus4 > 12){
+        return false;
+    }
+    sps->log2_max_frame_num = (uint8_t)(log2_max_frame_num_minus4 + 4);
+    uint32_t pic_order_cnt_type = bits.read_ue();
+    if(pic_order_cnt_type > 2){
+        return false;
+    }
+    sps->pic_order_cnt_type = (uint8_t)pic_order_cnt_type;
+    if(pic_order_cnt_type == 0){
+        uint32_t log2_max_pic_order_cnt_lsb_minus4 = bits.read_ue();
+        if(log2_max_pic_order_cnt_lsb_minus4 > 12){
+            return false;
+        }
+        sps->log2_max_pic_order_cnt_lsb = (uint8_t)(log2_max_pic_order_cnt_lsb_minus4 + 4);
+    }else if(pic_order_cnt_type == 1){
+        sps->delta_pic_order_always_zero_flag = (uint8_t)bits.read_bit();
+        bits.read_se();// offset_for_non_ref_pic
+        bits.read_se();// offset_for_top_to_bottom_field
+        uint32_t num_ref_frames_in_pic_order_cnt_cycle = bits.read_ue();
+        if(num_ref_frames_in_pic_order_cnt_cycle > 255){
+            return false;
+        }
+        for(uint32_t i = 0;i < num_ref_frames_in_pic_order_cnt_cycle;i++){
+            bits.read_se();// offset_for_ref_frame
+        }
+    }
+    sps->max_num_ref_frames = (uint8_t)bits.read_ue();
+    bits.read_bit();// gaps_in_frame_num_value_allowed_flag
+    sps->pic_width_in_mbs = bits.read_ue() + 1;
+    sps->pic_height_in_map_units = bits.read_ue() + 1;
+    sps->frame_mbs_only_flag = (uint8_t)bits.read_bit();
+    if(!sps->frame_mbs_only_flag){
+        sps->mb_adaptive_frame_field_flag = (uint8_t)bits.read_bit();
+    }
+    sps->direct_8x8_inference_flag = (uint8_t)bits.read_bit();
+    if(bits.read_flag()){// frame_cropping_flag
+        sps->crop_left = bits.read_ue();
+        sps->crop_right = bits.read_ue();
+        sps->crop_top = bits.read_ue();
+        sps->crop_bottom = bits.read_ue();
+    }
+    sps->vui_parameters_present_flag = (uint8_t)bits.read_bit();
+    if(sps->vui_parameters_present_flag){
+        h264_parse_vui(bits,sps);
+    }
+    if(bits.overrun()){
+        return false;
+    }
+
+    // 7.4.2.1.1 CropUnitX CropUnitY
+    uint32_t chroma_array_type = sps->separate_colour_plane_flag ? 0 : sps->chroma_format_idc;
+    uint32_t crop_unit_x = 1;
+    uint32_t crop_unit_y = 2 - sps->frame_mbs_only_flag;
+    if(chroma_array_type){
+        uint32_t sub_width_c = chroma_array_type == 3 ? 1 : 2;
+        uint32_t sub_height_c = chroma_array_type == 1 ? 2 : 1;
+        crop_unit_x = sub_width_c;
+        crop_unit_y *= sub_height_c;
+    }
+    uint32_t width = sps->pic_width_in_mbs * 16;
+    uint32_t height = (2 - sps->frame_mbs_only_flag) * sps->pic_height_in_map_units * 16;
+    uint64_t crop_x = (uint64_t)crop_unit_x * ((uint64_t)sps->crop_left + sps->crop_right);
+    uint64_t crop_y = (uint64_t)crop_unit_y * ((uint64_t)sps->crop_top + sps->crop_bottom);
+    if(crop_x >= width || crop_y >= height){
+        return false;
+    }
+    sps->width = width - (uint32_t)crop_x;
+    sps->height = height - (uint32_t)crop_y;
+    return true;
+}
+
+bool h264::parse_pps(const uint8_t* nalu,size_t sizeBytes,h264_pps* pps,const h264_sps* sps){
+    if(!nalu || sizeBytes < 2 || H264_NALU_TYPE(nalu[0]) != H264_NALU_PPS){
+        return false;
+    }
+    h26x::rbsp_view rbsp(nalu + 1,sizeBytes - 1);
+    zcf::bit_buffer bits(rbsp.data(),rbsp.size());
+    ::memset(pps,0,sizeof(h264_pps));
+
+    uint32_t pps_id = bits.read_ue();
+    uint32_t sps_id = bits.read_ue();
+    if(pps_id >= H264_MAX_PPS_COUNT || sps_id >= H264_MAX_SPS_COUNT){
+        return false;
+    }
+    pps->pps_id = (uint8_t)pps_id;
+    pps->sps_id = (uint8_t)sps_id;
+    pps->entropy_coding_mode_flag = (uint8_t)bits.read_bit();
+    pps->bottom_field_pic_order_in_frame_present_flag = (uint8_t)bits.read_bit();
+    uint32_t num_slice_groups = bits.read_ue() + 1;
+    if(num_slice_groups > 8){
+        return false;
+    }
+    pps->num_slice_groups = (uint8_t)num_slice_groups;
+    if(num_slice_groups > 1){
+        uint32_t slice_group_map_type = bits.read_ue();
+        if(slice_group_map_type > 6){
+            return false;
+        }
+        pps->slice_group_map_type = (uint8_t)slice_group_map_type;
+        if(slice_group_map_type == 0){
+            for(uint32_t i = 0;i < num_slice_groups;i++){
+                bits.read_ue();// run_length_minus1
+            }
+        }else if(slice_group_map_type == 2){
+            for(uint32_t i = 0;i < num_slice_groups - 1;i++){
+                bits.read_ue();// top_left
+                bits.read_ue();// bottom_right
+            }
+        }else if(slice_group_map_type >= 3 && slice_group_map_type <= 5){
+            bits.read_bit();// slice_group_change_direction_flag
+            bits.read_ue();// slice_group_change_rate_minus1
+        }else if(slice_group_map_type == 6){
+            // slice_group_id u(v) with Ceil(Log2(num_slice_groups)) bits
+            int id_bits = 32 - __builtin_clz(num_slice_groups - 1);
+            uint32_t pic_size_in_map_units = bits.read_ue() + 1;
+            if(pic_size_in_map_units > bits.bits_left()){
+                return false;
+            }
+            bits.skip_bits((size_t)pic_size_in_map_units * id_bits);
+        }
+    }
+    uint32_t num_ref_idx_l0 = bits.read_ue() + 1;
+    uint32_t num_ref_idx_l1 = bits.read_ue() + 1;
+    if(num_ref_idx_l0 > 32 || num_ref_idx_l1 > 32){
+        return false;
+    }
+    pps->num_ref_idx_l0_default_active = (uint8_t)num_ref_idx_l0;
+    pps->num_ref_idx_l1_default_active = (uint8_t)num_ref_idx_l1;
+    pps->weighted_pred_flag = (uint8_t)bits.read_bit();
+    pps->weighted_bipred_idc = (uint8_t)bits.read_bits(2);
+    pps->pic_init_qp = (int8_t)(26 + bits.read_se());
+    pps->pic_init_qs = (int8_t)(26 + bits.read_se());
+    pps->chroma_qp_index_offset = (int8_t)bits.read_se();
+    pps->deblocking_filter_control_present_flag = (uint8_t)bits.read_bit();
+    pps->constrained_intra_pred_flag = (uint8_t)bits.read_bit();
+    pps->redundant_pic_cnt_present_flag = (uint8_t)bits.read_bit();
+    pps->second_chroma_qp_index_offset = pps->chroma_qp_index_offset;
+    if(bits.more_rbsp_data()){
+        pps->transform_8x8_mode_flag = (uint8_t)bits.read_bit();
+        if(bits.read_flag()){// pic_scaling_matrix_present_flag
+            int chroma_format_idc = sps ? sps->chroma_format_idc : 1;
+            int lists = 6 + (chroma_format_idc != 3 ? 2 : 6) * pps->transform_8x8_mode_flag;
+            for(int i = 0;i < lists;i++){
+                if(bits.read_flag()){
+                    h26x::skip_scaling_list(bits,i < 6 ? 16 : 64);
+                }
+            }
+        }
+        pps->second_chroma_qp_index_offset = (int8_t)bits.read_se();
+    }
+    return !bits.overrun();
+}
+
+const h264_sps* h264_param_cache::update_sps(const uint8_t* nalu,size_t sizeBytes,bool* changed){
+    if(changed){
+        *changed = false;
+    }
+    if(!nalu || sizeBytes < 2 || H264_NALU_TYPE(nalu[0]) != H264_NALU_SPS){
+        return nullptr;
+    }
+    // header + profile_idc + constraint_flags + level_idc
+    uint32_t sps_id = h26x::peek_ue(nalu,sizeBytes,24 + 8);
+    if(sps_id >= H264_MAX_SPS_COUNT){
+        return nullptr;
+    }
+    return h26x::update_param_set(sps_[sps_id],nalu,sizeBytes,changed,h264::parse_sps);
+}
+
+const h264_pps* h264_param_cache::update_pps(const uint8_t* nalu,size_t sizeBytes,bool* changed){
+    if(changed){
+        *changed = false;
+    }
+    if(!nalu || sizeBytes < 2 || H264_NALU_TYPE(nalu[0]) != H264_NALU_PPS){
+        return nullptr;
+    }
+    uint32_t pps_id = h26x::peek_ue(nalu,sizeBytes,8);
+    if(pps_id >= H264_MAX_PPS_COUNT){
+        return nullptr;
+    }
+    // scaling list of pps need chroma_format_idc of its sps
+    return h26x::update_param_set(pps_[pps_id],nalu,sizeBytes,changed,
+        [this](const uint8_t* data,size_t size,h264_pps* pps){
+            if(!h264::parse_pps(data,size,pps)){
+                return false;
+            }
+            const h264_sps* sps = this->sps(pps->sps_id);
+            return !sps || sps->chroma_format_idc != 3 || h264::parse_pps(data,size,pps,sps);
+        });
+}
+
+bool h264_param_cache::update(const h26x_nalu& nalu,bool* changed){
+    if(changed){
+        *changed = false;
+    }
+    // trailing_zero_8bits are not part of the parameter set
+    const uint8_t* data = h26x::nalu_data(nalu);
+    size_t size = h26x::nalu_size_trimmed(nalu);
+    switch(H264_NALU_TYPE(nalu.header)){
+        case H264_NALU_SPS:
+            return update_sps(data,size,changed) != nullptr;
+        case H264_NALU_PPS:
+            return update_pps(data,size,changed) != nullptr;
+        default:
+            return false;
+    }
+}
+
+const h264_sps* h264_param_cache::sps(uint32_t sps_id) const{
+    return h26x::find_param_set(sps_,sps_id);
+}
+
+const h264_pps* h264_param_cache::pps(uint32_t pps_id) const{
+    return h26x::find_param_set(pps_,pps_id);
+}
+
+const h264_sps* h264_param_cache::sps_of_pps(uint32_t pps_id) const{
+    const h264_pps* pps = this->pps(pps_id);
+    return pps ? sps(pps->sps_id) : nullptr;
+}
+
+void h264_param_cache::reset(){
+    h26x::reset_param_sets(sps_);
+    h26x::reset_param_sets(pps_);
+}
+
+/**
+ * profile_tier_level(1,maxNumSubLayersMinus1),7.3.3
+ */
+static void h265_parse_ptl(zcf::bit_buffer& bits,uint32_t max_sub_layers_minus1,h265_profile_tier_level* ptl){
+    ptl->general_profile_space = (uint8_t)bits.read_bits(2);
+    ptl->general_tier_flag = (uint8_t)bits.read_bit();
+    ptl->general_profile_idc = (uint8_t)bits.read_bits(5);
+    ptl->general_profile_compatibility_flags = bits.read_bits(32);
+    ptl->general_constraint_indicator_flags = bits.read_bits64(48);
+    ptl->general_level_idc = (uint8_t)bits.read_bits(8);
+    for(uint32_t i = 0;i < max_sub_layers_minus1;i++){
+        ptl->sub_layer_profile_present_flag[i] = (uint8_t)bits.read_bit();
+        ptl->sub_layer_level_present_flag[i] = (uint8_t)bits.read_bit();
+    }
+    if(max_sub_layers_minus1 > 0){
+        // reserved_zero_2bits
+        bits.skip_bits(2 * (8 - max_sub_layers_minus1));
+    }
+    for(uint32_t i = 0;i < max_sub_layers_minus1;i++){
+        if(ptl->sub_layer_profile_present_flag[i]){
+            // profile_space tier_flag
+            bits.skip_bits(2 + 1);
+            ptl->sub_layer_profile_idc[i] = (uint8_t)bits.read_bits(5);
+            // compatibility flags and constraint flags
+            bits.skip_bits(32 + 48);
+        }
+        if(ptl->sub_layer_level_present_flag[i]){
+            ptl->sub_layer_level_idc[i] = (uint8_t)bits.read_bits(8);
+        }
+    }
+}
+
+/**
+ * sub_layer_ordering_info of vps/sps,keep the highest sub layer
+ */
+template<typename T>
+static void h265_parse_sub_layer_ordering(zcf::bit_buffer& bits,uint32_t max_sub_layers_minus1,T* ps){
+    bool sub_layer_ordering_info_present_flag = bits.read_flag();
+    uint32_t i = sub_layer_ordering_info_present_flag ? 0 : max_sub_layers_minus1;
+    for(;i <= max_sub_layers_minus1;i++){
+        ps->max_dec_pic_buffering = bits.read_ue() + 1;
+        ps->max_num_reorder_pics = bits.read_ue();
+        ps->max_latency_increase = bits.read_ue();
+    }
+}
+
+/**
+ * scaling_list_data(),7.3.4,values are not kept
+ */
+static void h265_skip_scaling_list_data(zcf::bit_buffer& bits){
+    for(int size_id = 0;size_id < 4;size_id++){
+        for(int matrix_id = 0;matrix_id < 6;matrix_id += (size_id == 3) ? 3 : 1){
+            if(!bits.read_flag()){// scaling_list_pred_mode_flag
+                bits.read_ue();// scaling_list_pred_matrix_id_delta
+                continue;
+            }
+            int coef_num = 1 << (4 + (size_id << 1));
+            coef_num = coef_num < 64 ? coef_num : 64;
+            if(size_id > 1){
+                bits.read_se();// scaling_list_dc_coef_minus8
+            }
+            for(int i = 0;i < coef_num;i++){
+                bits.read_se();// scaling_list_delta_coef
+            }
+        }
+    }
+}
+
+/**
+ * st_ref_pic_set(stRpsIdx) of sps,7.3.7
+ * num_delta_pocs keep NumDeltaPocs of previous sets for inter rps prediction
+ */
+static bool h265_skip_st_ref_pic_set(zcf::bit_buffer& bits,uint32_t idx,uint32_t* num_delta_pocs){
+    if(idx && bits.read_flag()){// inter_ref_pic_set_prediction_flag
+        bits.read_bit();// delta_rps_sign
+        bits.read_ue();// abs_delta_rps_minus1
+        uint32_t ref_num_delta_pocs = num_delta_pocs[idx - 1];
+        uint32_t count = 0;
+        for(uint32_t j = 0;j <= ref_num_delta_pocs;j++){
+            bool used_by_curr_pic_flag = bits.read_flag();
+            bool use_delta_flag = used_by_curr_pic_flag || bits.read_flag();
+            if(use_delta_flag){
+                ++count;
+            }
+        }
+        num_delta_pocs[idx] = count;
+        return true;
+    }
+    uint32_t num_negative_pics = bits.read_ue();
+    uint32_t num_positive_pics = bits.read_ue();
+    if(num_negative_pics > 16 || num_positive_pics > 16){
+        return false;
+    }
+    for(uint32_t i = 0;i < num_negative_pics + num_positive_pics;i++){
+        bits.read_ue();// delta_poc_s0/s1_minus1
+        bits.read_bit();// used_by_curr_pic_s0/s1_flag
+    }
+    num_delta_pocs[idx] = num_negative_pics + num_positive_pics;
+    return true;
+}
+
+/**
+ * vui_parameters(),E.2.1,stop after timing info
+ */
+static void h265_parse_vui(zcf::bit_buffer& bits,h265_sps* sps){
+    if(bits.read_flag()){// aspect_ratio_info_present_flag
+        uint8_t aspect_ratio_idc = (uint8_t)bits.read_bits(8);
+        if(aspect_ratio_idc == 255){// EXTENDED_SAR
+            sps->sar_width = (uint16_t)bits.read_bits(16);
+            sps->sar_height = (uint16_t)bits.read_bits(16);
+        }else if(aspect_ratio_idc < 17){
+            sps->sar_width = h264_sar_table[aspect_ratio_idc][0];
+            sps->sar_height = h264_sar_table[aspect_ratio_idc][1];
+        }
+    }
+    if(bits.read_flag()){// overscan_info_present_flag
+        bits.read_bit();// overscan_appropriate_flag
+    }
+    if(bits.read_flag()){// video_signal_type_present_flag
+        bits.skip_bits(3);// video_format
+        sps->video_full_range_flag = (uint8_t)bits.read_bit();
+        if(bits.read_flag()){// colour_description_present_flag
+            sps->colour_primaries = (uint8_t)bits.read_bits(8);
+            sps->transfer_characteristics = (uint8_t)bits.read_bits(8);
+            sps->matrix_coefficients = (uint8_t)bits.read_bits(8);
+        }
+    }
+    if(bits.read_flag()){// chroma_loc_info_present_flag
+        bits.read_ue();
+        bits.read_ue();
+    }
+    bits.read_bit();// neutral_chroma_indication_flag
+    sps->field_seq_flag = (uint8_t)bits.read_bit();
+    bits.read_bit();// frame_field_info_present_flag
+    if(bits.read_flag()){// default_display_window_flag
+        bits.read_ue();
+        bits.read_ue();
+        bits.read_ue();
+        bits.read_ue();
+    }
+    sps->timing_info_present_flag = (uint8_t)bits.read_bit();
+    if(sps->timing_info_present_flag){
+        sps->num_units_in_tick = bits.read_bits(32);
+        sps->time_scale = bits.read_bits(32);
+        if(sps->num_units_in_tick){
+            sps->fps = (double)sps->time_scale / sps->num_units_in_tick;
+        }
+    }
+}
+
+bool h265::parse_vps(const uint8_t* nalu,size_t sizeBytes,h265_vps* vps){
+    if(!nalu || sizeBytes < 3 || H265_NALU_TYPE(nalu[0]) != H265_NALU_VPS){
+        return false;
+    }
+    h26x::rbsp_view rbsp(nalu + 2,sizeBytes - 2);
+    zcf::bit_buffer bits(rbsp.data(),rbsp.size());
+    ::memset(vps,0,sizeof(h265_vps));
+
+    vps->vps_id = (uint8_t)bits.read_bits(4);
+    // vps_base_layer_internal_flag vps_base_layer_available_flag
+    bits.skip_bits(2);
+    vps->max_layers = (uint8_t)(bits.read_bits(6) + 1);
+    uint32_t max_sub_layers_minus1 = bits.read_bits(3);
+    if(max_sub_layers_minus1 >= H265_MAX_SUB_LAYERS){
+        return false;
+    }
+    vps->max_sub_layers = (uint8_t)(max_sub_layers_minus1 + 1);
+    vps->temporal_id_nesting_flag = (uint8_t)bits.read_bit();
+    bits.skip_bits(16);// vps_reserved_0xffff_16bits
+    h265_parse_ptl(bits,max_sub_layers_minus1,&vps->ptl);
+    h265_parse_sub_layer_ordering(bits,max_sub_layers_minus1,vps);
+    uint32_t max_layer_id = bits.read_bits(6);
+    uint32_t num_layer_sets_minus1 = bits.read_ue();
+    if(num_layer_sets_minus1 > 1023){
+        return false;
+    }
+    // layer_id_included_flag
+    bits.skip_bits((size_t)num_layer_sets_minus1 * (max_layer_id + 1));
+    vps->timing_info_present_flag = (uint8_t)bits.read_bit();
+    if(vps->timing_info_present_flag){
+        vps->num_units_in_tick = bits.read_bits(32);
+        vps->time_scale = bits.read_bits(32);
+    }
+    return !bits.overrun();
+}
+
+/**
+ * sps head before sps_seq_parameter_set_id
+ */
+static bool h265_parse_sps_head(zcf::bit_buffer& bits,h265_sps* sps){
+    sps->vps_id = (uint8_t)bits.read_bits(4);
+    uint32_t max_sub_layers_minus1 = bits.read_bits(3);
+    if(max_sub_layers_minus1 >= H265_MAX_SUB_LAYERS){
+        return false;
+    }
+    sps->max_sub_layers = (uint8_t)(max_sub_layers_minus1 + 1);
+    sps->temporal_id_nesting_flag = (uint8_t)bits.read_bit();
+    h265_parse_ptl(bits,max_sub_layers_minus1,&sps->ptl);
+    uint32_t sps_id = bits.read_ue();
+    if(sps_id >= H265_MAX_SPS_COUNT){
+        return false;
+    }
+    sps->sps_id = (uint8_t)sps_id;
+    return true;
+}
+
+bool h265::parse_sps(const uint8_t* nalu,size_t sizeBytes,h265_sps* sps){
+    if(!nalu || sizeBytes < 3 || H265_NALU_TYPE(nalu[0]) != H265_NALU_SPS){
+        return false;
+    }
+    h26x::rbsp_view rbsp(nalu + 2,sizeBytes - 2);
+    zcf::bit_buffer bits(rbsp.data(),rbsp.size());
+    ::memset(sps,0,sizeof(h265_sps));
+
+    if(!h265_parse_sps_head(bits,sps)){
+        return false;
+    }
+    uint32_t chroma_format_idc = bits.read_ue();
+    if(chroma_format_idc > 3){
+        return false;
+    }
+    sps->chroma_format_idc = (uint8_t)chroma_format_idc;
+    if(chroma_format_idc == 3){
+        sps->separate_colour_plane_flag = (uint8_t)bits.read_bit();
+    }
+    sps->pic_width_in_luma_samples = bits.read_ue();
+    sps->pic_height_in_luma_samples = bits.read_ue();
+    sps->conformance_window_flag = (uint8_t)bits.read_bit();
+    if(sps->conformance_window_flag){
+        sps->conf_win_left_offset = bits.read_ue();
+        sps->conf_win_right_offset = bits.read_ue();
+        sps->conf_win_top_offset = bits.read_ue();
+        sps->conf_win_bottom_offset = bits.read_ue();
+    }
+    uint32_t bit_depth_luma_minus8 = bits.read_ue();
+    uint32_t bit_depth_chroma_minus8 = bits.read_ue();
+    uint32_t log2_max_pic_order_cnt_lsb_minus4 = bits.read_ue();
+    if(bit_depth_luma_minus8 > 8 || bit_depth_chroma_minus8 > 8 || log2_max_pic_order_cnt_lsb_minus4 > 12){
+        return false;
+    }
+    sps->bit_depth_luma = (uint8_t)(bit_depth_luma_minus8 + 8);
+    sps->bit_depth_chroma = (uint8_t)(bit_depth_chroma_minus8 + 8);
+    sps->log2_max_pic_order_cnt_lsb = (uint8_t)(log2_max_pic_order_cnt_lsb_minus4 + 4);
+    h265_parse_sub_layer_ordering(bits,sps->max_sub_layers - 1,sps);
+    uint32_t log2_min_luma_coding_block_size_minus3 = bits.read_ue();
+    uint32_t log2_diff_max_min_luma_coding_block_size = bits.read_ue();
+    uint32_t log2_ctb_size = log2_min_luma_coding_block_size_minus3 + 3 + log2_diff_max_min_luma_coding_block_size;
+    if(log2_ctb_size < 4 || log2_ctb_size > 6){
+        return false;
+    }
+    sps->log2_min_luma_coding_block_size = (uint8_t)(log2_min_luma_coding_block_size_minus3 + 3);
+    sps->log2_ctb_size = (uint8_t)log2_ctb_size;
+    bits.read_ue();// log2_min_luma_transform_block_size_minus2
+    bits.read_ue();// log2_diff_max_min_luma_transform_block_size
+    bits.read_ue();// max_transform_hierarchy_depth_inter
+    bits.read_ue();// max_transform_hierarchy_depth_intra
+    if(bits.read_flag()){// scaling_list_enabled_flag
+        if(bits.read_flag()){// sps_scaling_list_data_present_flag
+            h265_skip_scaling_list_data(bits);
+        }
+    }
+    bits.read_bit();// amp_enabled_flag
+    bits.read_bit();// sample_adaptive_offset_enabled_flag
+    if(bits.read_flag()){// pcm_enabled_flag
+        // pcm_sample_bit_depth_luma_minus1 pcm_sample_bit_depth_chroma_minus1
+        bits.skip_bits(4 + 4);
+        bits.read_ue();// log2_min_pcm_luma_coding_block_size_minus3
+        bits.read_ue();// log2_diff_max_min_pcm_luma_coding_block_size
+        bits.read_bit();// pcm_loop_filter_disabled_flag
+    }
+    uint32_t num_short_term_ref_pic_sets = bits.read_ue();
+    if(num_short_term_ref_pic_sets > 64){
+        return false;
+    }
+    sps->num_short_term_ref_pic_sets = (uint8_t)num_short_term_ref_pic_sets;
+    uint32_t num_delta_pocs[64];
+    for(uint32_t i = 0;i < num_short_term_ref_pic_sets;i++){
+        if(!h265_skip_st_ref_pic_set(bits,i,num_delta_pocs) || bits.overrun()){
+            return false;
+        }
+    }
+    sps->long_term_ref_pics_present_flag = (uint8_t)bits.read_bit();
+    if(sps->long_term_ref_pics_present_flag){
+        uint32_t num_long_term_ref_pics_sps = bits.read_ue();
+        if(num_long_term_ref_pics_sps > 32){
+            return false;
+        }
+        // lt_ref_pic_poc_lsb_sps u(v) used_by_curr_pic_lt_sps_flag
+        bits.skip_bits((size_t)num_long_term_ref_pics_sps * (sps->log2_max_pic_order_cnt_lsb + 1));
+    }
+    sps->temporal_mvp_enabled_flag = (uint8_t)bits.read_bit();
+    bits.read_bit();// strong_intra_smoothing_enabled_flag
+    sps->vui_parameters_present_flag = (uint8_t)bits.read_bit();
+    if(sps->vui_parameters_present_flag){
+        h265_parse_vui(bits,sps);
+    }
+    if(bits.overrun()){
+        return false;
+    }
+
+    // Table 6-1 SubWidthC SubHeightC,conformance window is in chroma samples
+    uint32_t chroma_array_type = sps->separate_colour_plane_flag ? 0 : sps->chroma_format_idc;
+    uint32_t sub_width_c = (chroma_array_type == 1 || chroma_array_type == 2) ? 2 : 1;
+    uint32_t sub_height_c = chroma_array_type == 1 ? 2 : 1;
+    uint64_t crop_x = (uint64_t)sub_width_c * ((uint64_t)sps->conf_win_left_offset + sps->conf_win_right_offset);
+    uint64_t crop_y = (uint64_t)sub_height_c * ((uint64_t)sps->conf_win_top_offset + sps->conf_win_bottom_offset);
+    if(crop_x >= sps->pic_width_in_luma_samples || crop_y >= sps->pic_height_in_luma_samples){
+        return false;
+    }
+    sps->width = sps->pic_width_in_luma_samples - (uint32_t)crop_x;
+    sps->height = sps->pic_height_in_luma_samples - (uint32_t)crop_y;
+    uint32_t ctb_size = 1u << log2_ctb_size;
+    sps->pic_width_in_ctbs = (sps->pic_width_in_luma_samples + ctb_size - 1) >> log2_ctb_size;
+    sps->pic_height_in_ctbs = (sps->pic_height_in_luma_samples + ctb_size - 1) >> log2_ctb_size;
+    return true;
+}
+
+bool h265::parse_pps(const uint8_t* nalu,size_t sizeBytes,h265_pps* pps){
+    if(!nalu || sizeBytes < 3 || H265_NALU_TYPE(nalu[0]) != H265_NALU_PPS){
+        return false;
+    }
+    h26x::rbsp_view rbsp(nalu + 2,sizeBytes - 2);
+    zcf::bit_buffer bits(rbsp.data(),rbsp.size());
+    ::memset(pps,0,sizeof(h265_pps));
+
+    uint32_t pps_id = bits.read_ue();
+    uint32_t sps_id = bits.read_ue();
+    if(pps_id >= H265_MAX_PPS_COUNT || sps_id >= H265_MAX_SPS_COUNT){
+        return false;
+    }
+    pps->pps_id = (uint8_t)pps_id;
+    pps->sps_id = (uint8_t)sps_id;
+    pps->dependent_slice_segments_enabled_flag = (uint8_t)bits.read_bit();
+    pps->output_flag_present_flag = (uint8_t)bits.read_bit();
+    pps->num_extra_slice_header_bits = (uint8_t)bits.read_bits(3);
+    pps->sign_data_hiding_enabled_flag = (uint8_t)bits.read_bit();
+    pps->cabac_init_present_flag = (uint8_t)bits.read_bit();
+    uint32_t num_ref_idx_l0 = bits.read_ue() + 1;
+    uint32_t num_ref_idx_l1 = bits.read_ue() + 1;
+    if(num_ref_idx_l0 > 15 || num_ref_idx_l1 > 15){
+        return false;
+    }
+    pps->num_ref_idx_l0_default_active = (uint8_t)num_ref_idx_l0;
+    pps->num_ref_idx_l1_default_active = (uint8_t)num_ref_idx_l1;
+    pps->init_qp = (int8_t)(26 + bits.read_se());
+    pps->constrained_intra_pred_flag = (uint8_t)bits.read_bit();
+    pps->transform_skip_enabled_flag = (uint8_t)bits.read_bit();
+    pps->cu_qp_delta_enabled_flag = (uint8_t)bits.read_bit();
+    if(pps->cu_qp_delta_enabled_flag){
+        pps->diff_cu_qp_delta_depth = (uint8_t)bits.read_ue();
+    }
+    pps->cb_qp_offset = (int8_t)bits.read_se();
+    pps->cr_qp_offset = (int8_t)bits.read_se();
+    pps->slice_chroma_qp_offsets_present_flag = (uint8_t)bits.read_bit();
+    pps->weighted_pred_flag = (uint8_t)bits.read_bit();
+    pps->weighted_bipred_flag = (uint8_t)bits.read_bit();
+    pps->transquant_bypass_enabled_flag = (uint8_t)bits.read_bit();
+    pps->tiles_enabled_flag = (uint8_t)bits.read_bit();
+    pps->entropy_coding_sync_enabled_flag = (uint8_t)bits.read_bit();
+    pps->num_tile_columns = 1;
+    pps->num_tile_rows = 1;
+    if(pps->tiles_enabled_flag){
+        uint32_t num_tile_columns = bits.read_ue() + 1;
+        uint32_t num_tile_rows = bits.read_ue() + 1;
+        if(num_tile_columns > 20 || num_tile_rows > 22){
+            return false;
+        }
+        pps->num_tile_columns = (uint8_t)num_tile_columns;
+        pps->num_tile_rows = (uint8_t)num_tile_rows;
+    }
+    return !bits.overrun();
+}
+
+const h265_vps* h265_param_cache::update_vps(const uint8_t* nalu,size_t sizeBytes,bool* changed){
+    if(changed){
+        *changed = false;
+    }
+    if(!nalu || sizeBytes < 3 || H265_NALU_TYPE(nalu[0]) != H265_NALU_VPS){
+        return nullptr;
+    }
+    // vps_video_parameter_set_id u(4),no emulation before it
+    uint32_t vps_id = nalu[2] >> 4;
+    return h26x::update_param_set(vps_[vps_id],nalu,sizeBytes,changed,h265::parse_vps);
+}
+
+const h265_sps* h265_param_cache::update_sps(const uint8_t* nalu,size_t sizeBytes,bool* changed){
+    if(changed){
+        *changed = false;
+    }
+    if(!nalu || sizeBytes < 3 || H265_NALU_TYPE(nalu[0]) != H265_NALU_SPS){
+        return nullptr;
+    }
+    // sps id is behind profile_tier_level
+    uint8_t head[H26X_PEEK_HEAD_SIZE];
+    zcf::bit_buffer bits(head,h26x::rbsp_head(nalu + 2,sizeBytes - 2,head));
+    h265_sps sps_head;
+    if(!h265_parse_sps_head(bits,&sps_head) || bits.overrun()){
+        return nullptr;
+    }
+    return h26x::update_param_set(sps_[sps_head.sps_id],nalu,sizeBytes,changed,h265::parse_sps);
+}
+
+const h265_pps* h265_param_cache::update_pps(const uint8_t* nalu,size_t sizeBytes,bool* changed){
+    if(changed){
+        *changed = false;
+    }
+    if(!nalu || sizeBytes < 3 || H265_NALU_TYPE(nalu[0]) != H265_NALU_PPS){
+        return nullptr;
+    }
+    uint32_t pps_id = h26x::peek_ue(nalu,sizeBytes,16);
+    if(pps_id >= H265_MAX_PPS_COUNT){
+        return nullptr;
+    }
+    return h26x::update_param_set(pps_[pps_id],nalu,sizeBytes,changed,h265::parse_pps);
+}
+
+bool h265_param_cache::update(const h26x_nalu& nalu,bool* changed){
+    if(changed){
+        *changed = false;
+    }
+    // trailing_zero_8bits are not part of the parameter set
+    const uint8_t* data = h26x::nalu_data(nalu);
+    size_t size = h26x::nalu_size_trimmed(nalu);
+    switch(H265_NALU_TYPE(nalu.header)){
+        case H265_NALU_VPS:
+            return update_vps(data,size,changed) != nullptr;
+        case H265_NALU_SPS:
+            return update_sps(data,size,changed) != nullptr;
+        case H265_NALU_PPS:
+            return update_pps(data,size,changed) != nullptr;
+        default:
+            return false;
+    }
+}
+
+const h265_vps* h265_param_cache::vps(uint32_t vps_id) const{
+    return h26x::find_param_set(vps_,vps_id);
+}
+
+const h265_sps* h265_param_cache::sps(uint32_t sps_id) const{
+    return h26x::find_param_set(sps_,sps_id);
+}
+
+const h265_pps* h265_param_cache::pps(uint32_t pps_id) const{
+    return h26x::find_param_set(pps_,pps_id);
+}
+
+const h265_sps* h265_param_cache::sps_of_pps(uint32_t pps_id) const{
+    const h265_pps* pps = this->pps(pps_id);
+    return pps ? sps(pps->sps_id) : nullptr;
+}
+
+void h265_param_cache::reset(){
+    h26x::reset_param_sets(vps_);
+    h26x::reset_param_sets(sps_);
+    h26x::reset_param_sets(pps_);
+}
+
+};//!namespace zav
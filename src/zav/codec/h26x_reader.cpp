@@ -0,0 +1,322 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+
+#include "zav/codec/h26x_reader.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#include "zcf/memory.hpp"
+#include "zcf/zcf_sys.hpp"
+
+namespace zav{
+
+// index window of parallel scan,the open nalu at window end start the next
+#ifndef H26X_READER_WINDOW
+#define H26X_READER_WINDOW (256 * 1024 * 1024)
+#endif
+#define H26X_READER_DEFAULT_FPS 25
+
+static const char kH26X_INDEX_MAGIC[8] = {'Z','H','2','6','X','I','D','X'};
+static const uint32_t kH26X_INDEX_VERSION = 1;
+// magic version codec fps(x1000) file_size mtime frame_count keyframe_count
+static const size_t kH26X_INDEX_HEAD_SIZE = 8 + 4 + 4 + 4 + 4 + 8 + 8 + 8 + 8;
+static const size_t kH26X_INDEX_ENTRY_SIZE = 8 * 4;
+
+h26x_file_reader::h26x_file_reader()
+    :fd_(-1),data_(nullptr),size_(0),map_size_(0),mtime_(0),
+    codec_(AV_CODEC_UNKNOWN),fps_(0),frame_count_(0){
+
+}
+
+h26x_file_reader::~h26x_file_reader(){
+    close();
+}
+
+bool h26x_file_reader::open(const std::string& path,AVCodecID codec,double fps){
+    close();
+    fd_ = ::open(path.c_str(),O_RDONLY);
+    if(fd_ < 0){
+        return false;
+    }
+    struct stat st;
+    if(::fstat(fd_,&st) || st.st_size <= 0){
+        close();
+        return false;
+    }
+    size_ = (size_t)st.st_size;
+    mtime_ = (int64_t)st.st_mtime;
+    map_size_ = zcf::sys::alignOfPageSize(size_);
+    void* map = ::mmap(nullptr,map_size_,PROT_READ,MAP_PRIVATE,fd_,0);
+    if(map == MAP_FAILED){
+        close();
+        return false;
+    }
+    data_ = (uint8_t*)map;
+    path_ = path;
+    codec_ = codec == AV_CODEC_UNKNOWN ? detect_codec() : codec;
+    fps_ = fps;
+    return true;
+}
+
+void h26x_file_reader::close(){
+    if(data_){
+        ::munmap(data_,map_size_);
+        data_ = nullptr;
+    }
+    if(fd_ >= 0){
+        ::close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+    map_size_ = 0;
+    mtime_ = 0;
+    frame_count_ = 0;
+    keyframes_.clear();
+}
+
+AVCodecID h26x_file_reader::detect_codec() const{
+    // h265 nalu header is 2 bytes with nuh_temporal_id_plus1 == 1 for parameter sets
+    h26x_nalu nalu;
+    const uint8_t* p = data_;
+    const uint8_t* pend = data_ + size_;
+    for(int i = 0;i < 8 && zav::h26x::annexb_find_next_nalu(p,pend - p,&nalu);i++){
+        p = nalu.end + 1;
+        if(!h26x::nalu_size(nalu)){
+            // empty nalu,header may be one byte past the mapping
+            continue;
+        }
+        const uint8_t* header = h26x::nalu_data(nalu);
+        if(h26x::nalu_size(nalu) >= 2 && header[1] == 0x01){
+            uint8_t type = H265_NALU_TYPE(header[0]);
+            if(type >= H265_NALU_VPS && type <= H265_NALU_AUD){
+                return AV_CODEC_VIDEO_H265;
+            }
+        }
+        uint8_t type = H264_NALU_TYPE(header[0]);
+        if(type == H264_NALU_SPS || type == H264_NALU_AUD){
+            return AV_CODEC_VIDEO_H264;
+        }
+    }
+    return AV_CODEC_VIDEO_H264;
+}
+
+bool h26x_file_reader::build_index(){
+    if(!data_){
+        return false;
+    }
+    keyframes_.clear();
+    frame_count_ = 0;
+    uint64_t frame_index = 0;
+    access_unit_builder builder(codec_,[this,&frame_index](const h26x_frame& frame){
+        if(frame.flags & H26X_FRAME_FLAG_KEY){
+            h26x_keyframe keyframe;
+            keyframe.offset = (uint64_t)(frame.start - data_);
+            keyframe.size = (uint64_t)(frame.end - frame.start + 1);
+            keyframe.frame_index = frame_index;
+            keyframe.timestamp_us = 0;
+            keyframes_.push_back(keyframe);
+        }
+        ++frame_index;
+    });
+
+    ::madvise(data_,map_size_,MADV_SEQUENTIAL);
+    std::vector<h26x_nalu> nalus;
+    size_t offset = 0;
+    size_t window = H26X_READER_WINDOW;
+    while(offset < size_){
+        size_t window_size = size_ - offset < window ? size_ - offset : window;
+        bool last = offset + window_size == size_;
+        size_t count = h26x::parallel_annexb_index(data_ + offset,window_size,nalus);
+        if(!count){
+            break;
+        }
+        if(!last && count == 1){
+            // one nalu longer than window
+            window *= 2;
+            continue;
+        }
+        // the last nalu of a window may continue in the next one
+        size_t done = last ? count : count - 1;
+        for(size_t i = 0;i < done;i++){
+            builder.push(nalus[i]);
+        }
+        if(last){
+            break;
+        }
+        offset = nalus[done].start - data_;
+    }
+    builder.flush();
+    ::madvise(data_,map_size_,MADV_NORMAL);
+    frame_count_ = frame_index;
+
+    if(fps_ <= 0){
+        fps_ = H26X_READER_DEFAULT_FPS;
+        double sps_fps = 0;
+        for(uint32_t id = 0;id < H265_MAX_SPS_COUNT && sps_fps <= 0;id++){
+            if(codec_ == AV_CODEC_VIDEO_H265){
+                const h265_sps* sps = builder.h265_params().sps(id);
+                sps_fps = sps ? sps->fps : 0;
+            }else{
+                const h264_sps* sps = builder.h264_params().sps(id);
+                sps_fps = sps ? sps->fps : 0;
+            }
+        }
+        if(sps_fps > 0){
+            fps_ = sps_fps;
+        }
+    }
+    for(auto& keyframe : keyframes_){
+        keyframe.timestamp_us = (int64_t)(keyframe.frame_index * 1000000.0 / fps_);
+    }
+    return true;
+}
+
+bool h26x_file_reader::save_index() const{
+    if(!data_){
+        return false;
+    }
+    std::vector<uint8_t> index(kH26X_INDEX_HEAD_SIZE + keyframes_.size() * kH26X_INDEX_ENTRY_SIZE);
+    uint8_t* w = index.data();
+    ::memcpy(w,kH26X_INDEX_MAGIC,sizeof(kH26X_INDEX_MAGIC));
+    Z_WLE32(w + 8,kH26X_INDEX_VERSION);
+    Z_WLE32(w + 12,(uint32_t)codec_);
+    Z_WLE32(w + 16,(uint32_t)(fps_ * 1000 + 0.5));
+    Z_WLE32(w + 20,0);// reserved
+    Z_WLE64(w + 24,(uint64_t)size_);
+    Z_WLE64(w + 32,(uint64_t)mtime_);
+    Z_WLE64(w + 40,frame_count_);
+    Z_WLE64(w + 48,(uint64_t)keyframes_.size());
+    w += kH26X_INDEX_HEAD_SIZE;
+    for(const auto& keyframe : keyframes_){
+        Z_WLE64(w,keyframe.offset);
+        Z_WLE64(w + 8,keyframe.size);
+        Z_WLE64(w + 16,keyframe.frame_index);
+        Z_WLE64(w + 24,(uint64_t)keyframe.timestamp_us);
+        w += kH26X_INDEX_ENTRY_SIZE;
+    }
+    std::string tmp_path = index_path() + ".tmp";
+    FILE* file = fopen(tmp_path.c_str(),"wb");
+    if(!file){
+        return false;
+    }
+    bool written = fwrite(index.data(),1,index.size(),file) == index.size();
+    written = fclose(file) == 0 && written;
+    if(!written || ::rename(tmp_path.c_str(),index_path().c_str())){
+        ::unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool h26x_file_reader::load_index(){
+    if(!data_){
+        return false;
+    }
+    FILE* file = fopen(index_path().c_str(),"rb");
+    if(file){
+        uint8_t head[kH26X_INDEX_HEAD_SIZE];
+        bool valid = fread(head,1,sizeof(head),file) == sizeof(head)
+            && !::memcmp(head,kH26X_INDEX_MAGIC,sizeof(kH26X_INDEX_MAGIC))
+            && Z_RLE32(head + 8) == kH26X_INDEX_VERSION
+            && Z_RLE32(head + 12) == (uint32_t)codec_
+            && Z_RLE64(head + 24) == (uint64_t)size_
+            && Z_RLE64(head + 32) == (uint64_t)mtime_;
+        uint64_t count = valid ? Z_RLE64(head + 48) : 0;
+        // at most one keyframe per start code
+        valid = valid && count <= size_ / 4;
+        std::vector<uint8_t> entries(valid ? count * kH26X_INDEX_ENTRY_SIZE : 0);
+        valid = valid && fread(entries.data(),1,entries.size(),file) == entries.size();
+        fclose(file);
+        if(valid && (fps_ <= 0 || (uint32_t)(fps_ * 1000 + 0.5) == Z_RLE32(head + 16))){
+            fps_ = Z_RLE32(head + 16) / 1000.0;
+            frame_count_ = Z_RLE64(head + 40);
+            keyframes_.resize(count);
+            const uint8_t* r = entries.data();
+            for(auto& keyframe : keyframes_){
+                keyframe.offset = Z_RLE64(r);
+                keyframe.size = Z_RLE64(r + 8);
+                keyframe.frame_index = Z_RLE64(r + 16);
+                keyframe.timestamp_us = (int64_t)Z_RLE64(r + 24);
+                r += kH26X_INDEX_ENTRY_SIZE;
+                if(keyframe.offset + keyframe.size > size_){
+                    keyframes_.clear();
+                    break;
+                }
+            }
+            if(keyframes_.size() == count){
+                return true;
+            }
+        }
+    }
+    if(!build_index()){
+        return false;
+    }
+    save_index();
+    return true;
+}
+
+const h26x_keyframe* h26x_file_reader::seek(int64_t timestamp_us) const{
+    if(keyframes_.empty()){
+        return nullptr;
+    }
+    // first keyframe after timestamp,the one before it is the answer
+    auto it = std::upper_bound(keyframes_.begin(),keyframes_.end(),timestamp_us,
+        [](int64_t ts,const h26x_keyframe& keyframe){
+            return ts < keyframe.timestamp_us;
+        });
+    if(it == keyframes_.begin()){
+        return &keyframes_.front();
+    }
+    return &*(it - 1);
+}
+
+const uint8_t* h26x_file_reader::keyframe_data(const h26x_keyframe& keyframe) const{
+    if(!data_ || keyframe.offset >= size_){
+        return nullptr;
+    }
+    // madvise need page aligned address
+    size_t page_size = zcf::sys::getPageSize();
+    size_t page_offset = keyframe.offset / page_size * page_size;
+    size_t advise_size = zcf::sys::alignOfPageSize(keyframe.offset + keyframe.size - page_offset);
+    if(page_offset + advise_size > map_size_){
+        advise_size = map_size_ - page_offset;
+    }
+    ::madvise(data_ + page_offset,advise_size,MADV_WILLNEED);
+    return data_ + keyframe.offset;
+}
+
+};//!namespace zav
@@ -0,0 +1,91 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+
+#include "zav/proto/rtp.h"
+#include "zcf/memory.hpp"
+
+namespace zav{
+
+bool rtp_parse(const uint8_t* bytes,size_t sizeBytes,rtp_packet* packet){
+    if(!bytes || sizeBytes < RTP_HEADER_SIZE){
+        return false;
+    }
+    rtp_header& header = packet->header;
+    header.version = bytes[0] >> 6;
+    header.padding = (bytes[0] >> 5) & 0x01;
+    header.extension = (bytes[0] >> 4) & 0x01;
+    header.csrc_count = bytes[0] & 0x0F;
+    header.marker = bytes[1] >> 7;
+    header.payload_type = bytes[1] & 0x7F;
+    header.seq = Z_RBE16(bytes + 2);
+    header.timestamp = Z_RBE32(bytes + 4);
+    header.ssrc = Z_RBE32(bytes + 8);
+    if(header.version != RTP_VERSION){
+        return false;
+    }
+    size_t offset = RTP_HEADER_SIZE + header.csrc_count * 4;
+    if(offset > sizeBytes){
+        return false;
+    }
+    if(header.extension){
+        // profile(16) length(16) in 32 bits words
+        if(offset + 4 > sizeBytes){
+            return false;
+        }
+        offset += 4 + Z_RBE16(bytes + offset + 2) * 4;
+        if(offset > sizeBytes){
+            return false;
+        }
+    }
+    size_t end = sizeBytes;
+    if(header.padding){
+        uint8_t padding = bytes[sizeBytes - 1];
+        if(!padding || padding > end - offset){
+            return false;
+        }
+        end -= padding;
+    }
+    packet->payload = bytes + offset;
+    packet->payload_size = end - offset;
+    return true;
+}
+
+size_t rtp_write_header(uint8_t* out,const rtp_header& header){
+    out[0] = (uint8_t)(RTP_VERSION << 6);
+    out[1] = (uint8_t)((header.marker ? 0x80 : 0x00) | (header.payload_type & 0x7F));
+    Z_WBE16(out + 2,header.seq);
+    Z_WBE32(out + 4,header.timestamp);
+    Z_WBE32(out + 8,header.ssrc);
+    return RTP_HEADER_SIZE;
+}
+
+};//!namespace zav
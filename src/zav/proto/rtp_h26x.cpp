@@ -0,0 +1,471 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+#include "zav/proto/rtp_h26x.h"
+
+#include <string.h>
+#include <algorithm>
+#include <zpkg/utility.h>
+#include "zcf/memory.hpp"
+#include <zlog/log.h>
+
+namespace zav{
+
+static const uint8_t kStartCode[NALU_LONG_PREFIX] = {0x00,0x00,0x00,0x01};
+
+rtp_h26x_depacketizer::rtp_h26x_depacketizer(AVCodecID codec,on_frame_t on_frame,size_t reorder_window,
+    size_t max_packet_size,size_t max_frame_size,uint32_t max_delay_ms)
+    : codec_(codec),on_frame_(std::move(on_frame)),
+    builder_(codec,[this](const h26x_frame& frame){
+        if(!frame_lost_){
+            on_frame_(frame,timestamp_);
+            return;
+        }
+        h26x_frame incomplete = frame;
+        incomplete.flags |= H26X_FRAME_FLAG_INCOMPLETE;
+        on_frame_(incomplete,timestamp_);
+    }),
+    reorder_((reorder_window + RTP_JITTER_SPARE_BUFFERS) * max_packet_size,max_packet_size,max_delay_ms),
+    frame_(max_frame_size){
+    Z_ASSERT(codec == AV_CODEC_VIDEO_H264 || codec == AV_CODEC_VIDEO_H265);
+    Z_ASSERT(reorder_window && (reorder_window & (reorder_window - 1)) == 0);
+    reset();
+}
+
+void rtp_h26x_depacketizer::reset(){
+    reorder_.reset();
+    reorder_ssrc_ = 0;
+    reorder_started_ = false;
+    next_seq_ = 0;
+    ssrc_ = 0;
+    started_ = false;
+    gap_ = false;
+    frame_size_ = 0;
+    fu_offset_ = 0;
+    fu_open_ = false;
+    frame_lost_ = false;
+    frame_overflow_ = false;
+    timestamp_ = 0;
+    lost_packets_ = 0;
+    builder_.reset();
+}
+
+void rtp_h26x_depacketizer::input(const uint8_t* packet,size_t sizeBytes,uint64_t now_ms){
+    rtp_packet rtp;
+    if(!rtp_parse(packet,sizeBytes,&rtp)){
+        return;
+    }
+    if(reorder_started_ && rtp.header.ssrc != reorder_ssrc_){
+        // new source,sequence restart
+        flush();
+        reorder_.reset();
+    }
+    reorder_started_ = true;
+    reorder_ssrc_ = rtp.header.ssrc;
+    size_t capacity = 0;
+    uint8_t* buffer = reorder_.acquire(&capacity);
+    if(buffer && sizeBytes <= capacity){
+        // late or duplicate is rejected,too large one is recovered as loss
+        memcpy(buffer,packet,sizeBytes);
+        reorder_.insert(sizeBytes,now_ms);
+    }
+    poll(now_ms);
+}
+
+void rtp_h26x_depacketizer::input(const rtp_packet& packet){
+    if(started_ && packet.header.ssrc != ssrc_){
+        // new source,sequence and timestamp restart
+        emit_frame();
+        started_ = false;
+    }
+    if(!started_){
+        started_ = true;
+        ssrc_ = packet.header.ssrc;
+        next_seq_ = packet.header.seq;
+        timestamp_ = packet.header.timestamp;
+    }
+    int16_t diff = rtp_seq_diff(packet.header.seq,next_seq_);
+    if(diff < 0){
+        // late or duplicate
+        return;
+    }
+    if(diff > 0){
+        mark_lost((size_t)diff);
+    }
+    next_seq_ = (uint16_t)(packet.header.seq + 1);
+    process(packet);
+}
+
+void rtp_h26x_depacketizer::poll(uint64_t now_ms){
+    rtp_jitter_packet packet;
+    while(reorder_.pop(now_ms,&packet)){
+        input(packet.rtp);
+        reorder_.release(packet);
+    }
+}
+
+void rtp_h26x_depacketizer::flush(){
+    // every wait is over
+    poll(UINT64_MAX);
+    emit_frame();
+}
+
+void rtp_h26x_depacketizer::mark_lost(size_t count){
+    lost_packets_ += count;
+    gap_ = true;
+    frame_lost_ = true;
+    if(fu_open_){
+        // rest of the fragmented nalu is gone
+        frame_size_ = fu_offset_;
+        fu_open_ = false;
+    }
+}
+
+void rtp_h26x_depacketizer::process(const rtp_packet& packet){
+    if(packet.header.timestamp != timestamp_){
+        // marker bit lost,the frame before end here
+        bool gap = gap_;
+        emit_frame();
+        frame_lost_ = gap;
+        timestamp_ = packet.header.timestamp;
+    }
+    gap_ = false;
+    if(packet.payload_size){
+        if(codec_ == AV_CODEC_VIDEO_H264){
+            process_h264(packet.payload,packet.payload_size);
+        }else{
+            process_h265(packet.payload,packet.payload_size);
+        }
+    }
+    if(packet.header.marker){
+        emit_frame();
+    }
+}
+
+void rtp_h26x_depacketizer::process_h264(const uint8_t* payload,size_t size){
+    uint8_t type = payload[0] & 0x1F;
+    if(type >= 1 && type <= 23){
+        append_nalu(payload,size);
+    }else if(type == RTP_H264_STAP_A){
+        process_aggregate(payload + 1,size - 1);
+    }else if(type == RTP_H264_FU_A){
+        if(size < 2){
+            return;
+        }
+        // nalu header = F|NRI of indicator + type of fu header
+        uint8_t header = (uint8_t)((payload[0] & 0xE0) | (payload[1] & 0x1F));
+        process_fragment(&header,1,(payload[1] & 0x80) != 0,(payload[1] & 0x40) != 0,payload + 2,size - 2);
+    }
+    // STAP-B/MTAP/FU-B only in interleaved mode
+}
+
+void rtp_h26x_depacketizer::process_h265(const uint8_t* payload,size_t size){
+    if(size < 2){
+        return;
+    }
+    uint8_t type = (payload[0] >> 1) & 0x3F;
+    if(type < RTP_H265_AP){
+        append_nalu(payload,size);
+    }else if(type == RTP_H265_AP){
+        process_aggregate(payload + 2,size - 2);
+    }else if(type == RTP_H265_FU){
+        if(size < 3){
+            return;
+        }
+        // F|LayerId|TID of payload header,type of fu header
+        uint8_t header[2] = {(uint8_t)((payload[0] & 0x81) | ((payload[2] & 0x3F) << 1)),payload[1]};
+        process_fragment(header,2,(payload[2] & 0x80) != 0,(payload[2] & 0x40) != 0,payload + 3,size - 3);
+    }
+    // PACI is not supported
+}
+
+void rtp_h26x_depacketizer::process_aggregate(const uint8_t* payload,size_t size){
+    // 16 bits size + nalu,DONL/DOND absent when sprop-max-don-diff is 0
+    while(size >= 2){
+        size_t nalu_size = Z_RBE16(payload);
+        if(!nalu_size || nalu_size > size - 2){
+            break;
+        }
+        append_nalu(payload + 2,nalu_size);
+        payload += 2 + nalu_size;
+        size -= 2 + nalu_size;
+    }
+}
+
+void rtp_h26x_depacketizer::process_fragment(const uint8_t* header,size_t header_size,bool start,bool end,
+    const uint8_t* payload,size_t size){
+    if(start){
+        if(fu_open_){
+            // end fragment lost
+            frame_size_ = fu_offset_;
+            frame_lost_ = true;
+        }
+        fu_offset_ = frame_size_;
+        fu_open_ = append_bytes(kStartCode,sizeof(kStartCode)) && append_bytes(header,header_size);
+    }
+    if(!fu_open_){
+        return;
+    }
+    if(!append_bytes(payload,size)){
+        fu_open_ = false;
+        return;
+    }
+    if(end){
+        fu_open_ = false;
+        push_nalu(fu_offset_);
+    }
+}
+
+bool rtp_h26x_depacketizer::append_nalu(const uint8_t* nalu,size_t size){
+    size_t offset = frame_size_;
+    if(!append_bytes(kStartCode,sizeof(kStartCode)) || !append_bytes(nalu,size)){
+        return false;
+    }
+    push_nalu(offset);
+    return true;
+}
+
+bool rtp_h26x_depacketizer::append_bytes(const uint8_t* bytes,size_t size){
+    if(frame_overflow_ || size > frame_.size() - frame_size_){
+        if(!frame_overflow_){
+            zlog_warn("rtp h26x frame over {} bytes,dropped",frame_.size());
+        }
+        frame_overflow_ = true;
+        return false;
+    }
+    memcpy(frame_.data() + frame_size_,bytes,size);
+    frame_size_ += size;
+    return true;
+}
+
+void rtp_h26x_depacketizer::push_nalu(size_t offset){
+    h26x_nalu nalu;
+    nalu.prefix = NALU_LONG_PREFIX;
+    nalu.start = frame_.data() + offset;
+    nalu.end = frame_.data() + frame_size_ - 1;
+    nalu.header = frame_[offset + NALU_LONG_PREFIX];
+    builder_.push(nalu);
+}
+
+void rtp_h26x_depacketizer::emit_frame(){
+    if(fu_open_){
+        frame_size_ = fu_offset_;
+        fu_open_ = false;
+        frame_lost_ = true;
+    }
+    if(frame_overflow_){
+        builder_.reset();
+    }else{
+        builder_.flush();
+    }
+    frame_size_ = 0;
+    frame_lost_ = false;
+    frame_overflow_ = false;
+}
+
+// FU header of h265(3) or AP header with the first size(4)
+#define RTP_H26X_PAYLOAD_HEADER_MAX 4
+
+rtp_h26x_packetizer::rtp_h26x_packetizer(AVCodecID codec,uint8_t payload_type,uint32_t ssrc,
+    size_t mtu,uint16_t seq)
+    : codec_(codec),payload_type_(payload_type),ssrc_(ssrc),mtu_(mtu),seq_(seq),
+    header_used_(0),iov_used_(0),packet_iov_(0){
+    Z_ASSERT(codec == AV_CODEC_VIDEO_H264 || codec == AV_CODEC_VIDEO_H265);
+    Z_ASSERT(mtu > RTP_HEADER_SIZE + RTP_H26X_PAYLOAD_HEADER_MAX + 1);
+}
+
+size_t rtp_h26x_packetizer::packetize(const uint8_t* frame,size_t sizeBytes,uint32_t timestamp){
+    size_t count = h26x::annexb_index_nalus(frame,sizeBytes,nalus_);
+    return packetize(nalus_.data(),count,timestamp);
+}
+
+size_t rtp_h26x_packetizer::aggregate_count(const h26x_nalu* nalus,size_t nalu_count) const{
+    size_t payload_max = mtu_ - RTP_HEADER_SIZE;
+    size_t nalu_header_size = codec_ == AV_CODEC_VIDEO_H264 ? 1 : 2;
+    size_t size = nalu_header_size;
+    size_t count = 0;
+    for(;count < nalu_count;count++){
+        size_t nalu_size = h26x::nalu_size_trimmed(nalus[count]);
+        if(nalu_size < nalu_header_size || size + 2 + nalu_size > payload_max){
+            break;
+        }
+        size += 2 + nalu_size;
+    }
+    return count;
+}
+
+size_t rtp_h26x_packetizer::packetize(const h26x_nalu* nalus,size_t nalu_count,uint32_t timestamp){
+    packets_.clear();
+    bool h264 = codec_ == AV_CODEC_VIDEO_H264;
+    size_t nalu_header_size = h264 ? 1 : 2;
+    size_t fu_header_size = h264 ? 2 : 3;
+    size_t payload_max = mtu_ - RTP_HEADER_SIZE;
+    size_t fragment_max = payload_max - fu_header_size;
+
+    // upper bound first,iov and headers never move while packets point to them
+    size_t packet_count = 0;
+    for(size_t i = 0;i < nalu_count;i++){
+        packet_count += h26x::nalu_size_trimmed(nalus[i]) / fragment_max + 1;
+    }
+    headers_.resize(packet_count * (RTP_HEADER_SIZE + RTP_H26X_PAYLOAD_HEADER_MAX) + nalu_count * 2);
+    iov_.resize(packet_count * 2 + nalu_count * 2);
+    packets_.reserve(packet_count);
+    header_used_ = 0;
+    iov_used_ = 0;
+    // marker goes to the packet of the last nalu sent,empty ones after it are skipped,
+    // header only nalus(end of sequence/stream) are sent
+    size_t last = nalu_count;
+    while(last && h26x::nalu_size_trimmed(nalus[last - 1]) < nalu_header_size){
+        --last;
+    }
+
+    size_t i = 0;
+    while(i < nalu_count){
+        const uint8_t* data = h26x::nalu_data(nalus[i]);
+        size_t size = h26x::nalu_size_trimmed(nalus[i]);
+        if(size < nalu_header_size){
+            // empty or broken nalu
+            ++i;
+            continue;
+        }
+        size_t aggregate = aggregate_count(nalus + i,nalu_count - i);
+        if(aggregate >= 2){
+            // STAP-A:F|NRI(max)|24 / AP:F|type 48|LayerId(min)|TID(min)
+            uint8_t* header = begin_packet(nalu_header_size + 2,timestamp);
+            if(h264){
+                uint8_t f = 0,nri = 0;
+                for(size_t k = 0;k < aggregate;k++){
+                    uint8_t h = h26x::nalu_data(nalus[i + k])[0];
+                    f |= h & 0x80;
+                    nri = std::max<uint8_t>(nri,h & 0x60);
+                }
+                header[0] = (uint8_t)(f | nri | RTP_H264_STAP_A);
+            }else{
+                uint16_t f = 0,layer = 0x1F8,tid = 0x07;
+                for(size_t k = 0;k < aggregate;k++){
+                    uint16_t h = Z_RBE16(h26x::nalu_data(nalus[i + k]));
+                    f |= h & 0x8000;
+                    layer = std::min<uint16_t>(layer,h & 0x1F8);
+                    tid = std::min<uint16_t>(tid,h & 0x07);
+                }
+                Z_WBE16(header,(uint16_t)(f | (RTP_H265_AP << 9) | layer | tid));
+            }
+            for(size_t k = 0;k < aggregate;k++){
+                const h26x_nalu& nalu = nalus[i + k];
+                size_t nalu_size = h26x::nalu_size_trimmed(nalu);
+                uint8_t* length = header + nalu_header_size;
+                if(k){
+                    // the first size is in iov[0] with the headers
+                    length = headers_.data() + header_used_;
+                    header_used_ += 2;
+                    add_iov(length,2);
+                }
+                Z_WBE16(length,(uint16_t)nalu_size);
+                add_iov(h26x::nalu_data(nalu),nalu_size);
+            }
+            i += aggregate;
+            end_packet(i >= last);
+            continue;
+        }
+        ++i;
+        if(size <= payload_max){
+            begin_packet(0,timestamp);
+            add_iov(data,size);
+            end_packet(i >= last);
+            continue;
+        }
+        // FU-A:F|NRI|28 + S|E|R|type / FU:F|49|LayerId|TID + S|E|type,split evenly
+        const uint8_t* payload = data + nalu_header_size;
+        size_t remain = size - nalu_header_size;
+        size_t fragment_count = (remain + fragment_max - 1) / fragment_max;
+        size_t fragment_size = (remain + fragment_count - 1) / fragment_count;
+        bool start = true;
+        while(remain){
+            size_t bytes = std::min(fragment_size,remain);
+            bool end = bytes == remain;
+            uint8_t* header = begin_packet(fu_header_size,timestamp);
+            uint8_t se = (uint8_t)((start ? 0x80 : 0x00) | (end ? 0x40 : 0x00));
+            if(h264){
+                header[0] = (uint8_t)((data[0] & 0xE0) | RTP_H264_FU_A);
+                header[1] = (uint8_t)(se | (data[0] & 0x1F));
+            }else{
+                header[0] = (uint8_t)((data[0] & 0x81) | (RTP_H265_FU << 1));
+                header[1] = data[1];
+                header[2] = (uint8_t)(se | ((data[0] >> 1) & 0x3F));
+            }
+            add_iov(payload,bytes);
+            end_packet(end && i >= last);
+            payload += bytes;
+            remain -= bytes;
+            start = false;
+        }
+    }
+    return packets_.size();
+}
+
+uint8_t* rtp_h26x_packetizer::begin_packet(size_t header_size,uint32_t timestamp){
+    uint8_t* header = headers_.data() + header_used_;
+    rtp_header rtp;
+    memset(&rtp,0,sizeof(rtp));
+    rtp.payload_type = payload_type_;
+    rtp.seq = seq_++;
+    rtp.timestamp = timestamp;
+    rtp.ssrc = ssrc_;
+    rtp_write_header(header,rtp);
+    header_used_ += RTP_HEADER_SIZE + header_size;
+    packet_iov_ = iov_used_;
+    add_iov(header,RTP_HEADER_SIZE + header_size);
+    return header + RTP_HEADER_SIZE;
+}
+
+void rtp_h26x_packetizer::add_iov(const void* base,size_t size){
+    Z_ASSERT(iov_used_ < iov_.size());
+    iov_[iov_used_].iov_base = (void*)base;
+    iov_[iov_used_].iov_len = size;
+    ++iov_used_;
+}
+
+void rtp_h26x_packetizer::end_packet(bool marker){
+    av_iovec& rtp = iov_[packet_iov_];
+    if(marker){
+        ((uint8_t*)rtp.iov_base)[1] |= 0x80;
+    }
+    rtp_iov_packet packet;
+    packet.iov = &rtp;
+    packet.iov_count = iov_used_ - packet_iov_;
+    packet.size = 0;
+    for(size_t k = packet_iov_;k < iov_used_;k++){
+        packet.size += iov_[k].iov_len;
+    }
+    packets_.push_back(packet);
+}
+
+};//!namespace zav
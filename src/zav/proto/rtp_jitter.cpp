@@ -0,0 +1,250 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+#include "zav/proto/rtp_jitter.h"
+
+#include <zpkg/utility.h>
+#include "zcf/memory.hpp"
+
+namespace zav{
+
+rtp_jitter_buffer::rtp_jitter_buffer(size_t memory_budget,size_t max_packet_size,uint32_t max_delay_ms)
+    : max_packet_size_(max_packet_size),max_delay_ms_(max_delay_ms){
+    // spare buffers are in the budget too
+    size_t count = 2;
+    while((count * 2 + RTP_JITTER_SPARE_BUFFERS) * max_packet_size <= memory_budget){
+        count *= 2;
+    }
+    slots_.resize(count);
+    mask_ = count - 1;
+    pool_.resize((count + RTP_JITTER_SPARE_BUFFERS) * max_packet_size);
+    free_.reserve(count + RTP_JITTER_SPARE_BUFFERS);
+    reset();
+}
+
+void rtp_jitter_buffer::reset(){
+    free_.clear();
+    for(size_t i = slots_.size() + RTP_JITTER_SPARE_BUFFERS;i > 0;i--){
+        free_.push_back((uint32_t)(i - 1));
+    }
+    for(auto& s : slots_){
+        s.buffer = RTP_JITTER_INVALID_BUFFER;
+        s.seq = 0;
+        s.nack_count = 0;
+        s.size = 0;
+        s.arrival_ms = 0;
+        s.nack_ms = 0;
+    }
+    staging_ = RTP_JITTER_INVALID_BUFFER;
+    buffered_ = 0;
+    next_seq_ = 0;
+    highest_seq_ = 0;
+    started_ = false;
+    synced_ = false;
+    first_arrival_ms_ = 0;
+    lost_ = 0;
+    late_ = 0;
+    duplicated_ = 0;
+}
+
+uint8_t* rtp_jitter_buffer::acquire(size_t* capacity){
+    if(staging_ == RTP_JITTER_INVALID_BUFFER){
+        if(free_.empty()){
+            return nullptr;
+        }
+        staging_ = free_.back();
+        free_.pop_back();
+    }
+    *capacity = max_packet_size_;
+    return buffer_data(staging_);
+}
+
+bool rtp_jitter_buffer::insert(size_t sizeBytes,uint64_t now_ms){
+    Z_ASSERT(staging_ != RTP_JITTER_INVALID_BUFFER);
+    rtp_packet rtp;
+    if(sizeBytes > max_packet_size_ || !rtp_parse(buffer_data(staging_),sizeBytes,&rtp)){
+        return false;
+    }
+    uint16_t seq = rtp.header.seq;
+    if(!started_){
+        started_ = true;
+        next_seq_ = seq;
+        highest_seq_ = seq;
+        first_arrival_ms_ = now_ms;
+    }
+    int16_t diff = rtp_seq_diff(seq,next_seq_);
+    if(diff < 0 && !synced_ && (size_t)rtp_seq_diff(highest_seq_,seq) <= mask_){
+        // reordered before the first packet
+        next_seq_ = seq;
+        diff = 0;
+    }
+    if(diff < 0){
+        ++late_;
+        return false;
+    }
+    if((size_t)diff > mask_){
+        // ahead of the ring,older packets are given up
+        skip_to((uint16_t)(seq - mask_));
+    }
+    slot& s = slots_[seq & mask_];
+    if(s.buffer != RTP_JITTER_INVALID_BUFFER){
+        ++duplicated_;
+        return false;
+    }
+    s.buffer = staging_;
+    s.seq = seq;
+    s.size = sizeBytes;
+    s.arrival_ms = now_ms;
+    staging_ = RTP_JITTER_INVALID_BUFFER;
+    ++buffered_;
+    if(rtp_seq_before(highest_seq_,seq)){
+        highest_seq_ = seq;
+    }
+    return true;
+}
+
+void rtp_jitter_buffer::skip_to(uint16_t seq){
+    while(rtp_seq_before(next_seq_,seq)){
+        if(!buffered_){
+            lost_ += (uint16_t)(seq - next_seq_);
+            next_seq_ = seq;
+            break;
+        }
+        slot& s = slots_[next_seq_ & mask_];
+        if(s.buffer != RTP_JITTER_INVALID_BUFFER && s.seq == next_seq_){
+            free_.push_back(s.buffer);
+            s.buffer = RTP_JITTER_INVALID_BUFFER;
+            --buffered_;
+        }
+        ++lost_;
+        ++next_seq_;
+    }
+    if(rtp_seq_before(highest_seq_,next_seq_)){
+        highest_seq_ = next_seq_;
+    }
+}
+
+bool rtp_jitter_buffer::pop(uint64_t now_ms,rtp_jitter_packet* packet){
+    if(!synced_){
+        // first packet is held max_delay_ms to find the lowest sequence
+        if(!buffered_ || (!full() && now_ms - first_arrival_ms_ < max_delay_ms_)){
+            return false;
+        }
+        synced_ = true;
+    }
+    while(buffered_){
+        slot& s = slots_[next_seq_ & mask_];
+        if(s.buffer != RTP_JITTER_INVALID_BUFFER && s.seq == next_seq_){
+            packet->data = buffer_data(s.buffer);
+            packet->size = s.size;
+            packet->arrival_ms = s.arrival_ms;
+            packet->buffer = s.buffer;
+            rtp_parse(packet->data,packet->size,&packet->rtp);
+            s.buffer = RTP_JITTER_INVALID_BUFFER;
+            s.nack_count = 0;
+            s.nack_ms = 0;
+            ++next_seq_;
+            --buffered_;
+            return true;
+        }
+        // missing,wait until the packet after the gap is too old
+        size_t distance = 1;
+        for(;distance <= mask_;distance++){
+            const slot& next = slots_[(next_seq_ + distance) & mask_];
+            if(next.buffer != RTP_JITTER_INVALID_BUFFER && next.seq == (uint16_t)(next_seq_ + distance)){
+                break;
+            }
+        }
+        const slot& next = slots_[(next_seq_ + distance) & mask_];
+        if(distance > mask_ || (!full() && now_ms - next.arrival_ms < max_delay_ms_)){
+            return false;
+        }
+        lost_ += distance;
+        next_seq_ = (uint16_t)(next_seq_ + distance);
+    }
+    return false;
+}
+
+void rtp_jitter_buffer::release(const rtp_jitter_packet& packet){
+    Z_ASSERT(packet.buffer != RTP_JITTER_INVALID_BUFFER);
+    free_.push_back(packet.buffer);
+}
+
+size_t rtp_jitter_buffer::nacks(uint64_t now_ms,uint16_t* seqs,size_t max_count,uint32_t retry_ms,uint32_t max_retries){
+    size_t count = 0;
+    if(!buffered_){
+        return 0;
+    }
+    for(uint16_t seq = next_seq_;seq != highest_seq_ && count < max_count;seq++){
+        slot& s = slots_[seq & mask_];
+        if(s.buffer != RTP_JITTER_INVALID_BUFFER){
+            continue;
+        }
+        if(s.seq != seq){
+            // first time missing,may be reordered only
+            s.seq = seq;
+            s.nack_count = 0;
+            s.nack_ms = now_ms;
+            continue;
+        }
+        if(s.nack_count >= max_retries || now_ms - s.nack_ms < retry_ms){
+            continue;
+        }
+        s.nack_ms = now_ms;
+        ++s.nack_count;
+        seqs[count++] = seq;
+    }
+    return count;
+}
+
+size_t rtcp_nack_fci(const uint16_t* seqs,size_t count,uint8_t* out){
+    size_t size = 0;
+    size_t i = 0;
+    while(i < count){
+        // PID and bitmask of following lost packets
+        uint16_t pid = seqs[i++];
+        uint16_t blp = 0;
+        while(i < count){
+            int16_t diff = rtp_seq_diff(seqs[i],pid);
+            if(diff < 1 || diff > 16){
+                break;
+            }
+            blp |= (uint16_t)(1 << (diff - 1));
+            ++i;
+        }
+        Z_WBE16(out + size,pid);
+        Z_WBE16(out + size + 2,blp);
+        size += 4;
+    }
+    return size;
+}
+
+};//!namespace zav
@@ -32,6 +32,12 @@
 
 #include "zav/proto/rtsp.h"
 
+#include <string.h>
+#include <stdio.h>
+#include <algorithm>
+#include <zpkg/utility.h>
+#include "zcf/memory.hpp"
+
 namespace zav{
 static constexpr const char* kRTSP_TRANSPORT_DESCRIPTION[6] = {"TCP","UDP","MULTICAST","HTTP","WEBSOCKET","UNKNOWN"};
 
@@ -55,6 +61,592 @@ std::string desc_rtsp_transport(RTSP_TRANSPORT transport){
     return kRTSP_TRANSPORT_DESCRIPTION[transport];
 }
 
+static constexpr const char* kRTSP_METHOD_DESCRIPTION[RTSP_METHOD_UNKNOWN + 1] = {
+    "OPTIONS","DESCRIBE","ANNOUNCE","SETUP","PLAY","PAUSE","RECORD","TEARDOWN",
+    "GET_PARAMETER","SET_PARAMETER","REDIRECT","UNKNOWN"};
+
+const char* desc_rtsp_method(RTSP_METHOD method){
+    return kRTSP_METHOD_DESCRIPTION[method];
+}
+
+static inline char ascii_lower(char c){
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+static inline bool is_space(char c){
+    return c == ' ' || c == '\t';
+}
+
+static rtsp_slice make_slice(const char* begin,const char* end){
+    // trim OWS
+    while(begin < end && is_space(*begin)) ++begin;
+    while(end > begin && is_space(end[-1])) --end;
+    rtsp_slice slice;
+    slice.data = begin;
+    slice.size = end - begin;
+    return slice;
+}
+
+/**
+ * decimal without sign,false if empty,not digit or too long
+ */
+static bool parse_uint(const char* p,size_t size,int64_t* value){
+    if(!size || size > 18){
+        return false;
+    }
+    int64_t v = 0;
+    for(size_t i = 0;i < size;i++){
+        if(p[i] < '0' || p[i] > '9'){
+            return false;
+        }
+        v = v * 10 + (p[i] - '0');
+    }
+    *value = v;
+    return true;
+}
+
+/**
+ * a or a-b
+ */
+static void parse_range(const rtsp_slice& value,int range[2]){
+    const char* p = value.data;
+    const char* pend = p + value.size;
+    const char* dash = (const char*)memchr(p,'-',value.size);
+    int64_t v = 0;
+    if(parse_uint(p,(dash ? dash : pend) - p,&v) && v <= 65535){
+        range[0] = (int)v;
+    }
+    if(dash && parse_uint(dash + 1,pend - dash - 1,&v) && v <= 65535){
+        range[1] = (int)v;
+    }
+}
+
+bool rtsp_slice::equal(const char* str) const{
+    return strlen(str) == size && !memcmp(data,str,size);
+}
+
+bool rtsp_slice::iequal(const char* str) const{
+    for(size_t i = 0;i < size;i++){
+        if(!str[i] || ascii_lower(data[i]) != ascii_lower(str[i])){
+            return false;
+        }
+    }
+    return !str[size];
+}
+
+const rtsp_slice* rtsp_message::header(const char* name) const{
+    for(size_t i = 0;i < header_count;i++){
+        if(headers[i].name.iequal(name)){
+            return &headers[i].value;
+        }
+    }
+    return nullptr;
+}
+
+bool rtsp_parse_transport(const rtsp_slice& value,rtsp_transport_spec* spec){
+    spec->transport = RTSP_TRANSPORT_UNKNOWN;
+    spec->multicast = false;
+    spec->interleaved[0] = spec->interleaved[1] = -1;
+    spec->client_port[0] = spec->client_port[1] = -1;
+    spec->server_port[0] = spec->server_port[1] = -1;
+    spec->ttl = -1;
+    spec->ssrc = 0;
+    spec->has_ssrc = false;
+    spec->destination = make_slice(value.data,value.data);
+    spec->mode = spec->destination;
+
+    // first transport spec,RTP/AVP[/UDP|/TCP];param;param...
+    const char* p = value.data;
+    const char* pend = (const char*)memchr(p,',',value.size);
+    if(!pend){
+        pend = p + value.size;
+    }
+    bool first = true;
+    while(p < pend){
+        const char* semicolon = (const char*)memchr(p,';',pend - p);
+        const char* part_end = semicolon ? semicolon : pend;
+        const char* equal = (const char*)memchr(p,'=',part_end - p);
+        rtsp_slice name = make_slice(p,equal ? equal : part_end);
+        rtsp_slice param = make_slice(equal ? equal + 1 : part_end,part_end);
+        if(param.size >= 2 && param.data[0] == '"' && param.data[param.size - 1] == '"'){
+            ++param.data;
+            param.size -= 2;
+        }
+        if(first){
+            if(name.iequal("RTP/AVP") || name.iequal("RTP/AVP/UDP")){
+                spec->transport = RTSP_TRANSPORT_UDP;
+            }else if(name.iequal("RTP/AVP/TCP")){
+                spec->transport = RTSP_TRANSPORT_TCP;
+            }else{
+                return false;
+            }
+            first = false;
+        }else if(name.iequal("multicast")){
+            spec->multicast = true;
+            spec->transport = RTSP_TRANSPORT_UDP_MULTICAST;
+        }else if(name.iequal("interleaved")){
+            parse_range(param,spec->interleaved);
+        }else if(name.iequal("client_port")){
+            parse_range(param,spec->client_port);
+        }else if(name.iequal("server_port") || name.iequal("port")){
+            parse_range(param,spec->server_port);
+        }else if(name.iequal("ttl")){
+            int64_t ttl = 0;
+            if(parse_uint(param.data,param.size,&ttl) && ttl <= 255){
+                spec->ttl = (int)ttl;
+            }
+        }else if(name.iequal("ssrc")){
+            uint32_t ssrc = 0;
+            size_t i = 0;
+            for(;i < param.size && i < 8;i++){
+                char c = ascii_lower(param.data[i]);
+                if(c >= '0' && c <= '9') ssrc = (ssrc << 4) | (uint32_t)(c - '0');
+                else if(c >= 'a' && c <= 'f') ssrc = (ssrc << 4) | (uint32_t)(c - 'a' + 10);
+                else break;
+            }
+            if(i && i == param.size){
+                spec->ssrc = ssrc;
+                spec->has_ssrc = true;
+            }
+        }else if(name.iequal("destination")){
+            spec->destination = param;
+        }else if(name.iequal("mode")){
+            spec->mode = param;
+        }
+        p = part_end + 1;
+    }
+    return !first;
+}
+
+rtsp_parser::rtsp_parser(){
+    reset();
+}
+
+void rtsp_parser::reset(){
+    memset(&message_,0,sizeof(message_));
+    memset(&interleaved_,0,sizeof(interleaved_));
+    scanned_ = 0;
+    head_size_ = 0;
+}
+
+RTSP_PARSE_RESULT rtsp_parser::parse(const uint8_t* bytes,size_t sizeBytes,size_t* consumed){
+    *consumed = 0;
+    const char* data = (const char*)bytes;
+    if(!head_size_){
+        if(!scanned_){
+            // CRLF keepalive between messages
+            size_t skip = 0;
+            while(skip < sizeBytes && (data[skip] == '\r' || data[skip] == '\n')){
+                ++skip;
+            }
+            if(skip){
+                *consumed = skip;
+                return RTSP_PARSE_NEED_MORE;
+            }
+        }
+        if(sizeBytes && bytes[0] == '$'){
+            if(sizeBytes < RTSP_INTERLEAVED_HEADER_SIZE){
+                return RTSP_PARSE_NEED_MORE;
+            }
+            size_t size = Z_RBE16(bytes + 2);
+            if(sizeBytes < RTSP_INTERLEAVED_HEADER_SIZE + size){
+                return RTSP_PARSE_NEED_MORE;
+            }
+            interleaved_.channel = bytes[1];
+            interleaved_.data = bytes + RTSP_INTERLEAVED_HEADER_SIZE;
+            interleaved_.size = size;
+            *consumed = RTSP_INTERLEAVED_HEADER_SIZE + size;
+            return RTSP_PARSE_INTERLEAVED;
+        }
+        // empty line(\n\n or \n\r\n) end the header,only new bytes are searched
+        size_t pos = scanned_;
+        while(pos < sizeBytes){
+            const char* lf = (const char*)memchr(data + pos,'\n',sizeBytes - pos);
+            if(!lf){
+                pos = sizeBytes;
+                break;
+            }
+            pos = lf - data + 1;
+            size_t i = lf - data;
+            if((i >= 1 && data[i - 1] == '\n') || (i >= 2 && data[i - 1] == '\r' && data[i - 2] == '\n')){
+                head_size_ = pos;
+                break;
+            }
+        }
+        if(!head_size_){
+            scanned_ = pos;
+            if(sizeBytes > RTSP_MAX_HEADER_SIZE){
+                reset();
+                return RTSP_PARSE_ERROR;
+            }
+            return RTSP_PARSE_NEED_MORE;
+        }
+    }
+    // head is parsed again when body is complete,buffer may be moved
+    if(!parse_head(data,head_size_)){
+        reset();
+        return RTSP_PARSE_ERROR;
+    }
+    size_t body_size = message_.content_length > 0 ? (size_t)message_.content_length : 0;
+    if(sizeBytes - head_size_ < body_size){
+        return RTSP_PARSE_NEED_MORE;
+    }
+    message_.body.data = data + head_size_;
+    message_.body.size = body_size;
+    *consumed = head_size_ + body_size;
+    scanned_ = 0;
+    head_size_ = 0;
+    return RTSP_PARSE_MESSAGE;
+}
+
+bool rtsp_parser::parse_head(const char* head,size_t size){
+    message_.response = false;
+    message_.method = RTSP_METHOD_UNKNOWN;
+    message_.status = 0;
+    message_.cseq = -1;
+    message_.content_length = -1;
+    message_.method_name = message_.uri = message_.version = message_.reason = make_slice(head,head);
+    message_.session = message_.transport = message_.body = message_.reason;
+    message_.header_count = 0;
+
+    const char* p = head;
+    const char* pend = head + size;
+    bool start_line = true;
+    while(p < pend){
+        const char* lf = (const char*)memchr(p,'\n',pend - p);
+        const char* line_end = lf ? lf : pend;
+        size_t line_size = line_end - p;
+        if(line_size && p[line_size - 1] == '\r'){
+            --line_size;
+        }
+        if(!line_size){
+            break;
+        }
+        if(start_line){
+            if(!parse_start_line(p,line_size)){
+                return false;
+            }
+            start_line = false;
+        }else{
+            parse_header(p,line_size);
+        }
+        p = line_end + 1;
+    }
+    return !start_line;
+}
+
+bool rtsp_parser::parse_start_line(const char* line,size_t size){
+    const char* pend = line + size;
+    const char* sp1 = (const char*)memchr(line,' ',size);
+    if(!sp1){
+        return false;
+    }
+    if(size > 5 && !memcmp(line,"RTSP/",5)){
+        // RTSP/1.0 200 OK
+        message_.response = true;
+        message_.version = make_slice(line,sp1);
+        const char* code = sp1 + 1;
+        const char* sp2 = (const char*)memchr(code,' ',pend - code);
+        int64_t status = 0;
+        if(!parse_uint(code,(sp2 ? sp2 : pend) - code,&status) || status < 100 || status > 999){
+            return false;
+        }
+        message_.status = (int)status;
+        message_.reason = make_slice(sp2 ? sp2 + 1 : pend,pend);
+        return true;
+    }
+    // DESCRIBE rtsp://host/path RTSP/1.0
+    const char* uri = sp1 + 1;
+    const char* sp2 = (const char*)memchr(uri,' ',pend - uri);
+    if(!sp2){
+        return false;
+    }
+    message_.method_name = make_slice(line,sp1);
+    message_.uri = make_slice(uri,sp2);
+    message_.version = make_slice(sp2 + 1,pend);
+    if(message_.version.size < 5 || memcmp(message_.version.data,"RTSP/",5)){
+        return false;
+    }
+    for(int i = 0;i < RTSP_METHOD_UNKNOWN;i++){
+        if(message_.method_name.equal(kRTSP_METHOD_DESCRIPTION[i])){
+            message_.method = (RTSP_METHOD)i;
+            break;
+        }
+    }
+    return true;
+}
+
+void rtsp_parser::parse_header(const char* line,size_t size){
+    const char* colon = (const char*)memchr(line,':',size);
+    if(!colon){
+        return;
+    }
+    rtsp_header_field field;
+    field.name = make_slice(line,colon);
+    field.value = make_slice(colon + 1,line + size);
+    if(message_.header_count < RTSP_MAX_HEADERS){
+        message_.headers[message_.header_count++] = field;
+    }
+    const rtsp_slice& name = field.name;
+    const rtsp_slice& value = field.value;
+    if(name.iequal("CSeq")){
+        int64_t cseq = 0;
+        if(parse_uint(value.data,value.size,&cseq)){
+            message_.cseq = cseq;
+        }
+    }else if(name.iequal("Content-Length")){
+        int64_t length = 0;
+        if(parse_uint(value.data,value.size,&length)){
+            message_.content_length = length;
+        }
+    }else if(name.iequal("Session")){
+        const char* semicolon = (const char*)memchr(value.data,';',value.size);
+        message_.session = make_slice(value.data,semicolon ? semicolon : value.data + value.size);
+    }else if(name.iequal("Transport")){
+        message_.transport = value;
+    }
+}
+
+rtsp_writer::rtsp_writer(char* buffer,size_t capacity)
+    : buffer_(buffer),capacity_(capacity),size_(0),overflow_(false){
+}
+
+void rtsp_writer::append(const char* str,size_t size){
+    if(overflow_ || size > capacity_ - size_){
+        overflow_ = true;
+        return;
+    }
+    memcpy(buffer_ + size_,str,size);
+    size_ += size;
+}
+
+rtsp_writer& rtsp_writer::request_line(RTSP_METHOD method,const char* uri){
+    const char* name = desc_rtsp_method(method);
+    append(name,strlen(name));
+    append(" ",1);
+    append(uri,strlen(uri));
+    append(" RTSP/1.0\r\n",11);
+    return *this;
+}
+
+rtsp_writer& rtsp_writer::status_line(int status,const char* reason){
+    char line[32];
+    int size = snprintf(line,sizeof(line),"RTSP/1.0 %d ",status);
+    append(line,(size_t)size);
+    if(!reason){
+        reason = rtsp_status_reason(status);
+    }
+    append(reason,strlen(reason));
+    append("\r\n",2);
+    return *this;
+}
+
+rtsp_writer& rtsp_writer::header(const char* name,const char* value){
+    append(name,strlen(name));
+    append(": ",2);
+    append(value,strlen(value));
+    append("\r\n",2);
+    return *this;
+}
+
+rtsp_writer& rtsp_writer::header(const char* name,const rtsp_slice& value){
+    append(name,strlen(name));
+    append(": ",2);
+    append(value.data,value.size);
+    append("\r\n",2);
+    return *this;
+}
+
+rtsp_writer& rtsp_writer::header_int(const char* name,int64_t value){
+    char number[24];
+    int size = snprintf(number,sizeof(number),"%lld",(long long)value);
+    append(name,strlen(name));
+    append(": ",2);
+    append(number,(size_t)size);
+    append("\r\n",2);
+    return *this;
+}
+
+size_t rtsp_writer::end(const char* body,size_t body_size){
+    if(body_size){
+        header_int("Content-Length",(int64_t)body_size);
+    }
+    append("\r\n",2);
+    if(body_size){
+        append(body,body_size);
+    }
+    return size();
+}
+
+rtsp_tcp_demuxer::rtsp_tcp_demuxer(on_message_t on_message,size_t capacity)
+    : on_message_(std::move(on_message)),channels_(256),buffer_(capacity),buffered_(0){
+}
+
+void rtsp_tcp_demuxer::set_channel(uint8_t channel,on_channel_t on_data){
+    channels_[channel] = std::move(on_data);
+}
+
+void rtsp_tcp_demuxer::set_channels(const rtsp_transport_spec& spec,on_channel_t on_rtp,on_channel_t on_rtcp){
+    if(spec.interleaved[0] >= 0 && spec.interleaved[0] <= 255){
+        set_channel((uint8_t)spec.interleaved[0],std::move(on_rtp));
+    }
+    if(spec.interleaved[1] >= 0 && spec.interleaved[1] <= 255){
+        set_channel((uint8_t)spec.interleaved[1],std::move(on_rtcp));
+    }
+}
+
+void rtsp_tcp_demuxer::reset(){
+    parser_.reset();
+    buffered_ = 0;
+}
+
+size_t rtsp_tcp_demuxer::process(const uint8_t* bytes,size_t sizeBytes,bool* error){
+    const uint8_t* p = bytes;
+    const uint8_t* pend = bytes + sizeBytes;
+    while(p < pend){
+        size_t consumed = 0;
+        RTSP_PARSE_RESULT result = parser_.parse(p,pend - p,&consumed);
+        if(result == RTSP_PARSE_INTERLEAVED){
+            const rtsp_interleaved& frame = parser_.interleaved();
+            const on_channel_t& on_data = channels_[frame.channel];
+            if(on_data){
+                on_data(frame.channel,frame.data,frame.size);
+            }
+        }else if(result == RTSP_PARSE_MESSAGE){
+            if(on_message_){
+                on_message_(parser_.message());
+            }
+        }else if(result == RTSP_PARSE_ERROR){
+            *error = true;
+            break;
+        }else if(!consumed){
+            // RTSP_PARSE_NEED_MORE
+            break;
+        }
+        p += consumed;
+    }
+    return p - bytes;
+}
+
+bool rtsp_tcp_demuxer::process_buffer(){
+    bool error = false;
+    size_t consumed = process(buffer_.data(),buffered_,&error);
+    if(error){
+        reset();
+        return false;
+    }
+    // keep the partial frame only
+    buffered_ -= consumed;
+    if(consumed && buffered_){
+        memmove(buffer_.data(),buffer_.data() + consumed,buffered_);
+    }
+    if(buffered_ == buffer_.size()){
+        // frame larger than capacity
+        reset();
+        return false;
+    }
+    return true;
+}
+
+bool rtsp_tcp_demuxer::input(const uint8_t* bytes,size_t sizeBytes){
+    while(sizeBytes){
+        if(!buffered_){
+            // zero copy,only the tail partial frame is copied
+            bool error = false;
+            size_t consumed = process(bytes,sizeBytes,&error);
+            if(error){
+                reset();
+                return false;
+            }
+            bytes += consumed;
+            sizeBytes -= consumed;
+            if(sizeBytes >= buffer_.size()){
+                reset();
+                return false;
+            }
+            memcpy(buffer_.data(),bytes,sizeBytes);
+            buffered_ = sizeBytes;
+            return true;
+        }
+        size_t size = std::min(sizeBytes,buffer_.size() - buffered_);
+        memcpy(buffer_.data() + buffered_,bytes,size);
+        buffered_ += size;
+        bytes += size;
+        sizeBytes -= size;
+        if(!process_buffer()){
+            return false;
+        }
+    }
+    return true;
+}
+
+uint8_t* rtsp_tcp_demuxer::write_buffer(size_t* size){
+    *size = buffer_.size() - buffered_;
+    return buffer_.data() + buffered_;
+}
+
+bool rtsp_tcp_demuxer::commit(size_t sizeBytes){
+    Z_ASSERT(buffered_ + sizeBytes <= buffer_.size());
+    buffered_ += sizeBytes;
+    return process_buffer();
+}
+
+size_t rtsp_write_interleaved_header(uint8_t* out,uint8_t channel,uint16_t size){
+    out[0] = '$';
+    out[1] = channel;
+    Z_WBE16(out + 2,size);
+    return RTSP_INTERLEAVED_HEADER_SIZE;
+}
+
+const char* rtsp_status_reason(int status){
+    switch(status){
+        case 100: return "Continue";
+        case 200: return "OK";
+        case 201: return "Created";
+        case 250: return "Low on Storage Space";
+        case 300: return "Multiple Choices";
+        case 301: return "Moved Permanently";
+        case 302: return "Moved Temporarily";
+        case 304: return "Not Modified";
+        case 305: return "Use Proxy";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 402: return "Payment Required";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 406: return "Not Acceptable";
+        case 407: return "Proxy Authentication Required";
+        case 408: return "Request Time-out";
+        case 410: return "Gone";
+        case 411: return "Length Required";
+        case 412: return "Precondition Failed";
+        case 413: return "Request Entity Too Large";
+        case 414: return "Request-URI Too Large";
+        case 415: return "Unsupported Media Type";
+        case 451: return "Parameter Not Understood";
+        case 452: return "Conference Not Found";
+        case 453: return "Not Enough Bandwidth";
+        case 454: return "Session Not Found";
+        case 455: return "Method Not Valid in This State";
+        case 456: return "Header Field Not Valid for Resource";
+        case 457: return "Invalid Range";
+        case 458: return "Parameter Is Read-Only";
+        case 459: return "Aggregate operation not allowed";
+        case 460: return "Only aggregate operation allowed";
+        case 461: return "Unsupported transport";
+        case 462: return "Destination unreachable";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        case 504: return "Gateway Time-out";
+        case 505: return "RTSP Version not supported";
+        case 551: return "Option not supported";
+        default: return "Unknown";
+    }
+}
+
 
 
 };//!namespace zav
\ No newline at end of file
@@ -0,0 +1,549 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+#include "zav/proto/sdp.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "zcf/zcf_base64.hpp"
+#include "zcf/zcf_buffer.hpp"
+
+namespace zav{
+
+static const int kAAC_SAMPLE_RATES[13] = {96000,88200,64000,48000,44100,32000,24000,22050,16000,12000,11025,8000,7350};
+
+static bool iequal(const std::string& a,const char* b){
+    return strcasecmp(a.c_str(),b) == 0;
+}
+
+static std::string trim(const std::string& str){
+    size_t begin = str.find_first_not_of(" \t");
+    if(begin == std::string::npos){
+        return std::string();
+    }
+    size_t end = str.find_last_not_of(" \t");
+    return str.substr(begin,end - begin + 1);
+}
+
+static std::vector<std::string> split(const std::string& str,char delim){
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    while(begin <= str.size()){
+        size_t end = str.find(delim,begin);
+        if(end == std::string::npos){
+            end = str.size();
+        }
+        std::string part = trim(str.substr(begin,end - begin));
+        if(!part.empty()){
+            parts.push_back(part);
+        }
+        begin = end + 1;
+    }
+    return parts;
+}
+
+static std::string to_hex(const uint8_t* bytes,size_t size){
+    static const char kHex[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(size * 2);
+    for(size_t i = 0;i < size;i++){
+        hex.push_back(kHex[bytes[i] >> 4]);
+        hex.push_back(kHex[bytes[i] & 0x0F]);
+    }
+    return hex;
+}
+
+static std::vector<uint8_t> from_hex(const std::string& hex){
+    std::vector<uint8_t> bytes;
+    for(size_t i = 0;i + 1 < hex.size();i += 2){
+        char pair[3] = {hex[i],hex[i + 1],0};
+        char* end = nullptr;
+        long v = strtol(pair,&end,16);
+        if(end != pair + 2){
+            bytes.clear();
+            break;
+        }
+        bytes.push_back((uint8_t)v);
+    }
+    return bytes;
+}
+
+/**
+ * comma separated base64 nalus,RFC 6184 8.1/RFC 7798 7.1
+ */
+static void decode_parameter_sets(const std::string& value,std::vector<std::vector<uint8_t>>& parameter_sets){
+    for(const auto& b64 : split(value,',')){
+        std::string nalu = zcf::base64decode(b64);
+        if(!nalu.empty()){
+            parameter_sets.push_back(std::vector<uint8_t>(nalu.begin(),nalu.end()));
+        }
+    }
+}
+
+static std::string encode_parameter_sets(const std::vector<std::vector<uint8_t>>& parameter_sets,
+    AVCodecID codec,int type){
+    std::string value;
+    for(const auto& nalu : parameter_sets){
+        if(nalu.empty()){
+            continue;
+        }
+        int nalu_type = codec == AV_CODEC_VIDEO_H264 ? H264_NALU_TYPE(nalu[0]) : H265_NALU_TYPE(nalu[0]);
+        if(nalu_type != type){
+            continue;
+        }
+        if(!value.empty()){
+            value.push_back(',');
+        }
+        value += zcf::base64encode(std::string(nalu.begin(),nalu.end()));
+    }
+    return value;
+}
+
+/**
+ * width/height/fps of the first valid sps
+ */
+static void parse_video_info(sdp_media* media){
+    for(const auto& nalu : media->parameter_sets){
+        if(nalu.empty()){
+            continue;
+        }
+        if(media->codec == AV_CODEC_VIDEO_H264 && H264_NALU_TYPE(nalu[0]) == H264_NALU_SPS){
+            h264_sps sps;
+            if(h264::parse_sps(nalu.data(),nalu.size(),&sps)){
+                media->width = sps.width;
+                media->height = sps.height;
+                media->fps = sps.fps;
+                return;
+            }
+        }else if(media->codec == AV_CODEC_VIDEO_H265 && H265_NALU_TYPE(nalu[0]) == H265_NALU_SPS){
+            h265_sps sps;
+            if(h265::parse_sps(nalu.data(),nalu.size(),&sps)){
+                media->width = sps.width;
+                media->height = sps.height;
+                media->fps = sps.fps;
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * AudioSpecificConfig,ISO 14496-3 1.6.2.1
+ */
+static void parse_aac_config(sdp_media* media){
+    zcf::bit_buffer bits(media->config.data(),media->config.size());
+    // audioObjectType,audioObjectTypeExt
+    if(bits.read_bits(5) == 31){
+        bits.skip_bits(6);
+    }
+    uint32_t frequency_index = bits.read_bits(4);
+    uint32_t sample_rate = frequency_index == 0x0F ? bits.read_bits(24)
+        : (frequency_index < 13 ? kAAC_SAMPLE_RATES[frequency_index] : 0);
+    uint32_t channels = bits.read_bits(4);
+    if(bits.overrun()){
+        return;
+    }
+    if(sample_rate && !media->clock_rate){
+        media->clock_rate = (int)sample_rate;
+    }
+    if(channels && !media->channels){
+        media->channels = (int)channels;
+    }
+}
+
+/**
+ * static payload types,RFC 3551 6
+ */
+static void static_payload_type(sdp_media* media){
+    switch(media->payload_type){
+        case 0:
+            media->encoding = "PCMU";
+            media->clock_rate = 8000;
+            media->channels = 1;
+            break;
+        case 8:
+            media->encoding = "PCMA";
+            media->clock_rate = 8000;
+            media->channels = 1;
+            break;
+        case 9:
+            media->encoding = "G722";
+            media->clock_rate = 8000;
+            media->channels = 1;
+            break;
+        case 4:
+            media->encoding = "G723";
+            media->clock_rate = 8000;
+            media->channels = 1;
+            break;
+        case 18:
+            media->encoding = "G729";
+            media->clock_rate = 8000;
+            media->channels = 1;
+            break;
+        default:
+            break;
+    }
+}
+
+static AVCodecID codec_of_encoding(const std::string& encoding){
+    if(iequal(encoding,"H264")) return AV_CODEC_VIDEO_H264;
+    if(iequal(encoding,"H265") || iequal(encoding,"HEVC")) return AV_CODEC_VIDEO_H265;
+    if(iequal(encoding,"PCMA")) return AV_CODEC_AUDIO_G711_ALAW;
+    if(iequal(encoding,"PCMU")) return AV_CODEC_AUDIO_G711_MULAW;
+    if(iequal(encoding,"G722")) return AV_CODEC_AUDIO_G722;
+    if(iequal(encoding,"G7221")) return AV_CODEC_AUDIO_G722_1;
+    if(iequal(encoding,"G723")) return AV_CODEC_AUDIO_G723_1;
+    if(iequal(encoding,"G729")) return AV_CODEC_AUDIO_G729;
+    if(iequal(encoding,"MPEG4-GENERIC") || iequal(encoding,"MP4A-LATM")) return AV_CDEOC_AUDIO_AAC;
+    if(iequal(encoding,"OPUS")) return AV_CODEC_AUDIO_OPUS;
+    if(iequal(encoding,"L16")) return AV_CODEC_AUDIO_S16BE;
+    return AV_CODEC_UNKNOWN;
+}
+
+/**
+ * codec parameters of fmtp,after all a= lines of media
+ */
+static void parse_codec_parameters(sdp_media* media){
+    if(media->encoding.empty()){
+        static_payload_type(media);
+    }
+    media->codec = codec_of_encoding(media->encoding);
+    if(media->codec == AV_CODEC_VIDEO_H264){
+        const std::string* mode = media->fmtp_value("packetization-mode");
+        media->packetization_mode = mode ? atoi(mode->c_str()) : 0;
+        const std::string* sprop = media->fmtp_value("sprop-parameter-sets");
+        if(sprop){
+            decode_parameter_sets(*sprop,media->parameter_sets);
+        }
+        parse_video_info(media);
+    }else if(media->codec == AV_CODEC_VIDEO_H265){
+        static const char* kSPROP[3] = {"sprop-vps","sprop-sps","sprop-pps"};
+        for(const char* key : kSPROP){
+            const std::string* sprop = media->fmtp_value(key);
+            if(sprop){
+                decode_parameter_sets(*sprop,media->parameter_sets);
+            }
+        }
+        parse_video_info(media);
+    }else if(media->codec == AV_CDEOC_AUDIO_AAC){
+        const std::string* config = media->fmtp_value("config");
+        if(config && iequal(media->encoding,"MPEG4-GENERIC")){
+            media->config = from_hex(*config);
+            parse_aac_config(media);
+        }
+    }
+}
+
+const std::string* sdp_media::fmtp_value(const char* key) const{
+    for(const auto& kv : fmtp){
+        if(iequal(kv.first,key)){
+            return &kv.second;
+        }
+    }
+    return nullptr;
+}
+
+bool sdp_media::update_params(h264_param_cache& cache) const{
+    bool has_sps = false;
+    for(const auto& nalu : parameter_sets){
+        if(nalu.empty()){
+            continue;
+        }
+        uint8_t type = H264_NALU_TYPE(nalu[0]);
+        if(type == H264_NALU_SPS){
+            has_sps = cache.update_sps(nalu.data(),nalu.size()) != nullptr || has_sps;
+        }else if(type == H264_NALU_PPS){
+            cache.update_pps(nalu.data(),nalu.size());
+        }
+    }
+    return has_sps;
+}
+
+bool sdp_media::update_params(h265_param_cache& cache) const{
+    bool has_sps = false;
+    for(const auto& nalu : parameter_sets){
+        if(nalu.empty()){
+            continue;
+        }
+        uint8_t type = H265_NALU_TYPE(nalu[0]);
+        if(type == H265_NALU_VPS){
+            cache.update_vps(nalu.data(),nalu.size());
+        }else if(type == H265_NALU_SPS){
+            has_sps = cache.update_sps(nalu.data(),nalu.size()) != nullptr || has_sps;
+        }else if(type == H265_NALU_PPS){
+            cache.update_pps(nalu.data(),nalu.size());
+        }
+    }
+    return has_sps;
+}
+
+/**
+ * a=rtpmap:<pt> <encoding>/<clock rate>[/<channels>]
+ */
+static void parse_rtpmap(sdp_media* media,const std::string& value){
+    size_t sp = value.find(' ');
+    if(sp == std::string::npos || atoi(value.c_str()) != media->payload_type){
+        return;
+    }
+    std::vector<std::string> parts = split(value.substr(sp + 1),'/');
+    if(parts.empty()){
+        return;
+    }
+    media->encoding = parts[0];
+    media->clock_rate = parts.size() > 1 ? atoi(parts[1].c_str()) : 0;
+    media->channels = parts.size() > 2 ? atoi(parts[2].c_str()) : 0;
+}
+
+/**
+ * a=fmtp:<pt> key=value;key=value
+ */
+static void parse_fmtp(sdp_media* media,const std::string& value){
+    size_t sp = value.find(' ');
+    if(sp == std::string::npos || atoi(value.c_str()) != media->payload_type){
+        return;
+    }
+    for(const auto& param : split(value.substr(sp + 1),';')){
+        // base64 value may end with '='
+        size_t equal = param.find('=');
+        if(equal == std::string::npos){
+            media->fmtp.push_back(std::make_pair(param,std::string()));
+        }else{
+            media->fmtp.push_back(std::make_pair(trim(param.substr(0,equal)),trim(param.substr(equal + 1))));
+        }
+    }
+}
+
+bool sdp_parse(const char* sdp,size_t size,sdp_session* session){
+    *session = sdp_session();
+    sdp_media* media = nullptr;
+    // lines of a malformed media section until next m=
+    bool skip_media = false;
+    const char* p = sdp;
+    const char* pend = sdp + size;
+    while(p < pend){
+        const char* lf = (const char*)memchr(p,'\n',pend - p);
+        const char* line_end = lf ? lf : pend;
+        std::string line(p,line_end);
+        p = line_end + 1;
+        if(!line.empty() && line.back() == '\r'){
+            line.pop_back();
+        }
+        if(line.size() < 2 || line[1] != '=' || (skip_media && line[0] != 'm')){
+            continue;
+        }
+        std::string value = line.substr(2);
+        switch(line[0]){
+            case 'o':
+                session->origin = value;
+                break;
+            case 's':
+                session->name = value;
+                break;
+            case 'c':
+                if(!media){
+                    session->connection = value;
+                }
+                break;
+            case 'm':{
+                // m=<media> <port>[/<count>] <proto> <fmt> ...
+                if(media){
+                    parse_codec_parameters(media);
+                }
+                std::vector<std::string> parts = split(value,' ');
+                skip_media = parts.size() < 3;
+                if(skip_media){
+                    media = nullptr;
+                    break;
+                }
+                session->medias.push_back(sdp_media());
+                media = &session->medias.back();
+                media->media = parts[0];
+                media->port = atoi(parts[1].c_str());
+                media->proto = parts[2];
+                for(size_t i = 3;i < parts.size();i++){
+                    media->formats.push_back(atoi(parts[i].c_str()));
+                }
+                media->payload_type = media->formats.empty() ? -1 : media->formats[0];
+                break;
+            }
+            case 'a':{
+                size_t colon = value.find(':');
+                std::string name = value.substr(0,colon);
+                std::string attribute = colon == std::string::npos ? std::string() : trim(value.substr(colon + 1));
+                if(!media){
+                    if(name == "control"){
+                        session->control = attribute;
+                    }else if(name == "range"){
+                        session->range = attribute;
+                    }else{
+                        session->attributes.push_back(std::make_pair(name,attribute));
+                    }
+                }else if(name == "rtpmap"){
+                    parse_rtpmap(media,attribute);
+                }else if(name == "fmtp"){
+                    parse_fmtp(media,attribute);
+                }else if(name == "control"){
+                    media->control = attribute;
+                }else{
+                    media->attributes.push_back(std::make_pair(name,attribute));
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    if(media){
+        parse_codec_parameters(media);
+    }
+    return !session->medias.empty();
+}
+
+std::string sdp_generate(const sdp_session& session){
+    std::string sdp;
+    sdp.reserve(512);
+    sdp += "v=0\r\n";
+    sdp += "o=" + session.origin + "\r\n";
+    sdp += "s=" + session.name + "\r\n";
+    if(!session.connection.empty()){
+        sdp += "c=" + session.connection + "\r\n";
+    }
+    sdp += "t=0 0\r\n";
+    if(!session.range.empty()){
+        sdp += "a=range:" + session.range + "\r\n";
+    }
+    if(!session.control.empty()){
+        sdp += "a=control:" + session.control + "\r\n";
+    }
+    for(const auto& attribute : session.attributes){
+        sdp += "a=" + attribute.first + (attribute.second.empty() ? "" : ":" + attribute.second) + "\r\n";
+    }
+    for(const auto& media : session.medias){
+        sdp += "m=" + media.media + " " + std::to_string(media.port) + " " + media.proto;
+        for(int format : media.formats){
+            sdp += " " + std::to_string(format);
+        }
+        sdp += "\r\n";
+        std::string pt = std::to_string(media.payload_type);
+        if(!media.encoding.empty()){
+            sdp += "a=rtpmap:" + pt + " " + media.encoding + "/" + std::to_string(media.clock_rate);
+            if(media.channels){
+                sdp += "/" + std::to_string(media.channels);
+            }
+            sdp += "\r\n";
+        }
+        if(!media.fmtp.empty()){
+            sdp += "a=fmtp:" + pt + " ";
+            for(size_t i = 0;i < media.fmtp.size();i++){
+                sdp += (i ? ";" : "") + media.fmtp[i].first;
+                if(!media.fmtp[i].second.empty()){
+                    sdp += "=" + media.fmtp[i].second;
+                }
+            }
+            sdp += "\r\n";
+        }
+        for(const auto& attribute : media.attributes){
+            sdp += "a=" + attribute.first + (attribute.second.empty() ? "" : ":" + attribute.second) + "\r\n";
+        }
+        if(!media.control.empty()){
+            sdp += "a=control:" + media.control + "\r\n";
+        }
+    }
+    return sdp;
+}
+
+void sdp_media_h26x(sdp_media* media,AVCodecID codec,int payload_type,
+    const std::vector<std::vector<uint8_t>>& parameter_sets){
+    media->media = "video";
+    media->proto = "RTP/AVP";
+    media->formats.assign(1,payload_type);
+    media->payload_type = payload_type;
+    media->codec = codec;
+    media->clock_rate = 90000;
+    media->channels = 0;
+    media->parameter_sets = parameter_sets;
+    media->fmtp.clear();
+    if(codec == AV_CODEC_VIDEO_H264){
+        media->encoding = "H264";
+        media->packetization_mode = 1;
+        media->fmtp.push_back(std::make_pair(std::string("packetization-mode"),std::string("1")));
+        for(const auto& nalu : parameter_sets){
+            if(nalu.size() >= 4 && H264_NALU_TYPE(nalu[0]) == H264_NALU_SPS){
+                // profile_idc,constraint flags,level_idc
+                media->fmtp.push_back(std::make_pair(std::string("profile-level-id"),to_hex(nalu.data() + 1,3)));
+                break;
+            }
+        }
+        std::string sprop = encode_parameter_sets(parameter_sets,codec,H264_NALU_SPS);
+        std::string pps = encode_parameter_sets(parameter_sets,codec,H264_NALU_PPS);
+        if(!pps.empty()){
+            sprop += (sprop.empty() ? "" : ",") + pps;
+        }
+        if(!sprop.empty()){
+            media->fmtp.push_back(std::make_pair(std::string("sprop-parameter-sets"),sprop));
+        }
+    }else{
+        media->encoding = "H265";
+        static const char* kSPROP[3] = {"sprop-vps","sprop-sps","sprop-pps"};
+        static const int kTYPE[3] = {H265_NALU_VPS,H265_NALU_SPS,H265_NALU_PPS};
+        for(int i = 0;i < 3;i++){
+            std::string sprop = encode_parameter_sets(parameter_sets,codec,kTYPE[i]);
+            if(!sprop.empty()){
+                media->fmtp.push_back(std::make_pair(std::string(kSPROP[i]),sprop));
+            }
+        }
+    }
+    parse_video_info(media);
+}
+
+void sdp_media_aac(sdp_media* media,int payload_type,const uint8_t* config,size_t size){
+    media->media = "audio";
+    media->proto = "RTP/AVP";
+    media->formats.assign(1,payload_type);
+    media->payload_type = payload_type;
+    media->encoding = "MPEG4-GENERIC";
+    media->codec = AV_CDEOC_AUDIO_AAC;
+    media->config.assign(config,config + size);
+    media->clock_rate = 0;
+    media->channels = 0;
+    parse_aac_config(media);
+    media->fmtp.clear();
+    static const char* kAAC_HBR[6][2] = {{"streamtype","5"},{"profile-level-id","1"},{"mode","AAC-hbr"},
+        {"sizelength","13"},{"indexlength","3"},{"indexdeltalength","3"}};
+    for(const auto& kv : kAAC_HBR){
+        media->fmtp.push_back(std::make_pair(std::string(kv[0]),std::string(kv[1])));
+    }
+    media->fmtp.push_back(std::make_pair(std::string("config"),to_hex(config,size)));
+}
+
+};//!namespace zav
@@ -32,6 +32,8 @@
 #include "zcf/zcf_buffer.hpp"
 #include "zcf/zcf_utility.hpp"
 #include "zcf/memory.hpp"
+#include "zcf/zcf_cpu.hpp"
+#include <string.h>
 #ifdef __x86_64__
 #include <immintrin.h>
 #elif __ARM_NEON
@@ -51,7 +53,8 @@ void cross_byte_u8_c(const uint8_t* buffer,size_t size)
     }
 };
 
-#ifdef __SSSE3__
+#ifdef __x86_64__
+Z_TARGET_ATTR("ssse3")
 static void cross_byte_u8_x86_sse(const uint8_t* buffer,size_t size)
 {
     constexpr static size_t CROSS_BYTE = 128 / 8;
@@ -107,8 +110,12 @@ static void cross_byte_u8_arm_neon(const uint8_t* buffer,size_t size){
 void cross_byte_u8(const uint8_t* buffer,size_t size)
 {
     Z_ASSERT(!(size & 0x01));
-    #ifdef __SSSE3__
-    cross_byte_u8_x86_sse(buffer,size);
+    #ifdef __x86_64__
+    if(cpu::has(cpu::CPU_FEATURE_SSSE3)){
+        cross_byte_u8_x86_sse(buffer,size);
+    }else{
+        cross_byte_u8_c(buffer,size);
+    }
     #elif __ARM_NEON
     cross_byte_u8_arm_neon(buffer,size);
     #else
@@ -122,8 +129,12 @@ void cross_byte_s16_c(const int16_t* bytes,size_t size)
 };
 void cross_byte_s16(const int16_t* bytes,size_t size)
 {
-    #ifdef __SSSE3__
-    cross_byte_u8_x86_sse((const uint8_t*)bytes,size * sizeof(int16_t));
+    #ifdef __x86_64__
+    if(cpu::has(cpu::CPU_FEATURE_SSSE3)){
+        cross_byte_u8_x86_sse((const uint8_t*)bytes,size * sizeof(int16_t));
+    }else{
+        cross_byte_u8_c((const uint8_t*)bytes,size * sizeof(int16_t));
+    }
     #elif __ARM_NEON
     cross_byte_u8_arm_neon((const uint8_t*)bytes,size * sizeof(int16_t));
     #else
@@ -131,4 +142,74 @@ void cross_byte_s16(const int16_t* bytes,size_t size)
     #endif
 }
 
+bit_buffer::bit_buffer(const uint8_t* data,size_t size)
+    :data_(data),size_(size),pos_(0),cache_(0),bits_(0),stop_bit_(SIZE_MAX){
+
+}
+
+uint64_t bit_buffer::load_tail() const{
+    uint8_t tail[8] = {0};
+    if(pos_ < size_){
+        ::memcpy(tail,data_ + pos_,size_ - pos_);
+    }
+    return Z_RBE64(tail);
+}
+
+uint32_t bit_buffer::read_ue_long(){
+    // code word longer than cache,read leading zeros then value
+    int leading = 0;
+    while(!read_bit()){
+        ++leading;
+        if(leading > 31 || overrun()){
+            // 32 leading zeros code 2^32 - 1 at least,invalid for 32 bits value
+            return UINT32_MAX;
+        }
+    }
+    uint64_t value = ((uint64_t)1 << leading) | read_bits64(leading);
+    return (uint32_t)(value - 1);
+}
+
+bool bit_buffer::more_rbsp_data() const{
+    if(stop_bit_ == SIZE_MAX){
+        // find rbsp_stop_one_bit,the last 1 bit of data,0 if there is none
+        size_t last = size_;
+        while(last > 0 && data_[last - 1] == 0x00){
+            --last;
+        }
+        stop_bit_ = last ? (last - 1) * 8 + (7 - __builtin_ctz(data_[last - 1])) : 0;
+    }
+    return bits_read() < stop_bit_;
+}
+
+bit_writer::bit_writer(uint8_t* buffer,size_t capacity)
+    :buffer_(buffer),capacity_(capacity),pos_(0),cache_(0),bits_(0),overflow_(false){
+
+}
+
+void bit_writer::flush_word(){
+    if(pos_ + 4 <= capacity_){
+        Z_WBE32(buffer_ + pos_,(uint32_t)(cache_ >> 32));
+    }else{
+        overflow_ = true;
+    }
+    pos_ += 4;
+    cache_ <<= 32;
+    bits_ -= 32;
+}
+
+size_t bit_writer::flush(){
+    while(bits_ > 0){
+        if(pos_ < capacity_){
+            buffer_[pos_] = (uint8_t)(cache_ >> 56);
+        }else{
+            overflow_ = true;
+        }
+        ++pos_;
+        cache_ <<= 8;
+        bits_ = bits_ > 8 ? bits_ - 8 : 0;
+    }
+    cache_ = 0;
+    return pos_ < capacity_ ? pos_ : capacity_;
+}
+
 };//!namespace zcf
\ No newline at end of file
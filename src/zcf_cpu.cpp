@@ -0,0 +1,140 @@
+/** 
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ * 
+ * LICENSE
+ * 
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief 
+ */
+#include "zcf/zcf_cpu.hpp"
+#include <string>
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+namespace zcf{
+
+namespace cpu{
+
+#if defined(__x86_64__)
+// XCR0 register,which register state the os saves on context switch
+static uint64_t read_xcr0(){
+    uint32_t eax,edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+}
+
+static uint32_t detect_features(){
+    uint32_t detected = CPU_FEATURE_NONE;
+    unsigned int eax,ebx,ecx,edx;
+    unsigned int max_leaf = __get_cpuid_max(0,nullptr);
+    if(max_leaf < 1){
+        return detected;
+    }
+
+    __cpuid(1,eax,ebx,ecx,edx);
+    if(edx & bit_SSE2){
+        detected |= CPU_FEATURE_SSE2;
+    }
+    if(ecx & bit_SSSE3){
+        detected |= CPU_FEATURE_SSSE3;
+    }
+    if(ecx & bit_SSE4_2){
+        detected |= CPU_FEATURE_SSE42;
+    }
+    // avx family need os support(xsave enabled and ymm/zmm state saved)
+    bool os_xsave = (ecx & bit_OSXSAVE) && (ecx & bit_AVX);
+    if(!os_xsave || max_leaf < 7){
+        return detected;
+    }
+    uint64_t xcr0 = read_xcr0();
+    // xmm(bit 1) ymm(bit 2)
+    bool os_avx = (xcr0 & 0x06) == 0x06;
+    // opmask(bit 5) zmm_hi256(bit 6) hi16_zmm(bit 7)
+    bool os_avx512 = os_avx && (xcr0 & 0xE0) == 0xE0;
+
+    __cpuid_count(7,0,eax,ebx,ecx,edx);
+    if(os_avx && (ebx & bit_AVX2)){
+        detected |= CPU_FEATURE_AVX2;
+    }
+    if(os_avx512 && (ebx & bit_AVX512F) && (ebx & bit_AVX512BW)){
+        detected |= CPU_FEATURE_AVX512BW;
+    }
+    return detected;
+}
+#elif defined(__aarch64__)
+static uint32_t detect_features(){
+    // advanced simd is mandatory on armv8-a
+    return CPU_FEATURE_NEON;
+}
+#else
+static uint32_t detect_features(){
+#ifdef __ARM_NEON
+    return CPU_FEATURE_NEON;
+#else
+    return CPU_FEATURE_NONE;
+#endif
+}
+#endif
+
+uint32_t features(){
+    // c++11 guarantee thread safe init
+    static const uint32_t detected = detect_features();
+    return detected;
+}
+
+const char* desc_features(){
+    static const std::string desc = [](){
+        static constexpr struct{
+            cpu_feature feature;
+            const char* name;
+        } kFeatureNames[] = {
+            {CPU_FEATURE_SSE2,"sse2"},
+            {CPU_FEATURE_SSSE3,"ssse3"},
+            {CPU_FEATURE_SSE42,"sse4.2"},
+            {CPU_FEATURE_AVX2,"avx2"},
+            {CPU_FEATURE_AVX512BW,"avx512bw"},
+            {CPU_FEATURE_NEON,"neon"},
+        };
+        std::string names;
+        for(const auto& item : kFeatureNames){
+            if(!has(item.feature)){
+                continue;
+            }
+            if(!names.empty()){
+                names.append(" ");
+            }
+            names.append(item.name);
+        }
+        return names.empty() ? std::string("none") : names;
+    }();
+    return desc.c_str();
+}
+
+};//!namespace cpu
+
+};//!namespace zcf
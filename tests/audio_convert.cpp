@@ -79,9 +79,8 @@ int main(int argc,char** argv){
         // convert to pcm
         // g711 uint8->pcm int16_t
         pcm_buffer = new int16_t[g711_size];
-        for(int i=0;i<g711_size;i++){
-            *(pcm_buffer+i)=zav::alaw2linear(*(g711_buffer+i));
-        }
+        zav::alaw_decode(g711_buffer,g711_size,pcm_buffer);
+        zlog("g711 decode kernel {}",zav::g711_kernel());
         FILE* wfile = fopen("g711_2_pcm.pcm","wb");
         fwrite(pcm_buffer,sizeof(int16_t),g711_size,wfile);
         fflush(wfile);
@@ -0,0 +1,275 @@
+#include <zlog/log.h>
+#include <zcf/zcf_flags.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "zav/codec/h26x.h"
+#include "zcf/zcf_cpu.hpp"
+#include "h26x_sample.hpp"
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * bench of annexb start code kernels on synthetic corpora,
+ * every kernel must find the same start codes as sbm
+ */
+typedef const uint8_t* (*find_start_t)(const uint8_t* bytes,size_t sizeBytes);
+
+struct kernel{
+    const char* name;
+    find_start_t find;
+};
+
+struct corpus{
+    std::string name;
+    std::vector<uint8_t> bytes;
+};
+
+struct bench_result{
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double cycles;
+};
+
+static uint64_t bench_cycles(){
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static corpus make_dense(size_t size,std::mt19937& rng){
+    corpus c{"dense small nalus",{}};
+    c.bytes.reserve(size + 1024);
+    while(c.bytes.size() < size){
+        h26x_sample::append_nalu(c.bytes,rng,0x41,20 + rng() % 200,(rng() & 0x01) != 0);
+    }
+    return c;
+}
+
+static corpus make_sparse(size_t size,std::mt19937& rng){
+    corpus c{"sparse huge idr",{}};
+    c.bytes.reserve(size + 4 * 1024 * 1024);
+    while(c.bytes.size() < size){
+        h26x_sample::append_nalu(c.bytes,rng,0x67,16,true);
+        h26x_sample::append_nalu(c.bytes,rng,0x68,4,true);
+        h26x_sample::append_nalu(c.bytes,rng,0x65,1024 * 1024 + rng() % (3 * 1024 * 1024),true);
+        for(int i = 0;i < 4;i++){
+            h26x_sample::append_nalu(c.bytes,rng,0x41,10 * 1024 + rng() % (50 * 1024),true);
+        }
+    }
+    return c;
+}
+
+static corpus make_zero_filler(size_t size,std::mt19937& rng){
+    corpus c{"long zero filler",{}};
+    c.bytes.reserve(size + 128 * 1024);
+    while(c.bytes.size() < size){
+        h26x_sample::append_nalu(c.bytes,rng,0x41,100 + rng() % 1000,true);
+        // trailing_zero_8bits
+        c.bytes.insert(c.bytes.end(),16 * 1024 + rng() % (64 * 1024),0x00);
+    }
+    return c;
+}
+
+static void find_all(find_start_t find,const std::vector<uint8_t>& bytes,std::vector<size_t>* offsets,size_t* count){
+    const uint8_t* p = bytes.data();
+    const uint8_t* pend = p + bytes.size();
+    size_t found_count = 0;
+    while(pend - p >= 3){
+        const uint8_t* found = find(p,pend - p);
+        if(!found){
+            break;
+        }
+        if(offsets){
+            offsets->push_back(found - bytes.data());
+        }
+        ++found_count;
+        p = found + 3;
+    }
+    *count = found_count;
+}
+
+template<typename Run>
+static bench_result bench(int warmup,int iterations,Run&& run){
+    for(int i = 0;i < warmup;i++){
+        run();
+    }
+    std::vector<double> times;
+    times.reserve(iterations);
+    uint64_t cycles = 0;
+    for(int i = 0;i < iterations;i++){
+        uint64_t c0 = bench_cycles();
+        auto start = std::chrono::high_resolution_clock::now();
+        run();
+        auto end = std::chrono::high_resolution_clock::now();
+        cycles += bench_cycles() - c0;
+        times.push_back(std::chrono::duration<double,std::milli>(end - start).count());
+    }
+    std::sort(times.begin(),times.end());
+    bench_result result;
+    result.p50_ms = times[times.size() * 50 / 100];
+    result.p90_ms = times[times.size() * 90 / 100];
+    result.p99_ms = times[std::min(times.size() - 1,times.size() * 99 / 100)];
+    result.cycles = (double)cycles / iterations;
+    return result;
+}
+
+static void report(const char* name,size_t bytes,size_t found,const bench_result& result){
+    double gbps = bytes / (result.p50_ms * 1e6);
+    zlog("  {:<12} found {:>8} {:>7.2f} GB/s {:>6.3f} cycles/B p50 {:.3f} ms p90 {:.3f} ms p99 {:.3f} ms",
+        name,found,gbps,result.cycles / bytes,result.p50_ms,result.p90_ms,result.p99_ms);
+}
+
+int main(int argc,char** argv){
+    zlog::logger::create_defaultLogger();
+
+    zcf::OptionParser option_parser("bench_h26x argument:");
+    auto option_help = option_parser.add<zcf::Switch>("h","help","print bench_h26x help");
+    auto option_file = option_parser.add<zcf::Value<std::string>>("i","input","extra input annexb file");
+    auto option_size = option_parser.add<zcf::Value<int>>("s","size","synthetic corpus size MB",64);
+    auto option_iterations = option_parser.add<zcf::Value<int>>("n","iterations","measured iterations",20);
+    auto option_warmup = option_parser.add<zcf::Value<int>>("w","warmup","warmup iterations",3);
+    auto option_slow = option_parser.add<zcf::Switch>("a","all","also bench slow memcmp/seq kernels");
+
+    option_parser.parse(argc,argv);
+    if(option_help->is_set()){
+        std::cout << option_parser << std::endl;
+        return 0;
+    }
+    size_t corpus_size = (size_t)option_size->value() * 1024 * 1024;
+    int iterations = std::max(1,option_iterations->value());
+    int warmup = std::max(0,option_warmup->value());
+    zlog("cpu features:{},annexb find kernel:{}",zcf::cpu::desc_features(),zav::h26x::annexb_find_start_kernel());
+
+    std::mt19937 rng(0x26);
+    std::vector<corpus> corpora;
+    corpora.push_back(make_dense(corpus_size,rng));
+    corpora.push_back(make_sparse(corpus_size,rng));
+    corpora.push_back(make_zero_filler(corpus_size,rng));
+    if(option_file->is_set()){
+        FILE* rfile = fopen(option_file->value().c_str(),"rb");
+        if(!rfile){
+            zlog_error("open {} failed",option_file->value());
+            return 1;
+        }
+        fseek(rfile,0,SEEK_END);
+        corpus c{option_file->value(),std::vector<uint8_t>((size_t)ftell(rfile))};
+        fseek(rfile,0,SEEK_SET);
+        size_t read_size = fread(c.bytes.data(),1,c.bytes.size(),rfile);
+        fclose(rfile);
+        if(read_size != c.bytes.size()){
+            zlog_error("read {} failed,{}/{} bytes",option_file->value(),read_size,c.bytes.size());
+            return 1;
+        }
+        corpora.push_back(std::move(c));
+    }
+
+    std::vector<kernel> kernels;
+    kernels.push_back({"sbm",zav::h26x::annexb_find_start_sbm});
+    kernels.push_back({"memmem",[](const uint8_t* b,size_t n)->const uint8_t*{ return zav::h26x::annexb_find_start_memmem(b,n); }});
+    kernels.push_back({"3byte",[](const uint8_t* b,size_t n)->const uint8_t*{ return zav::h26x::annexb_find_start_3byte(b,n); }});
+    if(option_slow->is_set()){
+        kernels.push_back({"memcmp",[](const uint8_t* b,size_t n)->const uint8_t*{ return zav::h26x::annexb_find_start_memcmp(b,n); }});
+        kernels.push_back({"seq",[](const uint8_t* b,size_t n)->const uint8_t*{ return zav::h26x::annexb_find_start_seq(b,n); }});
+    }
+#if defined(__x86_64__)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_SSE42)){
+        kernels.push_back({"sse42",[](const uint8_t* b,size_t n)->const uint8_t*{ return zav::h26x::annexb_find_start_sse42(b,n); }});
+    }
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_AVX2)){
+        kernels.push_back({"avx2",[](const uint8_t* b,size_t n)->const uint8_t*{ return zav::h26x::annexb_find_start_avx2(b,n); }});
+    }
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_AVX512BW)){
+        kernels.push_back({"avx512",[](const uint8_t* b,size_t n)->const uint8_t*{ return zav::h26x::annexb_find_start_avx512(b,n); }});
+    }
+#endif
+#ifdef __ARM_NEON
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_NEON)){
+        kernels.push_back({"neon",[](const uint8_t* b,size_t n)->const uint8_t*{ return zav::h26x::annexb_find_start_neon(b,n); }});
+    }
+#endif
+    kernels.push_back({"dispatch",zav::h26x::annexb_find_start});
+
+    int mismatch = 0;
+    for(const auto& c : corpora){
+        const std::vector<uint8_t>& bytes = c.bytes;
+        zlog("{} {} bytes",c.name,bytes.size());
+
+        // cross check offsets with sbm
+        std::vector<size_t> reference;
+        size_t reference_count = 0;
+        find_all(kernels[0].find,bytes,&reference,&reference_count);
+        for(const auto& k : kernels){
+            std::vector<size_t> offsets;
+            size_t count = 0;
+            find_all(k.find,bytes,&offsets,&count);
+            if(offsets != reference){
+                zlog_error("  {} mismatch:found {} expect {}",k.name,count,reference_count);
+                ++mismatch;
+            }
+        }
+
+        for(const auto& k : kernels){
+            size_t count = 0;
+            bench_result result = bench(warmup,iterations,[&](){
+                find_all(k.find,bytes,nullptr,&count);
+            });
+            report(k.name,bytes.size(),count,result);
+        }
+
+        // one pass index and all cores
+        std::vector<zav::h26x_nalu> nalus;
+        size_t index_count = 0;
+        bench_result result = bench(warmup,iterations,[&](){
+            index_count = zav::h26x::annexb_index_nalus(bytes.data(),bytes.size(),nalus);
+        });
+        report("index",bytes.size(),index_count,result);
+        std::vector<zav::h26x_nalu> parallel_nalus;
+        size_t parallel_count = 0;
+        result = bench(warmup,iterations,[&](){
+            parallel_count = zav::h26x::parallel_annexb_index(bytes.data(),bytes.size(),parallel_nalus);
+        });
+        report("parallel",bytes.size(),parallel_count,result);
+        mismatch += h26x_sample::diff_nalus("  parallel index",bytes.data(),nalus,parallel_nalus) ? 1 : 0;
+
+        // streaming,fixed size chunks as rtp/tcp input
+        static const size_t chunk_sizes[2] = {1400,64 * 1024};
+        for(size_t chunk_size : chunk_sizes){
+            size_t split_count = 0;
+            zav::h26x::annexb_stream_splitter splitter([&split_count](const zav::h26x_nalu& nalu){
+                ++split_count;
+            });
+            result = bench(warmup,iterations,[&](){
+                split_count = 0;
+                for(size_t offset = 0;offset < bytes.size();offset += chunk_size){
+                    splitter.push(bytes.data() + offset,std::min(chunk_size,bytes.size() - offset));
+                }
+                splitter.flush();
+            });
+            std::string name = "split " + std::to_string(chunk_size);
+            report(name.c_str(),bytes.size(),split_count,result);
+
+            // not timed,every nalu against the index
+            name = "  " + name;
+            h26x_sample::splitter_check check(name.c_str(),bytes.data(),bytes.size(),nalus);
+            zav::h26x::annexb_stream_splitter check_splitter([&check](const zav::h26x_nalu& nalu){
+                check.check(nalu);
+            });
+            for(size_t offset = 0;offset < bytes.size();offset += chunk_size){
+                check_splitter.push(bytes.data() + offset,std::min(chunk_size,bytes.size() - offset));
+            }
+            check_splitter.flush();
+            mismatch += check.finish() ? 1 : 0;
+        }
+    }
+    if(mismatch){
+        zlog_error("{} kernel results mismatch",mismatch);
+        return 1;
+    }
+    return 0;
+}
@@ -2,7 +2,9 @@
 #include <zcf/zcf_flags.hpp>
 #include <chrono>
 #include <iostream>
+#include <random>
 #include "zav/codec/h26x.h"
+#include "h26x_sample.hpp"
 
 int main(int argc,char** argv){
     zlog::logger::create_defaultLogger();
@@ -16,20 +18,31 @@ int main(int argc,char** argv){
         std::cout << option_parser << std::endl;
         return 0;
     }
-    if(!option_file->is_set()){
-        zlog("bench_h26x has no input file");
-        return 0;
+    std::vector<uint8_t> bytes;
+    if(option_file->is_set()){
+        std::string h26x_file = option_file->value();
+        FILE* rfile = fopen(h26x_file.c_str(), "rb");
+        if(!rfile){
+            zlog_error("open {} failed",h26x_file);
+            return 1;
+        }
+        fseek(rfile, 0, SEEK_END);
+        bytes.resize(ftell(rfile));
+        fseek(rfile, 0, SEEK_SET);
+        size_t read_size = fread(bytes.data(),1,bytes.size(),rfile);
+        fclose(rfile);
+        if(read_size != bytes.size()){
+            zlog_error("read {} failed,{}/{} bytes",h26x_file,read_size,bytes.size());
+            return 1;
+        }
+        zlog("{} size {}",h26x_file,bytes.size());
+    }else{
+        std::mt19937 rng(0x11);
+        bytes = h26x_sample::make_stream(1024 * 1024,rng);
+        zlog("generated annexb size {}",bytes.size());
     }
-    std::string h26x_file = option_file->value();
-    FILE* rfile = fopen(h26x_file.c_str(), "rb");
-    Z_ASSERT(rfile);
-    fseek(rfile, 0, SEEK_END);
-    size_t h26x_size = ftell(rfile);
-    fseek(rfile, 0, SEEK_SET);
-    zlog("{} size {}",h26x_file,h26x_size);
-    uint8_t* rbufer = new uint8_t[h26x_size];
-    fread(rbufer,1,h26x_size,rfile);
-    fclose(rfile);
+    const uint8_t* rbufer = bytes.data();
+    size_t h26x_size = bytes.size();
     // 5634个
     int bench_times = 1000;
     // bench memmem
@@ -140,6 +153,40 @@ int main(int argc,char** argv){
     }
     end = std::chrono::high_resolution_clock::now();
     zlog("sbm {} times:found {},cost:{} ms",bench_times,start_count,std::chrono::duration_cast<std::chrono::milliseconds>(end -start).count());
-    delete[] rbufer;
+
+    // one pass index vs all cores
+    std::vector<zav::h26x_nalu> nalus;
+    std::vector<zav::h26x_nalu> parallel_nalus;
+    size_t index_count = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(int i = 0 ;i < bench_times ;i++){
+        index_count += zav::h26x::annexb_index_nalus(rbufer,h26x_size,nalus);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    zlog("index {} times:found {},cost:{} ms",bench_times,index_count,std::chrono::duration_cast<std::chrono::milliseconds>(end -start).count());
+    index_count = 0;
+
+    start = std::chrono::high_resolution_clock::now();
+    for(int i = 0 ;i < bench_times ;i++){
+        index_count += zav::h26x::parallel_annexb_index(rbufer,h26x_size,parallel_nalus);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    zlog("parallel index {} times:found {},cost:{} ms",bench_times,index_count,std::chrono::duration_cast<std::chrono::milliseconds>(end -start).count());
+    // every thread count must index the same nalus,
+    // a big generated stream so that each thread gets a chunk(H26X_PARALLEL_MIN_CHUNK)
+    size_t mismatch = h26x_sample::diff_nalus("parallel",rbufer,nalus,parallel_nalus);
+    std::mt19937 rng(0x1111);
+    std::vector<uint8_t> big = h26x_sample::make_stream(40 * 1024 * 1024,rng);
+    zav::h26x::annexb_index_nalus(big.data(),big.size(),nalus);
+    static const size_t thread_counts[5] = {1,2,3,7,10};
+    for(size_t threads : thread_counts){
+        zav::h26x::parallel_annexb_index(big.data(),big.size(),parallel_nalus,threads);
+        std::string name = "parallel " + std::to_string(threads);
+        mismatch += h26x_sample::diff_nalus(name.c_str(),big.data(),nalus,parallel_nalus);
+    }
+    if(mismatch){
+        zlog_error("{} nalus mismatch",mismatch);
+        return 1;
+    }
     return 0;
 }
\ No newline at end of file
@@ -16,6 +16,36 @@ int main(int argc,char** argv){
         std::cout << option_parser << std::endl;
         return 0;
     }
+    // all int16 samples,span encode must be bitexact with sample function
+    {
+        int16_t* pcm = new int16_t[65536];
+        uint8_t* alaw = new uint8_t[65536];
+        uint8_t* ulaw = new uint8_t[65536];
+        for(int i=0;i<65536;i++){
+            pcm[i] = (int16_t)(i - 32768);
+        }
+        zav::alaw_encode(pcm,65536,alaw);
+        zav::ulaw_encode(pcm,65536,ulaw);
+        for(int i=0;i<65536;i++){
+            Z_ASSERT(alaw[i] == zav::linear2alaw(pcm[i]));
+            Z_ASSERT(ulaw[i] == zav::linear2ulaw(pcm[i]));
+        }
+        // in place transcode of all codes,twice(for simd and tail)
+        for(int i=0;i<65536;i++){
+            alaw[i] = (uint8_t)i;
+            ulaw[i] = (uint8_t)i;
+        }
+        zav::alaw_to_ulaw(alaw,65536 - 7);
+        zav::ulaw_to_alaw(ulaw,65536 - 7);
+        for(int i=0;i<65536 - 7;i++){
+            Z_ASSERT(alaw[i] == zav::alaw2ulaw((uint8_t)i));
+            Z_ASSERT(ulaw[i] == zav::ulaw2alaw((uint8_t)i));
+        }
+        zlog("g711 encode kernel {} checked",zav::g711_kernel());
+        delete[] ulaw;
+        delete[] alaw;
+        delete[] pcm;
+    }
     if(!option_file->is_set()){
         zlog("g711 convert has no input file");
         return 0;
@@ -35,9 +65,18 @@ int main(int argc,char** argv){
     // convert to pcm
     // g711 uint8->pcm int16_t
     int16_t* pcm_buffer = new int16_t[g711_size];
-    for(int i=0;i<g711_size;i++){
-        *(pcm_buffer+i)=zav::alaw2linear(*(g711_buffer+i));
+    if(input_codec == AV_CODEC_AUDIO_G711_ALAW){
+        zav::alaw_decode(g711_buffer,g711_size,pcm_buffer);
+    }else{
+        zav::ulaw_decode(g711_buffer,g711_size,pcm_buffer);
+    }
+    // span kernel must be bitexact with sample function
+    for(size_t i=0;i<g711_size;i++){
+        int16_t sample = input_codec == AV_CODEC_AUDIO_G711_ALAW ? 
+            zav::alaw2linear(g711_buffer[i]) : zav::ulaw2linear(g711_buffer[i]);
+        Z_ASSERT(pcm_buffer[i] == sample);
     }
+    zlog("g711 decode kernel {}",zav::g711_kernel());
     FILE* wfile = fopen("g711_pcm.dat","wb");
     fwrite(pcm_buffer,sizeof(int16_t),g711_size,wfile);
     fflush(wfile);
@@ -2,29 +2,106 @@
 
 #include <zlog/log.h>
 #include "zcf/zcf_flags.hpp"
+#include <algorithm>
 #include <iostream>
+#include <math.h>
+#include <random>
+#include <string.h>
+#include <vector>
 
-int main(int argc,char** argv){
-    const static std::string pcm_file = "pcm.dat";
-    zlog::logger::create_defaultLogger();
+/**
+ * G722BatchEncoder/G722BatchDecoder bitexact with one G722Encoder/G722Decoder
+ * per channel,on generated signals of every bitrate and option,
+ * -i decode a 240 bytes per frame g722 file to pcm.dat too
+ */
+static int check_batch(size_t channels,zav::G722BitRateMode bitrate,zav::G722SampleOption option,std::mt19937& rng){
+    std::vector<zav::G722Encoder*> encoders;
+    std::vector<zav::G722Decoder*> decoders;
+    for(size_t c = 0;c < channels;c++){
+        encoders.push_back(new zav::G722Encoder(bitrate,option));
+        decoders.push_back(new zav::G722Decoder(bitrate,option));
+    }
+    zav::G722BatchEncoder batch_encoder(channels,bitrate,option);
+    zav::G722BatchDecoder batch_decoder(channels,bitrate,option);
 
-    zcf::OptionParser option_parser("g722 convert argument:");
-    auto option_help = option_parser.add<zcf::Switch>("h","help","print g722 help");
-    auto option_file = option_parser.add<zcf::Value<std::string>>("i","input","input ");
+    int errors = 0;
+    // 20ms frames,odd and tiny lengths,a long one
+    static const size_t lengths[8] = {320,160,2,6,322,640,4,1000};
+    size_t t = 0;
+    for(size_t length : lengths){
+        // 16k input is encoded in sample pairs
+        size_t samples = (option & zav::G722_SAMPLE_RATE_8000) ? length : length & ~(size_t)1;
+        std::vector<std::vector<int16_t>> pcm(channels,std::vector<int16_t>(samples));
+        for(size_t c = 0;c < channels;c++){
+            // tone of each channel + noise + clipping spikes
+            for(size_t i = 0;i < samples;i++){
+                int32_t x = (int32_t)(12000 * sin((t + i) * 0.05 * (c + 1))) + (int32_t)(rng() % 8000) - 4000;
+                if(rng() % 97 == 0){
+                    x += (rng() & 0x01) ? 30000 : -30000;
+                }
+                pcm[c][i] = (int16_t)std::max(-32768,std::min(32767,x));
+            }
+        }
+        t += samples;
 
-    option_parser.parse(argc,argv);
-    if(option_help->is_set()){
-        std::cout << option_parser << std::endl;
-        return 0;
+        std::vector<std::vector<uint8_t>> codes(channels,std::vector<uint8_t>(samples + 8));
+        std::vector<std::vector<uint8_t>> batch_codes(channels,std::vector<uint8_t>(samples + 8));
+        std::vector<const int16_t*> batch_pcm_in;
+        std::vector<uint8_t*> batch_codes_out;
+        size_t bytes = 0;
+        for(size_t c = 0;c < channels;c++){
+            bytes = encoders[c]->Encode(pcm[c].data(),samples,codes[c].data());
+            batch_pcm_in.push_back(pcm[c].data());
+            batch_codes_out.push_back(batch_codes[c].data());
+        }
+        size_t batch_bytes = batch_encoder.Encode(batch_pcm_in.data(),samples,batch_codes_out.data());
+        for(size_t c = 0;c < channels;c++){
+            if(batch_bytes != bytes || memcmp(batch_codes[c].data(),codes[c].data(),bytes) != 0){
+                zlog_error("encode {} channels bitrate {} option {} length {}:channel {} mismatch,{} bytes,expect {}",
+                    channels,(int)bitrate,(int)option,samples,c,batch_bytes,bytes);
+                ++errors;
+                break;
+            }
+        }
+
+        std::vector<std::vector<int16_t>> decoded(channels,std::vector<int16_t>(samples * 2 + 32));
+        std::vector<std::vector<int16_t>> batch_decoded(channels,std::vector<int16_t>(samples * 2 + 32));
+        std::vector<const uint8_t*> batch_codes_in;
+        std::vector<int16_t*> batch_pcm_out;
+        size_t decoded_samples = 0;
+        for(size_t c = 0;c < channels;c++){
+            decoded_samples = decoders[c]->Decode(codes[c].data(),bytes,decoded[c].data());
+            batch_codes_in.push_back(codes[c].data());
+            batch_pcm_out.push_back(batch_decoded[c].data());
+        }
+        size_t batch_samples = batch_decoder.Decode(batch_codes_in.data(),bytes,batch_pcm_out.data());
+        for(size_t c = 0;c < channels;c++){
+            if(batch_samples != decoded_samples
+                || memcmp(batch_decoded[c].data(),decoded[c].data(),decoded_samples * sizeof(int16_t)) != 0){
+                zlog_error("decode {} channels bitrate {} option {} length {}:channel {} mismatch,{} samples,expect {}",
+                    channels,(int)bitrate,(int)option,bytes,c,batch_samples,decoded_samples);
+                ++errors;
+                break;
+            }
+        }
     }
-    if(!option_file->is_set()){
-        zlog("g7221 convert has no input file");
-        return 0;
+    for(size_t c = 0;c < channels;c++){
+        delete encoders[c];
+        delete decoders[c];
     }
-    std::string g722_file = option_file->value();
+    return errors;
+}
 
+/**
+ * batch decoder with all channels on the same stream,must be same as single one
+ */
+static int decode_file(const std::string& g722_file){
+    const static std::string pcm_file = "pcm.dat";
     FILE* rfile = fopen(g722_file.c_str(), "rb");
-    Z_ASSERT(rfile);
+    if(!rfile){
+        zlog_error("open {} failed",g722_file);
+        return 1;
+    }
     fseek(rfile, 0, SEEK_END);
     size_t g722_size = ftell(rfile);
     fseek(rfile, 0, SEEK_SET);
@@ -32,22 +109,88 @@ int main(int argc,char** argv){
 
     // 测试数据文件是240字节一个frame
     size_t g722_frame_count = g722_size / 240;
-    Z_ASSERT(g722_size % 240 == 0);
+    if(g722_size % 240){
+        zlog_warn("{} is not 240 bytes frames,{} bytes left",g722_file,g722_size % 240);
+    }
     zlog("{} has {} fram for 240 bytes per frame",g722_file,g722_frame_count);
-    zav::G722Decoder* decoder = new zav::G722Decoder(zav::g722_64000_bps,zav::G722_PACKED);
     FILE* wfile = fopen(pcm_file.c_str(),"wb");
-    Z_ASSERT(wfile);
+    if(!wfile){
+        zlog_error("open {} failed",pcm_file);
+        fclose(rfile);
+        return 1;
+    }
+    zav::G722Decoder decoder(zav::g722_64000_bps,zav::G722_PACKED);
+    const static size_t batch_channels = 13;
+    zav::G722BatchDecoder batch_decoder(batch_channels,zav::g722_64000_bps,zav::G722_PACKED);
+    std::vector<uint8_t> g722_buffer(240);
+    std::vector<int16_t> pcm_buffer(4096);
+    std::vector<int16_t> batch_buffer(batch_channels * 4096);
+    const uint8_t* batch_in[batch_channels];
+    int16_t* batch_out[batch_channels];
+    for(size_t c=0;c<batch_channels;c++){
+        batch_in[c] = g722_buffer.data();
+        batch_out[c] = batch_buffer.data() + c * 4096;
+    }
+    int errors = 0;
+    for(size_t i=0;i<g722_frame_count;i++){
+        if(fread(g722_buffer.data(),1,240,rfile) != 240){
+            zlog_error("{} read frame {} failed",g722_file,i);
+            ++errors;
+            break;
+        }
+        size_t decoded_pcm = decoder.Decode(g722_buffer.data(),240,pcm_buffer.data());
+        fwrite(pcm_buffer.data(),sizeof(int16_t),decoded_pcm,wfile);
 
-    uint8_t* g722_buffer = new uint8_t[240];
-    int16_t* pcm_buffer = new int16_t[4096];
-    for(int i=0;i<g722_frame_count;i++){
-        fread(g722_buffer,1,240,rfile);
-        size_t decoded_pcm = decoder->Decode(g722_buffer,240,pcm_buffer);
-        zlog("{} frame {} decoded {} pcm",g722_file,i,decoded_pcm);
-        fwrite(pcm_buffer,sizeof(int16_t),decoded_pcm,wfile);
+        size_t batch_pcm = batch_decoder.Decode(batch_in,240,batch_out);
+        for(size_t c=0;c<batch_channels;c++){
+            if(batch_pcm != decoded_pcm || memcmp(batch_out[c],pcm_buffer.data(),decoded_pcm * sizeof(int16_t)) != 0){
+                zlog_error("{} frame {} batch channel {} mismatch",g722_file,i,c);
+                ++errors;
+                break;
+            }
+        }
     }
-    delete decoder;
     fflush(wfile);
     fclose(wfile);
     fclose(rfile);
-}
\ No newline at end of file
+    return errors;
+}
+
+int main(int argc,char** argv){
+    zlog::logger::create_defaultLogger();
+
+    zcf::OptionParser option_parser("g722 convert argument:");
+    auto option_help = option_parser.add<zcf::Switch>("h","help","print g722 help");
+    auto option_file = option_parser.add<zcf::Value<std::string>>("i","input","input ");
+
+    option_parser.parse(argc,argv);
+    if(option_help->is_set()){
+        std::cout << option_parser << std::endl;
+        return 0;
+    }
+
+    zlog("g722 batch kernel {}",zav::g722_batch_kernel());
+    int errors = 0;
+    std::mt19937 rng(0x23);
+    // one lane,partial and full simd groups,a tail group
+    static const size_t channels[5] = {1,3,8,13,17};
+    static const zav::G722BitRateMode bitrates[3] = {zav::g722_64000_bps,zav::g722_56000_bps,zav::g722_48000_bps};
+    static const int options[4] = {0,zav::G722_PACKED,zav::G722_SAMPLE_RATE_8000,zav::G722_PACKED | zav::G722_SAMPLE_RATE_8000};
+    for(size_t c : channels){
+        for(zav::G722BitRateMode bitrate : bitrates){
+            for(int option : options){
+                errors += check_batch(c,bitrate,(zav::G722SampleOption)option,rng);
+            }
+        }
+    }
+    zlog("g722 batch codec checked,{} errors",errors);
+
+    if(option_file->is_set()){
+        errors += decode_file(option_file->value());
+    }
+    if(errors){
+        zlog_error("{} g722 errors",errors);
+        return 1;
+    }
+    return 0;
+}
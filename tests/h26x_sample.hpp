@@ -0,0 +1,192 @@
+/**
+ * @copyright Copyright © 2020-2024 code by zhaoj
+ *
+ * LICENSE
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+ /**
+ * @author zhaoj 286897655@qq.com
+ * @brief generated annexb input and nalu cross checks shared by h26x tests
+ */
+#ifndef ZAV_TESTS_H26X_SAMPLE_HPP_
+#define ZAV_TESTS_H26X_SAMPLE_HPP_
+
+#include <zlog/log.h>
+#include <string.h>
+#include <random>
+#include <vector>
+#include "zav/codec/h26x.h"
+
+namespace h26x_sample{
+
+/**
+ * escape rbsp as real ebsp after a start code
+ */
+inline void append_rbsp(std::vector<uint8_t>& out,const std::vector<uint8_t>& rbsp,bool long_prefix){
+    static const uint8_t prefix[4] = {0x00,0x00,0x00,0x01};
+    out.insert(out.end(),long_prefix ? prefix : prefix + 1,prefix + 4);
+    size_t offset = out.size();
+    out.resize(offset + zav::h26x::rbsp_to_ebsp_max_size(rbsp.size()));
+    size_t size = zav::h26x::rbsp_to_ebsp(rbsp.data(),rbsp.size(),out.data() + offset);
+    out.resize(offset + size);
+}
+
+/**
+ * random payload bytes,zero heavy like cabac/cavlc data
+ */
+inline void append_payload(std::vector<uint8_t>& rbsp,std::mt19937& rng,size_t payload_size){
+    for(size_t i = 0;i < payload_size;i++){
+        uint32_t r = rng();
+        rbsp.push_back((r & 0x300) ? (uint8_t)r : 0x00);
+    }
+    rbsp.push_back(0x80);
+}
+
+/**
+ * nalu of random payload,escaped as real ebsp
+ */
+inline void append_nalu(std::vector<uint8_t>& out,std::mt19937& rng,uint8_t header,size_t payload_size,bool long_prefix){
+    std::vector<uint8_t> rbsp(1,header);
+    append_payload(rbsp,rng,payload_size);
+    append_rbsp(out,rbsp,long_prefix);
+}
+
+/**
+ * slice nalu of header bytes(1 of h264,2 of h265),first slice header byte
+ * (first_mb_in_slice/first_slice_segment_in_pic_flag and slice_type) and random payload
+ */
+inline void append_slice(std::vector<uint8_t>& out,std::mt19937& rng,const std::vector<uint8_t>& header,uint8_t slice_head,size_t payload_size){
+    std::vector<uint8_t> rbsp = header;
+    rbsp.push_back(slice_head);
+    append_payload(rbsp,rng,payload_size);
+    append_rbsp(out,rbsp,true);
+}
+
+/**
+ * h264 like stream of at least size bytes:sps/pps/idr groups and p slices,
+ * mixed 3/4 bytes start codes,some trailing_zero_8bits and tiny nalus
+ */
+inline std::vector<uint8_t> make_stream(size_t size,std::mt19937& rng){
+    std::vector<uint8_t> out;
+    out.reserve(size + 64 * 1024);
+    while(out.size() < size){
+        append_nalu(out,rng,0x67,16,true);
+        append_nalu(out,rng,0x68,4,true);
+        append_nalu(out,rng,0x65,4 * 1024 + rng() % (32 * 1024),true);
+        int slices = 1 + rng() % 8;
+        for(int i = 0;i < slices;i++){
+            append_nalu(out,rng,0x41,rng() % 2048,(rng() & 0x01) != 0);
+            if((rng() & 0x0f) == 0){
+                out.insert(out.end(),1 + rng() % 8,0x00);
+            }
+        }
+    }
+    return out;
+}
+
+/**
+ * nalus indexed from the same bytes must be the same views,
+ * return mismatch count,the first one is logged
+ */
+inline size_t diff_nalus(const char* name,const uint8_t* bytes,const std::vector<zav::h26x_nalu>& expect,const std::vector<zav::h26x_nalu>& nalus){
+    size_t mismatch = expect.size() > nalus.size() ? expect.size() - nalus.size() : nalus.size() - expect.size();
+    size_t count = std::min(expect.size(),nalus.size());
+    for(size_t i = 0;i < count;i++){
+        const zav::h26x_nalu& e = expect[i];
+        const zav::h26x_nalu& n = nalus[i];
+        if(e.start == n.start && e.end == n.end && e.prefix == n.prefix && e.header == n.header){
+            continue;
+        }
+        if(!mismatch){
+            zlog_error("{} nalu {} mismatch:offset {} size {} expect offset {} size {}",name,i,
+                n.start - bytes,zav::h26x::nalu_size(n),e.start - bytes,zav::h26x::nalu_size(e));
+        }
+        ++mismatch;
+    }
+    if(expect.size() != nalus.size()){
+        zlog_error("{} found {} nalus,expect {}",name,nalus.size(),expect.size());
+    }
+    return mismatch;
+}
+
+/**
+ * check nalus of annexb_stream_splitter against annexb_index_nalus of the whole bytes,
+ * a view inside the pushed bytes must be the same offset,
+ * a view gathered across chunks must be the same bytes
+ */
+class splitter_check{
+public:
+    splitter_check(const char* name,const uint8_t* bytes,size_t size,const std::vector<zav::h26x_nalu>& expect)
+        :name_(name),bytes_(bytes),size_(size),expect_(expect){}
+
+    void check(const zav::h26x_nalu& nalu){
+        size_t i = count_++;
+        if(i >= expect_.size()){
+            fail(i,nalu);
+            return;
+        }
+        const zav::h26x_nalu& e = expect_[i];
+        bool same = nalu.prefix == e.prefix && nalu.header == e.header && nalu.end - nalu.start == e.end - e.start;
+        if(same && nalu.start >= bytes_ && nalu.start < bytes_ + size_){
+            same = nalu.start == e.start;
+        }else if(same){
+            same = ::memcmp(nalu.start,e.start,e.end - e.start + 1) == 0;
+        }
+        if(!same){
+            fail(i,nalu);
+        }
+    }
+
+    /**
+     * call after flush,return mismatch count
+    */
+    size_t finish(){
+        if(count_ != expect_.size()){
+            zlog_error("{} found {} nalus,expect {}",name_,count_,expect_.size());
+            ++mismatch_;
+        }
+        size_t mismatch = mismatch_;
+        count_ = 0;
+        mismatch_ = 0;
+        return mismatch;
+    }
+private:
+    void fail(size_t i,const zav::h26x_nalu& nalu){
+        if(!mismatch_){
+            zlog_error("{} nalu {} mismatch:size {} prefix {}",name_,i,zav::h26x::nalu_size(nalu),(int)nalu.prefix);
+        }
+        ++mismatch_;
+    }
+private:
+    const char* name_;
+    const uint8_t* bytes_;
+    size_t size_;
+    const std::vector<zav::h26x_nalu>& expect_;
+    size_t count_ = 0;
+    size_t mismatch_ = 0;
+};
+
+};//!namespace h26x_sample
+
+#endif//!ZAV_TESTS_H26X_SAMPLE_HPP_
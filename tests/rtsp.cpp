@@ -0,0 +1,156 @@
+#include <zlog/log.h>
+#include <zcf/zcf_flags.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "zav/proto/rtsp.h"
+
+using namespace zav;
+
+/**
+ * rtsp framing:messages and interleaved frames written by rtsp_writer,
+ * parsed again from random partial reads
+ */
+int main(int argc,char** argv){
+    zlog::logger::create_defaultLogger();
+    zcf::OptionParser option_parser("rtsp argument:");
+    auto option_help = option_parser.add<zcf::Switch>("h","help","print rtsp help");
+    auto option_rounds = option_parser.add<zcf::Value<int>>("n","rounds","random read rounds",200);
+
+    option_parser.parse(argc,argv);
+    if(option_help->is_set()){
+        std::cout << option_parser << std::endl;
+        return 0;
+    }
+
+    std::vector<uint8_t> stream(4096);
+    char* text = (char*)stream.data();
+    size_t size = rtsp_writer(text,1024).request_line(RTSP_METHOD_SETUP,"rtsp://127.0.0.1/live/trackID=0")
+        .header_int("CSeq",3)
+        .header("Transport","RTP/AVP/TCP;unicast;interleaved=0-1")
+        .end();
+    static const char sdp[] = "v=0\r\no=- 0 0 IN IP4 127.0.0.1\r\ns=live\r\n";
+    size += rtsp_writer(text + size,1024).status_line(200)
+        .header_int("CSeq",2)
+        .header("Session","12345678;timeout=60")
+        .end(sdp,sizeof(sdp) - 1);
+    size += rtsp_write_interleaved_header(stream.data() + size,1,100);
+    size += 100;
+    // keepalive then GET_PARAMETER
+    memcpy(text + size,"\r\n",2);
+    size += 2;
+    size += rtsp_writer(text + size,1024).request_line(RTSP_METHOD_GET_PARAMETER,"*").header_int("CSeq",4).end();
+    stream.resize(size);
+    int errors = 0;
+    char small[8];
+    if(rtsp_writer(small,sizeof(small)).request_line(RTSP_METHOD_PLAY,"*").end() != 0){
+        zlog_error("rtsp_writer over capacity not 0");
+        ++errors;
+    }
+
+    std::mt19937 rng(2326);
+    for(int round = 0;round < option_rounds->value();round++){
+        rtsp_parser parser;
+        std::vector<uint8_t> buffer;
+        size_t read = 0;
+        int index = 0;
+        while(read < stream.size() || !buffer.empty()){
+            size_t chunk = std::min<size_t>(stream.size() - read,1 + rng() % 64);
+            buffer.insert(buffer.end(),stream.begin() + read,stream.begin() + read + chunk);
+            read += chunk;
+            size_t consumed = 0;
+            RTSP_PARSE_RESULT result;
+            do{
+                result = parser.parse(buffer.data(),buffer.size(),&consumed);
+                const rtsp_message& message = parser.message();
+                if(result == RTSP_PARSE_MESSAGE){
+                    rtsp_transport_spec spec;
+                    switch(index){
+                        case 0:
+                            errors += !(message.method == RTSP_METHOD_SETUP && message.cseq == 3
+                                && rtsp_parse_transport(message.transport,&spec) && spec.transport == RTSP_TRANSPORT_TCP
+                                && spec.interleaved[0] == 0 && spec.interleaved[1] == 1);
+                            break;
+                        case 1:
+                            errors += !(message.response && message.status == 200 && message.cseq == 2
+                                && message.session.equal("12345678") && message.body.size == sizeof(sdp) - 1
+                                && message.header("session") != nullptr);
+                            break;
+                        case 3:
+                            errors += !(message.method == RTSP_METHOD_GET_PARAMETER && message.uri.equal("*") && message.cseq == 4);
+                            break;
+                        default:
+                            ++errors;
+                            break;
+                    }
+                    ++index;
+                }else if(result == RTSP_PARSE_INTERLEAVED){
+                    errors += !(index == 2 && parser.interleaved().channel == 1 && parser.interleaved().size == 100);
+                    ++index;
+                }else if(result == RTSP_PARSE_ERROR){
+                    ++errors;
+                    buffer.clear();
+                }
+                // buffer is compacted here,parser resume on the moved bytes
+                buffer.erase(buffer.begin(),buffer.begin() + consumed);
+            }while(consumed && !buffer.empty());
+            if(read == stream.size() && result == RTSP_PARSE_NEED_MORE && !consumed){
+                break;
+            }
+        }
+        if(index != 4){
+            zlog_error("round {} parsed {} messages",round,index);
+            ++errors;
+        }
+    }
+
+    // demuxer,alternate zero copy input and recv into write_buffer
+    for(int round = 0;round < option_rounds->value();round++){
+        size_t messages = 0,frames = 0;
+        rtsp_tcp_demuxer demuxer([&messages](const rtsp_message& message){
+            ++messages;
+        },1024);
+        rtsp_transport_spec spec;
+        const char* transport = "RTP/AVP/TCP;interleaved=0-1";
+        if(!rtsp_parse_transport(rtsp_slice{transport,strlen(transport)},&spec)){
+            zlog_error("transport {} not parsed",transport);
+            ++errors;
+        }
+        demuxer.set_channels(spec,nullptr,[&frames](uint8_t channel,const uint8_t* data,size_t size){
+            frames += channel == 1 && size == 100;
+        });
+        size_t read = 0;
+        while(read < stream.size()){
+            size_t chunk = std::min<size_t>(stream.size() - read,1 + rng() % 128);
+            bool ok;
+            if(rng() & 0x01){
+                ok = demuxer.input(stream.data() + read,chunk);
+            }else{
+                size_t writable = 0;
+                uint8_t* buffer = demuxer.write_buffer(&writable);
+                chunk = std::min(chunk,writable);
+                memcpy(buffer,stream.data() + read,chunk);
+                ok = demuxer.commit(chunk);
+            }
+            if(!ok){
+                zlog_error("round {} demux failed at {} bytes",round,read);
+                ++errors;
+                break;
+            }
+            read += chunk;
+        }
+        if(messages != 3 || frames != 1 || demuxer.buffered()){
+            zlog_error("round {} demux {} messages {} frames {} buffered",round,messages,frames,demuxer.buffered());
+            ++errors;
+        }
+    }
+
+    if(errors){
+        zlog_error("rtsp framing {} errors",errors);
+        return 1;
+    }
+    zlog("rtsp framing ok,{} bytes",stream.size());
+    return 0;
+}
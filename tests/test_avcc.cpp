@@ -0,0 +1,249 @@
+#include <zlog/log.h>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "zav/codec/h26x.h"
+#include "zcf/memory.hpp"
+#include "h26x_sample.hpp"
+
+/**
+ * annexb <-> avcc converters on generated frames,
+ * avcC/hvcC records of known parameter sets
+ */
+using namespace zav;
+
+static std::vector<uint8_t> gather(const avcc_converter& converter,size_t size){
+    if(converter.in_place()){
+        return std::vector<uint8_t>(converter.data(),converter.data() + size);
+    }
+    std::vector<uint8_t> avcc;
+    for(const auto& iov : converter.iov()){
+        avcc.insert(avcc.end(),(const uint8_t*)iov.iov_base,(const uint8_t*)iov.iov_base + iov.iov_len);
+    }
+    return avcc;
+}
+
+/**
+ * avcc of the frame must be every non empty nalu without trailing zeros,
+ * and give the same nalus back as annexb
+ */
+static int check_frame(const std::vector<uint8_t>& frame,bool expect_in_place){
+    std::vector<h26x_nalu> nalus;
+    h26x::annexb_index_nalus(frame.data(),frame.size(),nalus);
+    std::vector<uint8_t> expect;
+    for(const auto& nalu : nalus){
+        size_t size = h26x::nalu_size_trimmed(nalu);
+        if(!size){
+            continue;
+        }
+        uint8_t length[4];
+        Z_WBE32(length,(uint32_t)size);
+        expect.insert(expect.end(),length,length + 4);
+        expect.insert(expect.end(),h26x::nalu_data(nalu),h26x::nalu_data(nalu) + size);
+    }
+
+    std::vector<uint8_t> bytes = frame;
+    avcc_converter converter;
+    size_t size = converter.convert(bytes.data(),bytes.size());
+    std::vector<uint8_t> avcc = gather(converter,size);
+    if(converter.in_place() != expect_in_place || size != expect.size() || avcc != expect){
+        zlog_error("avcc of {} bytes:in place {} size {},expect {}",frame.size(),converter.in_place(),size,expect.size());
+        return 1;
+    }
+    if(!converter.in_place() && bytes != frame){
+        zlog_error("gather convert modified input");
+        return 1;
+    }
+
+    // back to annexb,copy and in place
+    size_t annexb_size = h26x::avcc_to_annexb_size(avcc.data(),avcc.size(),4);
+    std::vector<uint8_t> annexb(annexb_size);
+    if(!annexb_size || h26x::avcc_to_annexb(avcc.data(),avcc.size(),4,annexb.data()) != annexb_size){
+        zlog_error("avcc_to_annexb of {} bytes failed",avcc.size());
+        return 1;
+    }
+    if(!h26x::avcc_to_annexb_inplace(avcc.data(),avcc.size()) || avcc != annexb){
+        zlog_error("avcc_to_annexb_inplace mismatch");
+        return 1;
+    }
+    std::vector<h26x_nalu> back;
+    h26x::annexb_index_nalus(annexb.data(),annexb.size(),back);
+    size_t k = 0;
+    for(const auto& nalu : nalus){
+        size_t nalu_size = h26x::nalu_size_trimmed(nalu);
+        if(!nalu_size){
+            continue;
+        }
+        if(k >= back.size() || back[k].prefix != NALU_LONG_PREFIX || h26x::nalu_size(back[k]) != nalu_size
+            || memcmp(h26x::nalu_data(back[k]),h26x::nalu_data(nalu),nalu_size) != 0){
+            zlog_error("annexb nalu {} mismatch",k);
+            return 1;
+        }
+        ++k;
+    }
+    if(k != back.size()){
+        zlog_error("annexb has {} nalus,expect {}",back.size(),k);
+        return 1;
+    }
+    if(expect_in_place && annexb != frame){
+        zlog_error("4 bytes start code frame not round trip");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc,char** argv){
+    zlog::logger::create_defaultLogger();
+    int errors = 0;
+
+    std::mt19937 rng(0x10);
+    for(int round = 0;round < 500;round++){
+        std::vector<uint8_t> frame;
+        int count = 1 + rng() % 8;
+        for(int i = 0;i < count;i++){
+            h26x_sample::append_nalu(frame,rng,0x41,rng() % 3000,true);
+        }
+        errors += check_frame(frame,true);
+        // 3 bytes start codes,trailing_zero_8bits and empty nalus need gather
+        frame.clear();
+        for(int i = 0;i < count;i++){
+            h26x_sample::append_nalu(frame,rng,0x41,rng() % 3000,(rng() & 0x01) != 0);
+            if(rng() & 0x01){
+                frame.insert(frame.end(),1 + rng() % 4,0x00);
+            }
+        }
+        static const uint8_t empty[4] = {0x00,0x00,0x00,0x01};
+        frame.insert(frame.end(),empty,empty + 4);
+        errors += check_frame(frame,false);
+    }
+    std::vector<uint8_t> bytes(8,0x00);
+    avcc_converter converter;
+    if(converter.convert(bytes.data(),bytes.size()) != 0){
+        zlog_error("avcc of no nalu must be 0");
+        ++errors;
+    }
+
+    // 1 and 2 bytes length,broken length
+    {
+        static const uint8_t avcc1[6] = {0x02,0x09,0xf0,0x02,0x41,0x9a};
+        static const uint8_t avcc2[5] = {0x00,0x03,0x67,0x42,0x00};
+        static const uint8_t annexb1[12] = {0x00,0x00,0x00,0x01,0x09,0xf0,0x00,0x00,0x00,0x01,0x41,0x9a};
+        static const uint8_t annexb2[7] = {0x00,0x00,0x00,0x01,0x67,0x42,0x00};
+        uint8_t out[16];
+        if(h26x::avcc_to_annexb_size(avcc1,sizeof(avcc1),1) != sizeof(annexb1)
+            || h26x::avcc_to_annexb(avcc1,sizeof(avcc1),1,out) != sizeof(annexb1) || memcmp(out,annexb1,sizeof(annexb1)) != 0){
+            zlog_error("avcc_to_annexb 1 byte length mismatch");
+            ++errors;
+        }
+        if(h26x::avcc_to_annexb(avcc2,sizeof(avcc2),2,out) != sizeof(annexb2) || memcmp(out,annexb2,sizeof(annexb2)) != 0){
+            zlog_error("avcc_to_annexb 2 bytes length mismatch");
+            ++errors;
+        }
+        uint8_t broken[8] = {0x00,0x00,0x00,0x05,0x41,0x9a,0x00,0x00};
+        if(h26x::avcc_to_annexb_size(avcc1,sizeof(avcc1) - 1,1) || h26x::avcc_to_annexb(avcc2,sizeof(avcc2),3,out)
+            || h26x::avcc_to_annexb_inplace(broken,sizeof(broken))){
+            zlog_error("broken avcc not rejected");
+            ++errors;
+        }
+    }
+
+    // avcC of RFC 6184 baseline sps/pps
+    {
+        static const uint8_t sps[9] = {0x67,0x42,0x00,0x0a,0x96,0x53,0x05,0x89,0x88};
+        static const uint8_t pps[4] = {0x68,0xc9,0x63,0x88};
+        std::vector<uint8_t> expect = {0x01,0x42,0x00,0x0a,0xff,0xe1,0x00,0x09};
+        expect.insert(expect.end(),sps,sps + sizeof(sps));
+        expect.insert(expect.end(),{0x01,0x00,0x04});
+        expect.insert(expect.end(),pps,pps + sizeof(pps));
+        h264_param_cache cache;
+        std::vector<uint8_t> record;
+        if(cache.build_avcc_record(record)){
+            zlog_error("avcC without parameter sets");
+            ++errors;
+        }
+        cache.update_sps(sps,sizeof(sps));
+        cache.update_pps(pps,sizeof(pps));
+        if(!cache.build_avcc_record(record) || record != expect){
+            zlog_error("avcC record mismatch,{} bytes",record.size());
+            ++errors;
+        }
+        // from annexb nalus with trailing_zero_8bits,padding is not cached
+        std::vector<uint8_t> annexb = {0x00,0x00,0x00,0x01};
+        annexb.insert(annexb.end(),sps,sps + sizeof(sps));
+        annexb.insert(annexb.end(),{0x00,0x00,0x00,0x00,0x00,0x01});
+        annexb.insert(annexb.end(),pps,pps + sizeof(pps));
+        annexb.insert(annexb.end(),{0x00,0x00});
+        std::vector<h26x_nalu> nalus;
+        h264_param_cache annexb_cache;
+        bool changed = false;
+        size_t count = h26x::annexb_index_nalus(annexb.data(),annexb.size(),nalus);
+        for(size_t i = 0;i < count;i++){
+            annexb_cache.update(nalus[i]);
+        }
+        bool updated = cache.update(nalus[0],&changed);
+        if(!annexb_cache.build_avcc_record(record) || record != expect || !updated || changed){
+            zlog_error("avcC record of padded nalus mismatch,{} bytes,changed {}",record.size(),changed);
+            ++errors;
+        }
+    }
+
+    // hvcC of main 10 1080p vps/sps/pps
+    {
+        static const uint8_t vps[24] = {0x40,0x01,0x0c,0x01,0xff,0xff,0x01,0x60,0x00,0x00,0x03,0x00,0x90,0x00,0x00,0x03,
+            0x00,0x00,0x03,0x00,0x5d,0x95,0x98,0x09};
+        static const uint8_t sps[50] = {0x42,0x01,0x01,0x01,0x60,0x00,0x00,0x03,0x00,0x90,0x00,0x00,0x03,0x00,0x00,0x03,
+            0x00,0x5d,0x68,0x00,0xf0,0x20,0x04,0x41,0xf2,0xb6,0x59,0x5e,0x49,0x12,0x62,0x3e,0xb7,0x49,0x73,0xc0,
+            0x5a,0x80,0x80,0x80,0x82,0x00,0x00,0x07,0xd2,0x00,0x00,0xea,0x60,0x10};
+        static const uint8_t pps[7] = {0x44,0x01,0xc1,0x72,0xb4,0x62,0x40};
+        // general_profile_idc 1,compatibility 0x60000000,constraint 0x900000000000,level 93,
+        // chroma 4:2:0,10 bits,1 temporal layer nested
+        std::vector<uint8_t> expect = {0x01,0x01,0x60,0x00,0x00,0x00,0x90,0x00,0x00,0x00,0x00,0x00,0x5d,
+            0xf0,0x00,0xfc,0xfd,0xfa,0xfa,0x00,0x00,0x0f,0x03};
+        expect.insert(expect.end(),{0xa0,0x00,0x01,0x00,(uint8_t)sizeof(vps)});
+        expect.insert(expect.end(),vps,vps + sizeof(vps));
+        expect.insert(expect.end(),{0xa1,0x00,0x01,0x00,(uint8_t)sizeof(sps)});
+        expect.insert(expect.end(),sps,sps + sizeof(sps));
+        expect.insert(expect.end(),{0xa2,0x00,0x01,0x00,(uint8_t)sizeof(pps)});
+        expect.insert(expect.end(),pps,pps + sizeof(pps));
+        h265_param_cache cache;
+        std::vector<uint8_t> record;
+        cache.update_vps(vps,sizeof(vps));
+        cache.update_sps(sps,sizeof(sps));
+        if(cache.build_hvcc_record(record)){
+            zlog_error("hvcC without pps");
+            ++errors;
+        }
+        cache.update_pps(pps,sizeof(pps));
+        if(!cache.build_hvcc_record(record) || record != expect){
+            zlog_error("hvcC record mismatch,{} bytes",record.size());
+            ++errors;
+        }
+        // from annexb nalus with trailing_zero_8bits,padding is not cached
+        std::vector<uint8_t> annexb = {0x00,0x00,0x00,0x01};
+        annexb.insert(annexb.end(),vps,vps + sizeof(vps));
+        annexb.insert(annexb.end(),{0x00,0x00,0x00,0x01});
+        annexb.insert(annexb.end(),sps,sps + sizeof(sps));
+        annexb.insert(annexb.end(),{0x00,0x00,0x00,0x00,0x00,0x01});
+        annexb.insert(annexb.end(),pps,pps + sizeof(pps));
+        annexb.insert(annexb.end(),{0x00,0x00});
+        std::vector<h26x_nalu> nalus;
+        h265_param_cache annexb_cache;
+        bool changed = false;
+        size_t count = h26x::annexb_index_nalus(annexb.data(),annexb.size(),nalus);
+        for(size_t i = 0;i < count;i++){
+            annexb_cache.update(nalus[i]);
+        }
+        bool updated = cache.update(nalus[1],&changed);
+        if(!annexb_cache.build_hvcc_record(record) || record != expect || !updated || changed){
+            zlog_error("hvcC record of padded nalus mismatch,{} bytes,changed {}",record.size(),changed);
+            ++errors;
+        }
+    }
+
+    if(errors){
+        zlog_error("{} avcc errors",errors);
+        return 1;
+    }
+    zlog("avcc checked");
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include <zlog/log.h>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "zcf/zcf_buffer.hpp"
+
+/**
+ * bit_writer -> bit_buffer round trip of random bits/ue/se sequences,
+ * known exp-golomb bytes,overrun/overflow and more_rbsp_data
+ */
+enum op_type{
+    OP_BITS = 0,
+    OP_UE,
+    OP_SE,
+    OP_ALIGN,
+    OP_COUNT,
+};
+
+struct op{
+    op_type type;
+    int bits;
+    uint32_t value;
+};
+
+static op random_op(std::mt19937& rng){
+    op o;
+    o.type = (op_type)(rng() % OP_COUNT);
+    o.bits = 0;
+    uint32_t r = rng();
+    switch(o.type){
+    case OP_BITS:
+        o.bits = rng() % 33;
+        o.value = o.bits ? (uint32_t)(r & (0xffffffffu >> (32 - o.bits))) : 0;
+        break;
+    case OP_UE:
+        // small codes mostly,then up to the 2^32 - 2 limit
+        o.value = (rng() & 0x03) ? r >> (rng() % 32) : 0xfffffffeu - (r & 0xff);
+        break;
+    case OP_SE:
+        o.value = (rng() & 0x03) ? (uint32_t)((int32_t)r >> (rng() % 32)) : (uint32_t)((r & 0x01) ? INT32_MAX : -INT32_MAX);
+        break;
+    default:
+        o.value = 0;
+        break;
+    }
+    return o;
+}
+
+static int check_round_trip(std::mt19937& rng,size_t op_count){
+    std::vector<op> ops;
+    for(size_t i = 0;i < op_count;i++){
+        ops.push_back(random_op(rng));
+    }
+    std::vector<uint8_t> buffer(op_count * 9 + 16);
+    zcf::bit_writer writer(buffer.data(),buffer.size());
+    std::vector<size_t> positions;
+    for(const auto& o : ops){
+        positions.push_back(writer.bits_written());
+        switch(o.type){
+        case OP_BITS: writer.write_bits(o.value,o.bits); break;
+        case OP_UE: writer.write_ue(o.value); break;
+        case OP_SE: writer.write_se((int32_t)o.value); break;
+        default: writer.byte_align(); break;
+        }
+    }
+    size_t total_bits = writer.bits_written();
+    writer.write_trailing_bits();
+    size_t size = writer.flush();
+    if(writer.overflow() || size != (total_bits + 1 + 7) / 8){
+        zlog_error("bit_writer {} ops:{} bytes for {} bits,overflow {}",op_count,size,total_bits,writer.overflow());
+        return 1;
+    }
+
+    zcf::bit_buffer reader(buffer.data(),size);
+    for(size_t i = 0;i < ops.size();i++){
+        const op& o = ops[i];
+        if(reader.bits_read() != positions[i]){
+            zlog_error("op {} at bit {},expect {}",i,reader.bits_read(),positions[i]);
+            return 1;
+        }
+        if(!reader.more_rbsp_data() && !(o.type == OP_ALIGN || (o.type == OP_BITS && !o.bits))){
+            zlog_error("op {} more_rbsp_data false at bit {}",i,reader.bits_read());
+            return 1;
+        }
+        uint32_t value = 0;
+        switch(o.type){
+        case OP_BITS:
+            if(o.bits && reader.peek_bits(o.bits) != o.value){
+                zlog_error("op {} peek_bits({}) mismatch",i,o.bits);
+                return 1;
+            }
+            value = reader.read_bits(o.bits);
+            break;
+        case OP_UE: value = reader.read_ue(); break;
+        case OP_SE: value = (uint32_t)reader.read_se(); break;
+        default: reader.byte_align(); break;
+        }
+        if(value != o.value){
+            zlog_error("op {} type {} bits {}:read {},expect {}",i,(int)o.type,o.bits,value,o.value);
+            return 1;
+        }
+    }
+    if(reader.more_rbsp_data() || reader.read_bit() != 1 || reader.overrun()){
+        zlog_error("rbsp_stop_one_bit of {} ops not at bit {}",op_count,total_bits);
+        return 1;
+    }
+    reader.byte_align();
+    if(reader.bits_left() != 0 || reader.read_bits(32) != 0 || !reader.overrun()){
+        zlog_error("read over the end of {} bytes not overrun",size);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc,char** argv){
+    zlog::logger::create_defaultLogger();
+    int errors = 0;
+
+    // ue 0..4 = 1 010 011 00100 00101,se 1,-1 = 010 011,stop bit 1
+    {
+        static const uint8_t expect[3] = {0xa6,0x42,0xa7};
+        uint8_t buffer[4] = {0};
+        zcf::bit_writer writer(buffer,sizeof(buffer));
+        for(uint32_t v = 0;v < 5;v++){
+            writer.write_ue(v);
+        }
+        writer.write_se(1);
+        writer.write_se(-1);
+        writer.write_trailing_bits();
+        size_t size = writer.flush();
+        if(size != sizeof(expect) || memcmp(buffer,expect,size) != 0){
+            zlog_error("exp-golomb bytes {:02x} {:02x} {:02x},size {}",buffer[0],buffer[1],buffer[2],size);
+            ++errors;
+        }
+        zcf::bit_buffer reader(expect,sizeof(expect));
+        for(uint32_t v = 0;v < 5;v++){
+            if(reader.read_ue() != v){
+                zlog_error("read_ue {} mismatch",v);
+                ++errors;
+            }
+        }
+        if(reader.read_se() != 1 || reader.read_se() != -1 || reader.more_rbsp_data()){
+            zlog_error("read_se mismatch");
+            ++errors;
+        }
+    }
+
+    // read_bits64 and skip_bits over the 64 bits cache
+    {
+        static const uint8_t bytes[12] = {0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef,0xfe,0xdc,0xba,0x98};
+        zcf::bit_buffer reader(bytes,sizeof(bytes));
+        reader.skip_bits(4);
+        if(reader.read_bits64(60) != 0x123456789abcdefull || reader.read_bits(12) != 0xfed){
+            zlog_error("read_bits64 mismatch");
+            ++errors;
+        }
+        reader.skip_bits(20);
+        if(reader.bits_left() != 0 || reader.overrun()){
+            zlog_error("skip_bits to the end:{} bits left",reader.bits_left());
+            ++errors;
+        }
+    }
+
+    // no rbsp_stop_one_bit
+    {
+        static const uint8_t zeros[3] = {0x00,0x00,0x00};
+        zcf::bit_buffer reader(zeros,sizeof(zeros));
+        if(reader.more_rbsp_data() || reader.read_ue() != UINT32_MAX){
+            zlog_error("all zero bytes must have no rbsp data and invalid ue");
+            ++errors;
+        }
+    }
+
+    // 32 leading zeros + 1 + 31 zeros + 1 is 2^32,out of 32 bits
+    {
+        static const uint8_t bytes[9] = {0x00,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x80};
+        zcf::bit_buffer reader(bytes,sizeof(bytes));
+        if(reader.read_ue() != UINT32_MAX){
+            zlog_error("ue over 32 bits not invalid");
+            ++errors;
+        }
+    }
+
+    // over capacity is dropped
+    {
+        uint8_t buffer[4] = {0};
+        zcf::bit_writer writer(buffer,sizeof(buffer));
+        writer.write_bits(0xffffffff,32);
+        writer.write_ue(100);
+        writer.flush();
+        if(!writer.overflow() || buffer[3] != 0xff){
+            zlog_error("bit_writer over capacity not overflow");
+            ++errors;
+        }
+    }
+
+    std::mt19937 rng(0x06);
+    for(size_t round = 0;round < 2000;round++){
+        errors += check_round_trip(rng,1 + round % 300);
+    }
+    if(errors){
+        zlog_error("{} bit buffer errors",errors);
+        return 1;
+    }
+    zlog("bit buffer checked");
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <zlog/log.h>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "zav/codec/h26x.h"
+#include "zcf/zcf_cpu.hpp"
+
+/**
+ * emulation prevention byte insertion/removal,every kernel against
+ * a byte by byte reference of 7.4.1,on generated rbsp/ebsp
+ */
+typedef size_t (*convert_t)(const uint8_t* src,size_t size,uint8_t* dst);
+
+struct kernel{
+    const char* name;
+    convert_t to_rbsp;
+    convert_t to_ebsp;
+};
+
+static std::vector<uint8_t> reference_ebsp(const std::vector<uint8_t>& rbsp){
+    std::vector<uint8_t> ebsp;
+    size_t zeros = 0;
+    for(uint8_t b : rbsp){
+        if(zeros >= 2 && b <= 0x03){
+            ebsp.push_back(0x03);
+            zeros = 0;
+        }
+        ebsp.push_back(b);
+        zeros = b ? 0 : zeros + 1;
+    }
+    // cabac_zero_word at the end
+    if(zeros >= 2){
+        ebsp.push_back(0x03);
+    }
+    return ebsp;
+}
+
+static std::vector<uint8_t> reference_rbsp(const std::vector<uint8_t>& ebsp){
+    std::vector<uint8_t> rbsp;
+    size_t zeros = 0;
+    for(uint8_t b : ebsp){
+        if(zeros >= 2 && b == 0x03){
+            zeros = 0;
+            continue;
+        }
+        rbsp.push_back(b);
+        zeros = b ? 0 : zeros + 1;
+    }
+    return rbsp;
+}
+
+/**
+ * bytes of 0x00..0x04 mostly,so every 00 00 0x case and long zero runs show up
+ */
+static std::vector<uint8_t> make_bytes(std::mt19937& rng,size_t size,int zero_percent){
+    std::vector<uint8_t> bytes(size);
+    for(auto& b : bytes){
+        uint32_t r = rng();
+        if((int)(r % 100) < zero_percent){
+            b = 0x00;
+        }else{
+            b = (r & 0x100) ? (uint8_t)(r >> 16) : (uint8_t)(1 + (r >> 16) % 4);
+        }
+    }
+    return bytes;
+}
+
+int main(int argc,char** argv){
+    zlog::logger::create_defaultLogger();
+
+    std::vector<kernel> kernels;
+    kernels.push_back({"c",zav::h26x::ebsp_to_rbsp_c,zav::h26x::rbsp_to_ebsp_c});
+#if defined(__x86_64__)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_SSE42)){
+        kernels.push_back({"sse42",zav::h26x::ebsp_to_rbsp_sse42,zav::h26x::rbsp_to_ebsp_sse42});
+    }
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_AVX2)){
+        kernels.push_back({"avx2",zav::h26x::ebsp_to_rbsp_avx2,zav::h26x::rbsp_to_ebsp_avx2});
+    }
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    if(zcf::cpu::has(zcf::cpu::CPU_FEATURE_NEON)){
+        kernels.push_back({"neon",zav::h26x::ebsp_to_rbsp_neon,zav::h26x::rbsp_to_ebsp_neon});
+    }
+#endif
+    kernels.push_back({"dispatch",zav::h26x::ebsp_to_rbsp,zav::h26x::rbsp_to_ebsp});
+
+    std::mt19937 rng(0x05);
+    std::vector<std::vector<uint8_t>> samples;
+    // every size around the 64 bytes simd block,then large ones
+    for(size_t size = 0;size <= 260;size++){
+        samples.push_back(make_bytes(rng,size,size & 0x01 ? 30 : 70));
+    }
+    for(int i = 0;i < 16;i++){
+        samples.push_back(make_bytes(rng,64 * 1024 + rng() % 4096,10 + i * 5));
+    }
+    samples.push_back(std::vector<uint8_t>(1000,0x00));
+    std::vector<uint8_t> escaped;
+    for(int i = 0;i < 200;i++){
+        static const uint8_t pattern[4] = {0x00,0x00,0x03,0x01};
+        escaped.insert(escaped.end(),pattern,pattern + 2 + i % 3);
+    }
+    samples.push_back(escaped);
+
+    int errors = 0;
+    for(const auto& k : kernels){
+        for(size_t i = 0;i < samples.size();i++){
+            const std::vector<uint8_t>& sample = samples[i];
+            // rbsp -> ebsp
+            std::vector<uint8_t> expect = reference_ebsp(sample);
+            std::vector<uint8_t> ebsp(zav::h26x::rbsp_to_ebsp_max_size(sample.size()));
+            size_t ebsp_size = k.to_ebsp(sample.data(),sample.size(),ebsp.data());
+            if(ebsp_size != expect.size() || memcmp(ebsp.data(),expect.data(),ebsp_size) != 0){
+                zlog_error("{} rbsp_to_ebsp sample {} size {}:{} bytes,expect {}",k.name,i,sample.size(),ebsp_size,expect.size());
+                ++errors;
+                continue;
+            }
+            // ebsp -> rbsp gives the sample back
+            std::vector<uint8_t> rbsp(ebsp_size + 1);
+            size_t rbsp_size = k.to_rbsp(ebsp.data(),ebsp_size,rbsp.data());
+            if(rbsp_size != sample.size() || memcmp(rbsp.data(),sample.data(),rbsp_size) != 0){
+                zlog_error("{} ebsp_to_rbsp round trip sample {} size {}:{} bytes",k.name,i,sample.size(),rbsp_size);
+                ++errors;
+            }
+            // sample taken as ebsp,not all produced by an encoder
+            expect = reference_rbsp(sample);
+            rbsp.assign(sample.size() + 1,0xff);
+            rbsp_size = k.to_rbsp(sample.data(),sample.size(),rbsp.data());
+            if(rbsp_size != expect.size() || memcmp(rbsp.data(),expect.data(),rbsp_size) != 0){
+                zlog_error("{} ebsp_to_rbsp sample {} size {}:{} bytes,expect {}",k.name,i,sample.size(),rbsp_size,expect.size());
+                ++errors;
+            }
+            // in place
+            std::vector<uint8_t> in_place = sample;
+            rbsp_size = k.to_rbsp(in_place.data(),in_place.size(),in_place.data());
+            if(rbsp_size != expect.size() || memcmp(in_place.data(),expect.data(),rbsp_size) != 0){
+                zlog_error("{} in place ebsp_to_rbsp sample {} size {}:{} bytes,expect {}",k.name,i,sample.size(),rbsp_size,expect.size());
+                ++errors;
+            }
+        }
+        zlog("{} {} samples checked",k.name,samples.size());
+    }
+    if(errors){
+        zlog_error("{} ebsp errors",errors);
+        return 1;
+    }
+    return 0;
+}
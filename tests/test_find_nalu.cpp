@@ -2,7 +2,10 @@
 #include <zcf/zcf_flags.hpp>
 #include <chrono>
 #include <iostream>
+#include <random>
 #include "zav/codec/h26x.h"
+#include "zcf/zcf_cpu.hpp"
+#include "h26x_sample.hpp"
 
 int main(int argc,char** argv){
     zlog::logger::create_defaultLogger();
@@ -16,20 +19,32 @@ int main(int argc,char** argv){
         std::cout << option_parser << std::endl;
         return 0;
     }
-    if(!option_file->is_set()){
-        zlog("bench_h26x has no input file");
-        return 0;
+    std::vector<uint8_t> bytes;
+    if(option_file->is_set()){
+        std::string h26x_file = option_file->value();
+        FILE* rfile = fopen(h26x_file.c_str(), "rb");
+        if(!rfile){
+            zlog_error("open {} failed",h26x_file);
+            return 1;
+        }
+        fseek(rfile, 0, SEEK_END);
+        bytes.resize(ftell(rfile));
+        fseek(rfile, 0, SEEK_SET);
+        size_t read_size = fread(bytes.data(),1,bytes.size(),rfile);
+        fclose(rfile);
+        if(read_size != bytes.size()){
+            zlog_error("read {} failed,{}/{} bytes",h26x_file,read_size,bytes.size());
+            return 1;
+        }
+        zlog("{} size {}",h26x_file,bytes.size());
+    }else{
+        std::mt19937 rng(0x04);
+        bytes = h26x_sample::make_stream(1024 * 1024,rng);
+        zlog("generated annexb size {}",bytes.size());
     }
-    std::string h26x_file = option_file->value();
-    FILE* rfile = fopen(h26x_file.c_str(), "rb");
-    Z_ASSERT(rfile);
-    fseek(rfile, 0, SEEK_END);
-    size_t h26x_size = ftell(rfile);
-    fseek(rfile, 0, SEEK_SET);
-    zlog("{} size {}",h26x_file,h26x_size);
-    uint8_t* rbufer = new uint8_t[h26x_size];
-    fread(rbufer,1,h26x_size,rfile);
-    fclose(rfile);
+    const uint8_t* rbufer = bytes.data();
+    size_t h26x_size = bytes.size();
+    zlog("cpu features:{},annexb find kernel:{}",zcf::cpu::desc_features(),zav::h26x::annexb_find_start_kernel());
 
     // 5634个
     int bench_times = 1000;
@@ -53,4 +68,110 @@ int main(int argc,char** argv){
     }
     auto end = std::chrono::high_resolution_clock::now();
     zlog("find nalu {} times:found {},cost:{} ms",bench_times,nalu_count,std::chrono::duration_cast<std::chrono::milliseconds>(end -start).count());
+
+    // one pass index
+    size_t index_count = 0;
+    std::vector<zav::h26x_nalu> nalus;
+    start = std::chrono::high_resolution_clock::now();
+    for(int i = 0 ;i < bench_times ;i++){
+        index_count += zav::h26x::annexb_index_nalus(rbufer,h26x_size,nalus);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    zlog("index nalu {} times:found {},cost:{} ms",bench_times,index_count,std::chrono::duration_cast<std::chrono::milliseconds>(end -start).count());
+
+    // stream split as rtp/tcp 1400 bytes chunk
+    size_t split_count = 0;
+    zav::h26x::annexb_stream_splitter splitter([&split_count](const zav::h26x_nalu& nalu){
+        ++split_count;
+    });
+    start = std::chrono::high_resolution_clock::now();
+    for(int i = 0 ;i < bench_times ;i++){
+        for(size_t offset = 0; offset < h26x_size; offset += 1400){
+            size_t chunk = std::min<size_t>(1400,h26x_size - offset);
+            splitter.push(rbufer + offset,chunk);
+        }
+        splitter.flush();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    zlog("split nalu {} times:found {},cost:{} ms",bench_times,split_count,std::chrono::duration_cast<std::chrono::milliseconds>(end -start).count());
+
+    // every nalu of find_next,splitter of random chunks must be the nalu of index
+    size_t mismatch = 0;
+    std::vector<zav::h26x_nalu> found_nalus;
+    {
+        const uint8_t* p = rbufer;
+        const uint8_t* pend = rbufer + h26x_size;
+        zav::h26x_nalu nalu;
+        while(p < pend && zav::h26x::annexb_find_next_nalu(p,pend - p,&nalu)){
+            found_nalus.push_back(nalu);
+            p = nalu.end + 1;
+        }
+    }
+    mismatch += h26x_sample::diff_nalus("find next",rbufer,nalus,found_nalus);
+
+    h26x_sample::splitter_check check("split",rbufer,h26x_size,nalus);
+    zav::h26x::annexb_stream_splitter check_splitter([&check](const zav::h26x_nalu& nalu){
+        check.check(nalu);
+    });
+    std::mt19937 chunk_rng(0x40);
+    for(int round = 0;round < 8;round++){
+        // tiny chunks split start codes,large ones keep nalus in place
+        size_t max_chunk = round < 4 ? 8 : 4096;
+        for(size_t offset = 0;offset < h26x_size;){
+            size_t chunk = std::min<size_t>(1 + chunk_rng() % max_chunk,h26x_size - offset);
+            check_splitter.push(rbufer + offset,chunk);
+            offset += chunk;
+        }
+        check_splitter.flush();
+        mismatch += check.finish();
+    }
+
+    // parameter sets,repeated ones are only compared
+    zav::h264_param_cache h264_cache;
+    zav::h265_param_cache h265_cache;
+    size_t h264_changed = 0;
+    size_t h265_changed = 0;
+    for(const auto& nalu : nalus){
+        bool changed = false;
+        if(h264_cache.update(nalu,&changed) && changed){
+            ++h264_changed;
+        }
+        if(h265_cache.update(nalu,&changed) && changed){
+            ++h265_changed;
+        }
+    }
+    const zav::h264_sps* sps = h264_cache.sps(0);
+    if(sps){
+        zlog("h264 sps profile:{} level:{} {}x{} fps:{},parameter set changed {}",
+            sps->profile_idc,sps->level_idc,sps->width,sps->height,sps->fps,h264_changed);
+    }
+    const zav::h265_sps* hevc_sps = h265_cache.sps(0);
+    if(hevc_sps){
+        zlog("h265 sps profile:{} level:{} {}x{} bit depth:{} fps:{},parameter set changed {}",
+            hevc_sps->ptl.general_profile_idc,hevc_sps->ptl.general_level_idc,hevc_sps->width,hevc_sps->height,
+            hevc_sps->bit_depth_luma,hevc_sps->fps,h265_changed);
+    }
+
+    // access units
+    zav::AVCodecID codec = hevc_sps ? zav::AV_CODEC_VIDEO_H265 : zav::AV_CODEC_VIDEO_H264;
+    size_t frame_count = 0;
+    size_t key_count = 0;
+    zav::access_unit_builder au_builder(codec,[&frame_count,&key_count](const zav::h26x_frame& frame){
+        ++frame_count;
+        if(frame.flags & zav::H26X_FRAME_FLAG_KEY){
+            ++key_count;
+        }
+    });
+    start = std::chrono::high_resolution_clock::now();
+    for(const auto& nalu : nalus){
+        au_builder.push(nalu);
+    }
+    au_builder.flush();
+    end = std::chrono::high_resolution_clock::now();
+    zlog("access unit:frames {} key frames {},cost:{} us",frame_count,key_count,std::chrono::duration_cast<std::chrono::microseconds>(end -start).count());
+    if(mismatch){
+        zlog_error("{} nalus mismatch",mismatch);
+        return 1;
+    }
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include <zlog/log.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "zav/codec/h26x_reader.h"
+#include "h26x_sample.hpp"
+
+/**
+ * h26x_file_reader on small generated files:codec detection,
+ * keyframe index(built,saved and loaded from sidecar) and seek
+ */
+using namespace zav;
+
+#define TEST_GOP_SIZE 10
+#define TEST_GOP_COUNT 5
+
+static bool write_file(const std::string& path,const std::vector<uint8_t>& bytes){
+    FILE* file = fopen(path.c_str(),"wb");
+    if(!file){
+        return false;
+    }
+    bool written = fwrite(bytes.data(),1,bytes.size(),file) == bytes.size();
+    return fclose(file) == 0 && written;
+}
+
+static int check_keyframes(const h26x_file_reader& reader,const std::vector<h26x_keyframe>& expect,const char* name){
+    if(reader.frame_count() != TEST_GOP_SIZE * TEST_GOP_COUNT || reader.keyframes().size() != expect.size() || reader.fps() != 25){
+        zlog_error("{} index:{} frames {} keyframes fps {}",name,reader.frame_count(),reader.keyframes().size(),reader.fps());
+        return 1;
+    }
+    for(size_t i = 0;i < expect.size();i++){
+        const h26x_keyframe& k = reader.keyframes()[i];
+        if(k.offset != expect[i].offset || k.size != expect[i].size || k.frame_index != expect[i].frame_index
+            || k.timestamp_us != expect[i].timestamp_us){
+            zlog_error("{} keyframe {}:offset {} size {} frame {} ts {}",name,i,k.offset,k.size,k.frame_index,k.timestamp_us);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc,char** argv){
+    zlog::logger::create_defaultLogger();
+    int errors = 0;
+    std::string path = "test_h26x_reader.h264";
+
+    // sps(no vui,25 fps default)/pps + idr + p slices per gop
+    static const uint8_t sps[9] = {0x67,0x42,0x00,0x0a,0x96,0x53,0x05,0x89,0x88};
+    static const uint8_t pps[4] = {0x68,0xc9,0x63,0x88};
+    static const uint8_t prefix[4] = {0x00,0x00,0x00,0x01};
+    std::mt19937 rng(0x12);
+    std::vector<uint8_t> bytes;
+    std::vector<h26x_keyframe> expect;
+    for(int gop = 0;gop < TEST_GOP_COUNT;gop++){
+        h26x_keyframe keyframe;
+        keyframe.offset = bytes.size();
+        keyframe.frame_index = gop * TEST_GOP_SIZE;
+        keyframe.timestamp_us = (int64_t)keyframe.frame_index * 1000000 / 25;
+        bytes.insert(bytes.end(),prefix,prefix + 4);
+        bytes.insert(bytes.end(),sps,sps + sizeof(sps));
+        bytes.insert(bytes.end(),prefix,prefix + 4);
+        bytes.insert(bytes.end(),pps,pps + sizeof(pps));
+        // first_mb_in_slice 0,slice_type 7(I) / 5(P)
+        h26x_sample::append_slice(bytes,rng,{0x65},0x88,2000 + rng() % 2000);
+        keyframe.size = bytes.size() - keyframe.offset;
+        expect.push_back(keyframe);
+        for(int i = 1;i < TEST_GOP_SIZE;i++){
+            h26x_sample::append_slice(bytes,rng,{0x41},0x98,rng() % 500);
+        }
+    }
+    ::unlink((path + ".zidx").c_str());
+    if(!write_file(path,bytes)){
+        zlog_error("write {} failed",path);
+        return 1;
+    }
+
+    {
+        h26x_file_reader reader;
+        if(!reader.open(path) || reader.codec() != AV_CODEC_VIDEO_H264 || reader.size() != bytes.size()){
+            zlog_error("open {} failed or codec {} not h264",path,(int)reader.codec());
+            return 1;
+        }
+        // no sidecar,built and saved
+        if(!reader.load_index() || access(reader.index_path().c_str(),F_OK) != 0){
+            zlog_error("index of {} not built",path);
+            ++errors;
+        }
+        errors += check_keyframes(reader,expect,"built");
+
+        // last keyframe at or before timestamp
+        static const struct{
+            int64_t timestamp_us;
+            size_t keyframe;
+        } seeks[6] = {{-1,0},{0,0},{399999,0},{400000,1},{1000000,2},{INT64_MAX,TEST_GOP_COUNT - 1}};
+        for(const auto& s : seeks){
+            const h26x_keyframe* keyframe = reader.seek(s.timestamp_us);
+            if(!keyframe || keyframe != &reader.keyframes()[s.keyframe]
+                || reader.keyframe_data(*keyframe) != reader.data() + keyframe->offset){
+                zlog_error("seek {} not keyframe {}",s.timestamp_us,s.keyframe);
+                ++errors;
+            }
+        }
+        const uint8_t* data = reader.keyframe_data(reader.keyframes().back());
+        if(memcmp(data + 4,sps,sizeof(sps)) != 0){
+            zlog_error("keyframe data not start with sps");
+            ++errors;
+        }
+    }
+    {
+        // sidecar loaded,a broken one is rebuilt
+        h26x_file_reader reader;
+        if(!reader.open(path,AV_CODEC_VIDEO_H264) || !reader.load_index()){
+            zlog_error("reopen {} failed",path);
+            ++errors;
+        }
+        errors += check_keyframes(reader,expect,"loaded");
+        std::vector<uint8_t> broken(16,0xff);
+        write_file(reader.index_path(),broken);
+        if(!reader.load_index()){
+            zlog_error("broken sidecar not rebuilt");
+            ++errors;
+        }
+        errors += check_keyframes(reader,expect,"rebuilt");
+    }
+    ::unlink((path + ".zidx").c_str());
+
+    // h265 vps first
+    {
+        static const uint8_t vps[24] = {0x40,0x01,0x0c,0x01,0xff,0xff,0x01,0x60,0x00,0x00,0x03,0x00,0x90,0x00,0x00,0x03,
+            0x00,0x00,0x03,0x00,0x5d,0x95,0x98,0x09};
+        std::vector<uint8_t> hevc(prefix,prefix + 4);
+        hevc.insert(hevc.end(),vps,vps + sizeof(vps));
+        h26x_file_reader reader;
+        if(!write_file(path,hevc) || !reader.open(path) || reader.codec() != AV_CODEC_VIDEO_H265){
+            zlog_error("h265 not detected");
+            ++errors;
+        }
+    }
+
+    // page size file end with an empty nalu,its header is past the mapping
+    {
+        std::vector<uint8_t> filler(prefix,prefix + 4);
+        filler.resize(getpagesize() - 4,0xff);
+        // h264 filler data
+        filler[4] = 0x0c;
+        filler.insert(filler.end(),prefix,prefix + 4);
+        // mmap is top down,the file is mapped to the freed page before a PROT_NONE one,
+        // so reading past the file faults
+        size_t page_size = getpagesize();
+        uint8_t* guard = (uint8_t*)mmap(nullptr,page_size * 2,PROT_NONE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+        if(guard != MAP_FAILED){
+            munmap(guard,page_size);
+        }
+        h26x_file_reader reader;
+        if(!write_file(path,filler) || !reader.open(path) || reader.codec() != AV_CODEC_VIDEO_H264){
+            zlog_error("empty trailing nalu detect failed");
+            ++errors;
+        }
+        if(guard != MAP_FAILED){
+            munmap(guard + page_size,page_size);
+        }
+    }
+    ::unlink(path.c_str());
+
+    if(errors){
+        zlog_error("{} h26x reader errors",errors);
+        return 1;
+    }
+    zlog("h26x reader checked");
+    return 0;
+}
@@ -0,0 +1,314 @@
+#include <zlog/log.h>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "zav/proto/rtp_h26x.h"
+#include "zav/proto/rtp_jitter.h"
+#include "h26x_sample.hpp"
+
+/**
+ * rtp_h26x_packetizer -> rtp_h26x_depacketizer round trip of generated h264/h265
+ * access units,in order,reordered,duplicated,lost and truncated packets,
+ * reordered inside the depacketizer or by rtp_jitter_buffer
+ */
+using namespace zav;
+
+#define TEST_FRAME_COUNT 60
+#define TEST_GOP_SIZE 10
+#define TEST_TIMESTAMP_STEP 3000
+#define TEST_MTU 1200
+
+typedef std::vector<uint8_t> bytes_t;
+
+struct test_packet{
+    bytes_t bytes;
+    size_t frame;
+};
+
+struct test_result{
+    size_t frames;
+    size_t complete;
+    size_t incomplete;
+    size_t mismatch;
+};
+
+static const uint8_t kPrefix[4] = {0x00,0x00,0x00,0x01};
+
+static void append_bytes(bytes_t& out,const uint8_t* nalu,size_t size){
+    out.insert(out.end(),kPrefix,kPrefix + 4);
+    out.insert(out.end(),nalu,nalu + size);
+}
+
+/**
+ * parameter sets + large idr every gop,p frames of one or two slices,
+ * so single nalu,STAP-A/AP and FU-A/FU packets are all used
+ */
+static std::vector<bytes_t> make_frames(AVCodecID codec,std::mt19937& rng){
+    static const uint8_t sps[9] = {0x67,0x42,0x00,0x0a,0x96,0x53,0x05,0x89,0x88};
+    static const uint8_t pps[4] = {0x68,0xc9,0x63,0x88};
+    static const uint8_t hevc_vps[24] = {0x40,0x01,0x0c,0x01,0xff,0xff,0x01,0x60,0x00,0x00,0x03,0x00,0x90,0x00,0x00,0x03,
+        0x00,0x00,0x03,0x00,0x5d,0x95,0x98,0x09};
+    static const uint8_t hevc_sps[50] = {0x42,0x01,0x01,0x01,0x60,0x00,0x00,0x03,0x00,0x90,0x00,0x00,0x03,0x00,0x00,0x03,
+        0x00,0x5d,0x68,0x00,0xf0,0x20,0x04,0x41,0xf2,0xb6,0x59,0x5e,0x49,0x12,0x62,0x3e,0xb7,0x49,0x73,0xc0,
+        0x5a,0x80,0x80,0x80,0x82,0x00,0x00,0x07,0xd2,0x00,0x00,0xea,0x60,0x10};
+    static const uint8_t hevc_pps[7] = {0x44,0x01,0xc1,0x72,0xb4,0x62,0x40};
+    bool h264 = codec == AV_CODEC_VIDEO_H264;
+    // idr/p nalu header,first slice head(first_mb_in_slice 0/first_slice_segment_in_pic_flag 1),next slice head
+    bytes_t idr = h264 ? bytes_t{0x65} : bytes_t{0x26,0x01};
+    bytes_t p = h264 ? bytes_t{0x41} : bytes_t{0x02,0x01};
+    uint8_t idr_head = h264 ? 0x88 : 0x80;
+    uint8_t p_head = h264 ? 0x98 : 0x80;
+    uint8_t next_head = h264 ? 0x46 : 0x40;
+
+    std::vector<bytes_t> frames;
+    for(int f = 0;f < TEST_FRAME_COUNT;f++){
+        bytes_t frame;
+        if(f % TEST_GOP_SIZE == 0){
+            if(h264){
+                append_bytes(frame,sps,sizeof(sps));
+                append_bytes(frame,pps,sizeof(pps));
+            }else{
+                append_bytes(frame,hevc_vps,sizeof(hevc_vps));
+                append_bytes(frame,hevc_sps,sizeof(hevc_sps));
+                append_bytes(frame,hevc_pps,sizeof(hevc_pps));
+            }
+            h26x_sample::append_slice(frame,rng,idr,idr_head,5000 + rng() % 15000);
+        }else if(rng() & 0x01){
+            h26x_sample::append_slice(frame,rng,p,p_head,rng() % 3000);
+        }else{
+            h26x_sample::append_slice(frame,rng,p,p_head,rng() % 300);
+            h26x_sample::append_slice(frame,rng,p,next_head,rng() % 300);
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+static std::vector<test_packet> packetize(AVCodecID codec,const std::vector<bytes_t>& frames,int& errors){
+    std::vector<test_packet> packets;
+    // sequence wrap inside the stream
+    rtp_h26x_packetizer packetizer(codec,96,0x12345678,TEST_MTU,65500);
+    for(size_t f = 0;f < frames.size();f++){
+        size_t count = packetizer.packetize(frames[f].data(),frames[f].size(),(uint32_t)(f * TEST_TIMESTAMP_STEP));
+        for(size_t i = 0;i < count;i++){
+            const rtp_iov_packet& packet = packetizer.packets()[i];
+            test_packet out;
+            out.frame = f;
+            for(size_t k = 0;k < packet.iov_count;k++){
+                const uint8_t* base = (const uint8_t*)packet.iov[k].iov_base;
+                out.bytes.insert(out.bytes.end(),base,base + packet.iov[k].iov_len);
+            }
+            if(out.bytes.size() != packet.size || out.bytes.size() > TEST_MTU){
+                zlog_error("packet {} of frame {}:{} bytes,size {}",i,f,out.bytes.size(),packet.size);
+                ++errors;
+            }
+            packets.push_back(out);
+        }
+    }
+    return packets;
+}
+
+/**
+ * feed one packet per ms,frames not flagged incomplete must be the same bytes,
+ * poll after max_delay_ms must release everything before flush
+ */
+static test_result depacketize(AVCodecID codec,const std::vector<bytes_t>& frames,const std::vector<test_packet>& packets,
+    uint32_t max_delay_ms,bool jitter = false){
+    test_result result = {0,0,0,0};
+    rtp_h26x_depacketizer depacketizer(codec,[&](const h26x_frame& frame,uint32_t timestamp){
+        ++result.frames;
+        if(frame.flags & H26X_FRAME_FLAG_INCOMPLETE){
+            ++result.incomplete;
+            return;
+        }
+        size_t f = timestamp / TEST_TIMESTAMP_STEP;
+        size_t size = frame.end - frame.start + 1;
+        if(timestamp % TEST_TIMESTAMP_STEP || f >= frames.size() || size != frames[f].size()
+            || memcmp(frame.start,frames[f].data(),size) != 0){
+            ++result.mismatch;
+            return;
+        }
+        ++result.complete;
+    },32,1500,4 * 1024 * 1024,max_delay_ms);
+    uint64_t now_ms = 1000;
+    if(!jitter){
+        for(const auto& packet : packets){
+            depacketizer.input(packet.bytes.data(),packet.bytes.size(),now_ms++);
+        }
+        depacketizer.poll(now_ms + max_delay_ms);
+        return result;
+    }
+    // udp path,in order packets of rtp_jitter_buffer
+    rtp_jitter_buffer buffer(1024 * 1024,1500,max_delay_ms);
+    rtp_jitter_packet popped;
+    for(const auto& packet : packets){
+        size_t capacity = 0;
+        uint8_t* data = buffer.acquire(&capacity);
+        if(data && packet.bytes.size() <= capacity){
+            memcpy(data,packet.bytes.data(),packet.bytes.size());
+            buffer.insert(packet.bytes.size(),now_ms);
+        }
+        ++now_ms;
+        while(buffer.pop(now_ms,&popped)){
+            depacketizer.input(popped.rtp);
+            buffer.release(popped);
+        }
+    }
+    while(buffer.pop(now_ms + max_delay_ms,&popped)){
+        depacketizer.input(popped.rtp);
+        buffer.release(popped);
+    }
+    depacketizer.flush();
+    return result;
+}
+
+static int check(const char* name,const test_result& result,size_t complete,size_t max_frames){
+    if(result.mismatch || result.complete != complete || result.frames > max_frames){
+        zlog_error("{}:{} frames,{} complete,{} incomplete,{} mismatch,expect {} complete",name,result.frames,
+            result.complete,result.incomplete,result.mismatch,complete);
+        return 1;
+    }
+    return 0;
+}
+
+static int check_codec(AVCodecID codec){
+    const char* codec_name = codec == AV_CODEC_VIDEO_H264 ? "h264" : "h265";
+    int errors = 0;
+    std::mt19937 rng(0x14);
+    std::vector<bytes_t> frames = make_frames(codec,rng);
+    std::vector<test_packet> packets = packetize(codec,frames,errors);
+    // marker on the last packet of every frame
+    for(size_t i = 0;i < packets.size();i++){
+        bool last = i + 1 == packets.size() || packets[i + 1].frame != packets[i].frame;
+        if(((packets[i].bytes[1] & 0x80) != 0) != last){
+            zlog_error("{} packet {} of frame {} marker {}",codec_name,i,packets[i].frame,!last);
+            ++errors;
+        }
+    }
+
+    // in order,also no reorder wait at all
+    errors += check(codec_name,depacketize(codec,frames,packets,100),frames.size(),frames.size());
+    errors += check(codec_name,depacketize(codec,frames,packets,0),frames.size(),frames.size());
+
+    // reordered in the window,duplicated
+    std::vector<test_packet> reordered = packets;
+    for(size_t i = 0;i + 8 <= reordered.size();i += 8){
+        std::shuffle(reordered.begin() + i,reordered.begin() + i + 8,rng);
+    }
+    errors += check("reordered",depacketize(codec,frames,reordered,100),frames.size(),frames.size());
+    std::vector<test_packet> duplicated;
+    for(const auto& packet : reordered){
+        duplicated.push_back(packet);
+        if((rng() & 0x03) == 0){
+            duplicated.push_back(packet);
+        }
+        if((rng() & 0x07) == 0 && duplicated.size() > 20){
+            duplicated.push_back(duplicated[duplicated.size() - 20]);
+        }
+    }
+    errors += check("duplicated",depacketize(codec,frames,duplicated,100),frames.size(),frames.size());
+    errors += check("jitter buffer",depacketize(codec,frames,duplicated,100,true),frames.size(),frames.size());
+
+    // lost and truncated,frames of the other packets still come out before flush
+    for(int round = 0;round < 20;round++){
+        std::vector<test_packet> damaged;
+        std::vector<bool> broken(frames.size(),false);
+        for(size_t i = 0;i < reordered.size();i++){
+            test_packet packet = reordered[i];
+            uint32_t r = rng() % 64;
+            if(i && i + 1 < reordered.size() && r == 0){
+                broken[packet.frame] = true;
+                continue;
+            }
+            if(r == 1){
+                broken[packet.frame] = true;
+                packet.bytes.resize(rng() % packet.bytes.size());
+            }
+            damaged.push_back(packet);
+        }
+        // a lost marker packet is seen at the next frame,both are incomplete
+        size_t complete = 0;
+        for(size_t f = 0;f < frames.size();f++){
+            complete += !broken[f] && (!f || !broken[f - 1]);
+        }
+        test_result result = depacketize(codec,frames,damaged,20,(round & 0x01) != 0);
+        // a truncated packet may still be a valid nalu of other bytes
+        result.complete += result.mismatch;
+        result.mismatch = 0;
+        if(result.complete < complete){
+            zlog_error("{} damaged round {}:{} frames complete,expect at least {}",codec_name,round,result.complete,complete);
+            ++errors;
+        }
+    }
+    zlog("{} {} frames,{} packets checked",codec_name,frames.size(),packets.size());
+    return errors;
+}
+
+int main(int argc,char** argv){
+    zlog::logger::create_defaultLogger();
+    int errors = 0;
+    errors += check_codec(AV_CODEC_VIDEO_H264);
+    errors += check_codec(AV_CODEC_VIDEO_H265);
+
+    // single packet frames at startup come out after max_delay_ms,not after half window
+    {
+        std::mt19937 rng(0x15);
+        std::vector<bytes_t> frames;
+        for(int f = 0;f < 15;f++){
+            bytes_t frame;
+            h26x_sample::append_slice(frame,rng,{0x41},0x98,100);
+            frames.push_back(frame);
+        }
+        std::vector<test_packet> packets = packetize(AV_CODEC_VIDEO_H264,frames,errors);
+        size_t count = 0;
+        rtp_h26x_depacketizer depacketizer(AV_CODEC_VIDEO_H264,[&](const h26x_frame& frame,uint32_t timestamp){
+            ++count;
+        },32,1500,4 * 1024 * 1024,50);
+        for(size_t i = 0;i < packets.size();i++){
+            depacketizer.input(packets[i].bytes.data(),packets[i].bytes.size(),i);
+        }
+        depacketizer.poll(60);
+        if(packets.size() != frames.size() || count != frames.size()){
+            zlog_error("startup frames {} of {} before flush",count,frames.size());
+            ++errors;
+        }
+    }
+
+    // header only end of sequence(h264 10,h265 36) is sent with the marker,empty nalu is skipped,
+    // after a fragmented slice it is a single nalu packet
+    for(int k = 0;k < 4;k++){
+        AVCodecID codec = k < 2 ? AV_CODEC_VIDEO_H264 : AV_CODEC_VIDEO_H265;
+        bool h264 = codec == AV_CODEC_VIDEO_H264;
+        bool fu = (k & 0x01) != 0;
+        std::mt19937 rng(0x16);
+        bytes_t frame;
+        h26x_sample::append_slice(frame,rng,h264 ? bytes_t{0x41} : bytes_t{0x02,0x01},h264 ? 0x98 : 0x80,fu ? 3000 : 100);
+        static const uint8_t h264_eos[1] = {0x0a};
+        static const uint8_t h265_eos[2] = {0x48,0x01};
+        const uint8_t* eos = h264 ? h264_eos : h265_eos;
+        size_t eos_size = h264 ? sizeof(h264_eos) : sizeof(h265_eos);
+        append_bytes(frame,eos,eos_size);
+        bytes_t expect = frame;
+        static const uint8_t empty[6] = {0x00,0x00,0x00,0x01,0x00,0x00};
+        frame.insert(frame.end(),empty,empty + sizeof(empty));
+
+        std::vector<bytes_t> frames(1,frame);
+        std::vector<test_packet> packets = packetize(codec,frames,errors);
+        const test_packet* last = packets.empty() ? nullptr : &packets.back();
+        if(!last || !(last->bytes[1] & 0x80) || (fu && (last->bytes.size() != RTP_HEADER_SIZE + eos_size
+            || memcmp(last->bytes.data() + RTP_HEADER_SIZE,eos,eos_size) != 0))){
+            zlog_error("{} end of sequence not sent last with marker,{} packets",h264 ? "h264" : "h265",packets.size());
+            ++errors;
+        }
+        frames[0] = expect;
+        errors += check("end of sequence",depacketize(codec,frames,packets,0),1,1);
+    }
+
+    if(errors){
+        zlog_error("{} rtp h26x errors",errors);
+        return 1;
+    }
+    zlog("rtp h26x checked");
+    return 0;
+}
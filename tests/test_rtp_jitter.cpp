@@ -0,0 +1,249 @@
+#include <zlog/log.h>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "zav/proto/rtp_jitter.h"
+#include "zcf/memory.hpp"
+
+/**
+ * rtp_jitter_buffer reorder,loss timeout and nack retry on a simulated clock,
+ * rtcp_nack_fci packing
+ */
+using namespace zav;
+
+#define TEST_MAX_PACKET 1500
+#define TEST_DELAY_MS 30
+
+/**
+ * receive packet of seq into acquired buffer,payload is the seq again
+ */
+static bool push(rtp_jitter_buffer& jitter,uint16_t seq,uint64_t now_ms){
+    size_t capacity = 0;
+    uint8_t* buffer = jitter.acquire(&capacity);
+    if(!buffer || capacity < RTP_HEADER_SIZE + 2){
+        return false;
+    }
+    rtp_header header;
+    memset(&header,0,sizeof(header));
+    header.payload_type = 96;
+    header.seq = seq;
+    header.timestamp = seq * 3000u;
+    header.ssrc = 0x1234;
+    rtp_write_header(buffer,header);
+    Z_WBE16(buffer + RTP_HEADER_SIZE,seq);
+    return jitter.insert(RTP_HEADER_SIZE + 2,now_ms);
+}
+
+/**
+ * pop every ready packet,in order and with its own payload
+ */
+static int pop_all(rtp_jitter_buffer& jitter,uint64_t now_ms,std::vector<uint16_t>& popped){
+    int errors = 0;
+    rtp_jitter_packet packet;
+    while(jitter.pop(now_ms,&packet)){
+        uint16_t seq = packet.rtp.header.seq;
+        if(packet.rtp.payload_size != 2 || Z_RBE16(packet.rtp.payload) != seq
+            || (!popped.empty() && !rtp_seq_before(popped.back(),seq))){
+            if(!errors){
+                zlog_error("popped seq {} after {}",seq,popped.empty() ? 0 : popped.back());
+            }
+            ++errors;
+        }
+        popped.push_back(seq);
+        jitter.release(packet);
+    }
+    return errors;
+}
+
+static int check_random(uint32_t seed){
+    int errors = 0;
+    std::mt19937 rng(seed);
+    // ring larger than packets of max_delay_ms,so nothing is pushed out of it
+    rtp_jitter_buffer jitter(1024 * 1024,TEST_MAX_PACKET,TEST_DELAY_MS);
+    // sequence wrap,reordered in groups of 8,1% lost,2% duplicated
+    std::vector<uint16_t> order;
+    for(int i = 0;i < 3000;i++){
+        order.push_back((uint16_t)(65000 + i));
+    }
+    for(size_t i = 0;i + 8 <= order.size();i += 8){
+        std::shuffle(order.begin() + i,order.begin() + i + 8,rng);
+    }
+    size_t dropped = 0;
+    uint64_t now_ms = 0;
+    std::vector<uint16_t> popped;
+    for(size_t i = 0;i < order.size();i++){
+        ++now_ms;
+        if(i && i + 1 < order.size() && rng() % 100 == 0){
+            ++dropped;
+            continue;
+        }
+        if(!push(jitter,order[i],now_ms)){
+            zlog_error("seq {} rejected",order[i]);
+            ++errors;
+        }
+        if(rng() % 50 == 0 && push(jitter,order[i],now_ms)){
+            zlog_error("duplicate seq {} accepted",order[i]);
+            ++errors;
+        }
+        errors += pop_all(jitter,now_ms,popped);
+    }
+    errors += pop_all(jitter,now_ms + TEST_DELAY_MS,popped);
+    if(popped.size() + dropped != order.size() || jitter.lost() != dropped || jitter.buffered()
+        || jitter.duplicated() == 0 || jitter.late()){
+        zlog_error("seed {}:popped {} dropped {} lost {} duplicated {} late {} buffered {}",seed,popped.size(),dropped,
+            jitter.lost(),jitter.duplicated(),jitter.late(),jitter.buffered());
+        ++errors;
+    }
+    return errors;
+}
+
+int main(int argc,char** argv){
+    zlog::logger::create_defaultLogger();
+    int errors = 0;
+
+    // ring and spare buffers fit the budget
+    {
+        static const size_t budgets[4] = {64 * TEST_MAX_PACKET,100 * TEST_MAX_PACKET,1024 * 1024,4 * 1024 * 1024};
+        for(size_t budget : budgets){
+            rtp_jitter_buffer jitter(budget,TEST_MAX_PACKET);
+            size_t slots = jitter.slots();
+            if((slots + 4) * TEST_MAX_PACKET > budget || (slots * 2 + 4) * TEST_MAX_PACKET <= budget){
+                zlog_error("budget {}:{} slots",budget,slots);
+                ++errors;
+            }
+        }
+        rtp_jitter_buffer tiny(100,TEST_MAX_PACKET);
+        if(tiny.slots() != 2){
+            zlog_error("tiny budget {} slots",tiny.slots());
+            ++errors;
+        }
+    }
+
+    // first packet held for reordered ones before it
+    {
+        rtp_jitter_buffer jitter(64 * TEST_MAX_PACKET,TEST_MAX_PACKET,TEST_DELAY_MS);
+        std::vector<uint16_t> popped;
+        push(jitter,102,0);
+        push(jitter,100,10);
+        push(jitter,101,20);
+        errors += pop_all(jitter,TEST_DELAY_MS - 1,popped);
+        if(!popped.empty()){
+            zlog_error("first packet popped before {} ms",TEST_DELAY_MS);
+            ++errors;
+        }
+        errors += pop_all(jitter,TEST_DELAY_MS,popped);
+        if(popped != std::vector<uint16_t>{100,101,102} || push(jitter,99,40) || jitter.late() != 1){
+            zlog_error("startup reorder popped {} packets,late {}",popped.size(),jitter.late());
+            ++errors;
+        }
+    }
+
+    // gap waited max_delay_ms since the packet after it,then lost
+    {
+        rtp_jitter_buffer jitter(64 * TEST_MAX_PACKET,TEST_MAX_PACKET,TEST_DELAY_MS);
+        std::vector<uint16_t> popped;
+        push(jitter,0,0);
+        errors += pop_all(jitter,TEST_DELAY_MS,popped);
+        push(jitter,2,100);
+        push(jitter,3,110);
+        errors += pop_all(jitter,100 + TEST_DELAY_MS - 1,popped);
+        if(popped.size() != 1 || jitter.lost()){
+            zlog_error("gap given up before {} ms",TEST_DELAY_MS);
+            ++errors;
+        }
+        errors += pop_all(jitter,100 + TEST_DELAY_MS,popped);
+        if(popped != std::vector<uint16_t>{0,2,3} || jitter.lost() != 1 || push(jitter,1,200) || jitter.late() != 1){
+            zlog_error("gap not given up:popped {} lost {}",popped.size(),jitter.lost());
+            ++errors;
+        }
+    }
+
+    // full ring is popped without waiting,nothing received is pushed out
+    {
+        rtp_jitter_buffer jitter(64 * TEST_MAX_PACKET,TEST_MAX_PACKET,TEST_DELAY_MS);
+        std::vector<uint16_t> popped;
+        size_t slots = jitter.slots();
+        for(size_t i = 0;i < slots * 2;i++){
+            // 1 missing in every 8
+            if(i % 8 != 1){
+                push(jitter,(uint16_t)(1000 + i),0);
+                errors += pop_all(jitter,0,popped);
+            }
+        }
+        size_t expect = slots * 2 - slots / 4;
+        if(popped.size() + jitter.buffered() != expect || jitter.buffered() > slots){
+            zlog_error("full ring popped {} buffered {},expect {}",popped.size(),jitter.buffered(),expect);
+            ++errors;
+        }
+    }
+
+    // nack after retry_ms missing,every retry_ms,at most max_retries
+    {
+        rtp_jitter_buffer jitter(64 * TEST_MAX_PACKET,TEST_MAX_PACKET,1000);
+        uint16_t seqs[16];
+        push(jitter,10,0);
+        push(jitter,11,0);
+        push(jitter,14,0);
+        push(jitter,16,0);
+        size_t count = jitter.nacks(0,seqs,16,50,2);
+        if(count){
+            zlog_error("{} nacks of just reordered packets",count);
+            ++errors;
+        }
+        count = jitter.nacks(49,seqs,16,50,2);
+        count += jitter.nacks(50,seqs + count,16 - count,50,2);
+        if(count != 3 || seqs[0] != 12 || seqs[1] != 13 || seqs[2] != 15){
+            zlog_error("first nacks {}",count);
+            ++errors;
+        }
+        // 13 received meanwhile
+        push(jitter,13,60);
+        count = jitter.nacks(99,seqs,16,50,2);
+        count += jitter.nacks(100,seqs + count,16 - count,50,2);
+        if(count != 2 || seqs[0] != 12 || seqs[1] != 15){
+            zlog_error("retry nacks {}",count);
+            ++errors;
+        }
+        count = jitter.nacks(1000,seqs,16,50,2);
+        if(count){
+            zlog_error("{} nacks over max retries",count);
+            ++errors;
+        }
+        // capped by max_count
+        push(jitter,30,1000);
+        jitter.nacks(1000,seqs,16,50,2);
+        count = jitter.nacks(1050,seqs,4,50,2);
+        if(count != 4 || seqs[0] != 17 || seqs[3] != 20){
+            zlog_error("{} nacks of max count 4",count);
+            ++errors;
+        }
+    }
+
+    // PID + BLP of following 16 seqs,wrap
+    {
+        static const uint16_t seqs[7] = {10,11,13,26,27,65535,0};
+        static const uint8_t expect[12] = {0x00,0x0a,0x80,0x05,0x00,0x1b,0x00,0x00,0xff,0xff,0x00,0x01};
+        uint8_t fci[7 * 4];
+        size_t size = rtcp_nack_fci(seqs,7,fci);
+        if(size != sizeof(expect) || memcmp(fci,expect,size) != 0){
+            zlog_error("nack fci {} bytes",size);
+            ++errors;
+        }
+        if(rtcp_nack_fci(seqs,0,fci) != 0){
+            zlog_error("nack fci of no seq");
+            ++errors;
+        }
+    }
+
+    for(uint32_t seed = 0;seed < 8;seed++){
+        errors += check_random(0x19 + seed);
+    }
+
+    if(errors){
+        zlog_error("{} rtp jitter errors",errors);
+        return 1;
+    }
+    zlog("rtp jitter checked");
+    return 0;
+}
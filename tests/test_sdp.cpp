@@ -0,0 +1,169 @@
+#include <zlog/log.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "zav/proto/sdp.h"
+
+/**
+ * sdp_parse of a camera like description(sprop-parameter-sets,aac config,
+ * static payload type),then generate -> parse round trip
+ */
+using namespace zav;
+
+// baseline 1280x720,vui timing 25 fps + pps
+static const char kSDP[] =
+    "v=0\r\n"
+    "o=- 1 1 IN IP4 10.0.0.1\r\n"
+    "s=cam\r\n"
+    "c=IN IP4 0.0.0.0\r\n"
+    "t=0 0\r\n"
+    "a=control:*\r\n"
+    "a=range:npt=0-\r\n"
+    "a=tool:camera\r\n"
+    "m=video 0 RTP/AVP 96\r\n"
+    "a=rtpmap:96 H264/90000\r\n"
+    "a=fmtp:96 packetization-mode=1; profile-level-id=42c01f; sprop-parameter-sets=Z0LAH9oBQBboQAAAAwBAAAAMoQ==,aM48gA==\r\n"
+    "a=control:trackID=0\r\n"
+    "m=audio 0 RTP/AVP 97\r\n"
+    "a=rtpmap:97 MPEG4-GENERIC/44100/2\r\n"
+    "a=fmtp:97 streamtype=5;profile-level-id=1;mode=AAC-hbr;sizelength=13;indexlength=3;indexdeltalength=3;config=1210\r\n"
+    "a=control:trackID=1\r\n"
+    "m=audio 0 RTP/AVP 8\r\n"
+    "a=control:trackID=2\r\n";
+
+static const uint8_t kSPS[19] = {0x67,0x42,0xc0,0x1f,0xda,0x01,0x40,0x16,0xe8,0x40,0x00,0x00,0x03,0x00,0x40,0x00,0x00,0x0c,0xa1};
+static const uint8_t kPPS[4] = {0x68,0xce,0x3c,0x80};
+
+static int check_video(const char* name,const sdp_media& media){
+    if(media.media != "video" || media.payload_type != 96 || media.codec != AV_CODEC_VIDEO_H264
+        || media.clock_rate != 90000 || media.packetization_mode != 1 || media.control != "trackID=0"){
+        zlog_error("{} video:pt {} codec {} clock {} mode {} control {}",name,media.payload_type,(int)media.codec,
+            media.clock_rate,media.packetization_mode,media.control);
+        return 1;
+    }
+    if(media.parameter_sets.size() != 2 || media.parameter_sets[0] != std::vector<uint8_t>(kSPS,kSPS + sizeof(kSPS))
+        || media.parameter_sets[1] != std::vector<uint8_t>(kPPS,kPPS + sizeof(kPPS))){
+        zlog_error("{} sprop-parameter-sets:{} nalus",name,media.parameter_sets.size());
+        return 1;
+    }
+    if(media.width != 1280 || media.height != 720 || media.fps != 25){
+        zlog_error("{} video {}x{} fps {}",name,media.width,media.height,media.fps);
+        return 1;
+    }
+    h264_param_cache cache;
+    if(!media.update_params(cache) || !cache.sps(0) || !cache.pps(0) || cache.sps_of_pps(0) != cache.sps(0)){
+        zlog_error("{} parameter sets not cached",name);
+        return 1;
+    }
+    return 0;
+}
+
+static int check_aac(const char* name,const sdp_media& media){
+    static const uint8_t config[2] = {0x12,0x10};
+    if(media.media != "audio" || media.payload_type != 97 || media.codec != AV_CDEOC_AUDIO_AAC
+        || media.clock_rate != 44100 || media.channels != 2 || media.control != "trackID=1"
+        || media.config != std::vector<uint8_t>(config,config + sizeof(config))){
+        zlog_error("{} aac:pt {} codec {} clock {} channels {} config {} bytes",name,media.payload_type,(int)media.codec,
+            media.clock_rate,media.channels,media.config.size());
+        return 1;
+    }
+    const std::string* mode = media.fmtp_value("MODE");
+    if(!mode || *mode != "AAC-hbr" || media.fmtp_value("sprop-parameter-sets")){
+        zlog_error("{} aac fmtp mode not found",name);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc,char** argv){
+    zlog::logger::create_defaultLogger();
+    int errors = 0;
+
+    sdp_session session;
+    if(!sdp_parse(kSDP,sizeof(kSDP) - 1,&session) || session.medias.size() != 3){
+        zlog_error("sdp not parsed,{} medias",session.medias.size());
+        return 1;
+    }
+    if(session.control != "*" || session.range != "npt=0-" || session.connection != "IN IP4 0.0.0.0" || session.name != "cam"){
+        zlog_error("session control {} range {} connection {} name {}",session.control,session.range,session.connection,session.name);
+        ++errors;
+    }
+    errors += check_video("parsed",session.medias[0]);
+    errors += check_aac("parsed",session.medias[1]);
+    // static payload type,no rtpmap
+    const sdp_media& pcma = session.medias[2];
+    if(pcma.payload_type != 8 || pcma.encoding != "PCMA" || pcma.codec != AV_CODEC_AUDIO_G711_ALAW
+        || pcma.clock_rate != 8000 || pcma.channels != 1 || pcma.control != "trackID=2"){
+        zlog_error("static payload type:pt {} encoding {} clock {} channels {}",pcma.payload_type,pcma.encoding,
+            pcma.clock_rate,pcma.channels);
+        ++errors;
+    }
+
+    // generate -> parse keeps every media
+    std::string text = sdp_generate(session);
+    sdp_session again;
+    if(!sdp_parse(text.data(),text.size(),&again) || again.medias.size() != 3){
+        zlog_error("generated sdp not parsed:\n{}",text);
+        return 1;
+    }
+    errors += check_video("regenerated",again.medias[0]);
+    errors += check_aac("regenerated",again.medias[1]);
+    if(again.medias[2].codec != AV_CODEC_AUDIO_G711_ALAW || again.medias[2].clock_rate != 8000 || again.control != "*"){
+        zlog_error("regenerated pcma codec {} clock {}",(int)again.medias[2].codec,again.medias[2].clock_rate);
+        ++errors;
+    }
+
+    // medias built from parameter sets and AudioSpecificConfig
+    {
+        sdp_session built;
+        built.control = "*";
+        built.medias.resize(2);
+        sdp_media_h26x(&built.medias[0],AV_CODEC_VIDEO_H264,96,session.medias[0].parameter_sets);
+        built.medias[0].control = "trackID=0";
+        sdp_media_aac(&built.medias[1],97,session.medias[1].config.data(),session.medias[1].config.size());
+        built.medias[1].control = "trackID=1";
+        text = sdp_generate(built);
+        sdp_session parsed;
+        if(!sdp_parse(text.data(),text.size(),&parsed) || parsed.medias.size() != 2){
+            zlog_error("built sdp not parsed:\n{}",text);
+            ++errors;
+        }else{
+            errors += check_video("built",parsed.medias[0]);
+            errors += check_aac("built",parsed.medias[1]);
+        }
+    }
+
+    // attributes of a malformed m= are not session attributes
+    {
+        static const char kBadMedia[] =
+            "v=0\r\n"
+            "s=bad\r\n"
+            "a=control:*\r\n"
+            "m=video 0\r\n"
+            "a=control:trackID=0\r\n"
+            "a=rtpmap:96 H264/90000\r\n"
+            "c=IN IP4 10.0.0.2\r\n"
+            "m=audio 0 RTP/AVP 8\r\n"
+            "a=control:trackID=1\r\n";
+        sdp_session bad;
+        if(!sdp_parse(kBadMedia,sizeof(kBadMedia) - 1,&bad) || bad.medias.size() != 1 || bad.control != "*"
+            || !bad.attributes.empty() || !bad.connection.empty() || bad.medias[0].control != "trackID=1"){
+            zlog_error("malformed m= section:{} medias,control {},{} attributes",bad.medias.size(),bad.control,
+                bad.attributes.size());
+            ++errors;
+        }
+    }
+
+    static const char kNoMedia[] = "v=0\r\ns=empty\r\n";
+    if(sdp_parse(kNoMedia,sizeof(kNoMedia) - 1,&session)){
+        zlog_error("sdp without m= parsed");
+        ++errors;
+    }
+
+    if(errors){
+        zlog_error("{} sdp errors",errors);
+        return 1;
+    }
+    zlog("sdp checked");
+    return 0;
+}
@@ -0,0 +1,222 @@
+#include <zlog/log.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include "zcf/io/net.h"
+#if defined(Z_SYS_LINUX)
+#include <arpa/inet.h>
+#include <poll.h>
+#endif
+
+/**
+ * udp_socket on loopback:send_batch/recv_batch contents and source address,
+ * SO_TIMESTAMPNS,UDP_SEGMENT datagrams split back from UDP_GRO
+ */
+#if defined(Z_SYS_LINUX)
+using namespace zcf::io;
+
+#define TEST_PACKET_COUNT 100
+
+struct received_datagram{
+    std::vector<uint8_t> bytes;
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    uint64_t timestamp_ns;
+};
+
+/**
+ * receive until count datagrams or 1s,coalesced packets are split to datagrams
+ */
+static std::vector<received_datagram> receive(udp_socket& socket,size_t count,size_t* coalesced = nullptr){
+    std::vector<received_datagram> datagrams;
+    while(datagrams.size() < count){
+        int n = socket.recv_batch();
+        if(n < 0){
+            zlog_error("recv_batch failed:{}",strerror(errno));
+            break;
+        }
+        if(n == 0){
+            struct pollfd fd = {socket.fd(),POLLIN,0};
+            if(::poll(&fd,1,1000) <= 0){
+                break;
+            }
+            continue;
+        }
+        for(int i = 0;i < n;i++){
+            const udp_packet& packet = socket.packet(i);
+            if(coalesced && packet.segment_count() > 1){
+                ++*coalesced;
+            }
+            for(size_t k = 0;k < packet.segment_count();k++){
+                uint8_t* data = nullptr;
+                size_t size = packet.segment(k,&data);
+                received_datagram datagram;
+                datagram.bytes.assign(data,data + size);
+                memcpy(&datagram.addr,&packet.addr,sizeof(packet.addr));
+                datagram.addr_len = packet.addr_len;
+                datagram.timestamp_ns = packet.timestamp_ns;
+                datagrams.push_back(datagram);
+            }
+        }
+    }
+    return datagrams;
+}
+
+static bool open_loopback(udp_socket& socket,int family,struct sockaddr_storage* addr,socklen_t* addr_len){
+    memset(addr,0,sizeof(*addr));
+    if(family == AF_INET){
+        struct sockaddr_in* in = (struct sockaddr_in*)addr;
+        in->sin_family = AF_INET;
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        *addr_len = sizeof(struct sockaddr_in);
+    }else{
+        struct sockaddr_in6* in6 = (struct sockaddr_in6*)addr;
+        in6->sin6_family = AF_INET6;
+        in6->sin6_addr = in6addr_loopback;
+        *addr_len = sizeof(struct sockaddr_in6);
+    }
+    // bound port
+    return socket.open((const struct sockaddr*)addr,*addr_len) && ::getsockname(socket.fd(),(struct sockaddr*)addr,addr_len) == 0;
+}
+
+static uint16_t port_of(const struct sockaddr_storage& addr){
+    return ntohs(addr.ss_family == AF_INET ? ((const struct sockaddr_in&)addr).sin_port : ((const struct sockaddr_in6&)addr).sin6_port);
+}
+
+/**
+ * packet i is 12 bytes header of i + 100 + i bytes body,sent as 2 iov
+ */
+static int check_batch(int family,bool timestamp){
+    const char* name = family == AF_INET ? "ipv4" : "ipv6";
+    udp_socket rx(32,1500),tx(32,1500);
+    struct sockaddr_storage rx_addr,tx_addr;
+    socklen_t rx_len = 0,tx_len = 0;
+    if(!open_loopback(rx,family,&rx_addr,&rx_len) || !open_loopback(tx,family,&tx_addr,&tx_len)){
+        if(family == AF_INET6){
+            zlog_warn("no ipv6 loopback,skipped");
+            return 0;
+        }
+        zlog_error("{} open failed:{}",name,strerror(errno));
+        return 1;
+    }
+    if(timestamp && !rx.enable_timestamp()){
+        zlog_error("{} SO_TIMESTAMPNS failed",name);
+        return 1;
+    }
+
+    std::vector<std::vector<uint8_t>> headers(TEST_PACKET_COUNT),bodies(TEST_PACKET_COUNT);
+    std::vector<struct iovec> iov(TEST_PACKET_COUNT * 2);
+    std::vector<udp_send_packet> packets(TEST_PACKET_COUNT);
+    for(size_t i = 0;i < TEST_PACKET_COUNT;i++){
+        headers[i].assign(12,(uint8_t)i);
+        bodies[i].assign(100 + i,(uint8_t)(i * 7 + 1));
+        iov[i * 2].iov_base = headers[i].data();
+        iov[i * 2].iov_len = headers[i].size();
+        iov[i * 2 + 1].iov_base = bodies[i].data();
+        iov[i * 2 + 1].iov_len = bodies[i].size();
+        packets[i].iov = &iov[i * 2];
+        packets[i].iov_count = 2;
+        packets[i].addr = (const struct sockaddr*)&rx_addr;
+        packets[i].addr_len = rx_len;
+        packets[i].segment_size = 0;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME,&now);
+    uint64_t sent_ns = (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+    int sent = tx.send_batch(packets.data(),packets.size());
+    if(sent != TEST_PACKET_COUNT){
+        zlog_error("{} sent {} of {}",name,sent,TEST_PACKET_COUNT);
+        return 1;
+    }
+
+    std::vector<received_datagram> datagrams = receive(rx,TEST_PACKET_COUNT);
+    if(datagrams.size() != TEST_PACKET_COUNT){
+        zlog_error("{} received {} of {}",name,datagrams.size(),TEST_PACKET_COUNT);
+        return 1;
+    }
+    for(size_t i = 0;i < datagrams.size();i++){
+        const received_datagram& d = datagrams[i];
+        std::vector<uint8_t> expect = headers[i];
+        expect.insert(expect.end(),bodies[i].begin(),bodies[i].end());
+        if(d.bytes != expect){
+            zlog_error("{} datagram {}:{} bytes,expect {}",name,i,d.bytes.size(),expect.size());
+            return 1;
+        }
+        if(d.addr_len != tx_len || d.addr.ss_family != family || port_of(d.addr) != port_of(tx_addr)){
+            zlog_error("{} datagram {} source:addr_len {} family {} port {}",name,i,d.addr_len,d.addr.ss_family,port_of(d.addr));
+            return 1;
+        }
+        // kernel receive time,after send started and not in the future
+        clock_gettime(CLOCK_REALTIME,&now);
+        uint64_t now_ns = (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+        if(timestamp ? d.timestamp_ns < sent_ns || d.timestamp_ns > now_ns : d.timestamp_ns != 0){
+            zlog_error("{} datagram {} timestamp {},sent at {}",name,i,d.timestamp_ns,sent_ns);
+            return 1;
+        }
+    }
+    zlog("{} {} datagrams checked,timestamp {}",name,datagrams.size(),timestamp);
+    return 0;
+}
+
+/**
+ * one UDP_SEGMENT send of 500 bytes segments,received coalesced by UDP_GRO
+ * or as datagrams,both split back to the same segments
+ */
+static int check_segment(){
+    udp_socket rx(8,1500),tx(8,1500);
+    struct sockaddr_storage rx_addr,tx_addr;
+    socklen_t rx_len = 0,tx_len = 0;
+    if(!open_loopback(rx,AF_INET,&rx_addr,&rx_len) || !open_loopback(tx,AF_INET,&tx_addr,&tx_len)){
+        zlog_error("segment open failed:{}",strerror(errno));
+        return 1;
+    }
+    bool gro = rx.enable_gro();
+    std::vector<uint8_t> bytes(1400);
+    for(size_t i = 0;i < bytes.size();i++){
+        bytes[i] = (uint8_t)(i / 500 + i);
+    }
+    struct iovec iov[2] = {{bytes.data(),700},{bytes.data() + 700,700}};
+    udp_send_packet packet = {iov,2,(const struct sockaddr*)&rx_addr,rx_len,500};
+    int sent = tx.send_batch(&packet,1);
+    if(sent != 1){
+        zlog_warn("UDP_SEGMENT not supported({}),skipped",strerror(errno));
+        return 0;
+    }
+    size_t coalesced = 0;
+    std::vector<received_datagram> datagrams = receive(rx,3,&coalesced);
+    if(datagrams.size() != 3 || (gro && coalesced != 1)){
+        zlog_error("segment received {} datagrams,{} coalesced",datagrams.size(),coalesced);
+        return 1;
+    }
+    for(size_t k = 0;k < 3;k++){
+        size_t size = k < 2 ? 500 : 400;
+        if(datagrams[k].bytes.size() != size || memcmp(datagrams[k].bytes.data(),bytes.data() + k * 500,size) != 0
+            || datagrams[k].addr_len != tx_len){
+            zlog_error("segment {}:{} bytes",k,datagrams[k].bytes.size());
+            return 1;
+        }
+    }
+    zlog("segments checked,gro {}",gro);
+    return 0;
+}
+#endif
+
+int main(int argc,char** argv){
+    zlog::logger::create_defaultLogger();
+    int errors = 0;
+#if defined(Z_SYS_LINUX)
+    errors += check_batch(AF_INET,false);
+    errors += check_batch(AF_INET,true);
+    errors += check_batch(AF_INET6,true);
+    errors += check_segment();
+#else
+    zlog("batched udp is linux only");
+#endif
+    if(errors){
+        zlog_error("{} udp errors",errors);
+        return 1;
+    }
+    zlog("udp checked");
+    return 0;
+}